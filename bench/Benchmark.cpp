@@ -0,0 +1,120 @@
+#include "Benchmark.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <ctime>
+
+BenchState::BenchState(uint64_t iterations)
+    : iterations(iterations), remaining(iterations), itemsProcessed(0), bytesProcessed(0),
+      pausedTime(std::chrono::steady_clock::duration::zero()) {
+}
+
+void BenchState::start() {
+    startTime = std::chrono::steady_clock::now();
+}
+
+void BenchState::pauseTiming() {
+    pauseStart = std::chrono::steady_clock::now();
+}
+
+void BenchState::resumeTiming() {
+    pausedTime += std::chrono::steady_clock::now() - pauseStart;
+}
+
+double BenchState::elapsedSeconds() const {
+    auto elapsed = std::chrono::steady_clock::now() - startTime - pausedTime;
+    return std::chrono::duration<double>(elapsed).count();
+}
+
+std::vector<BenchRegistry::Entry>& BenchRegistry::entries() {
+    static std::vector<Entry> registered;
+    return registered;
+}
+
+void BenchRegistry::add(const std::string& name, std::function<void(BenchState&)> body) {
+    entries().push_back({name, std::move(body)});
+}
+
+std::vector<BenchResult> BenchRegistry::runAll(const std::string& filter, double minSeconds) {
+    std::vector<BenchResult> results;
+    
+    for (auto& entry : entries()) {
+        if (!filter.empty() && entry.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        
+        uint64_t iterations = 1;
+        while (true) {
+            BenchState state(iterations);
+            state.start();
+            entry.body(state);
+            double seconds = state.elapsedSeconds();
+            
+            if (seconds >= minSeconds || iterations >= (1ull << 32)) {
+                BenchResult result;
+                result.name = entry.name;
+                result.iterations = iterations;
+                result.nsPerOp = seconds * 1e9 / static_cast<double>(iterations);
+                result.itemsPerSecond = seconds > 0 ? state.getItemsProcessed() / seconds : 0.0;
+                result.bytesPerSecond = seconds > 0 ? state.getBytesProcessed() / seconds : 0.0;
+                results.push_back(result);
+                break;
+            }
+            
+            // Grow towards the target time, at most 10x per step
+            double scale = seconds > 0 ? (minSeconds * 1.4) / seconds : 10.0;
+            if (scale > 10.0) scale = 10.0;
+            if (scale < 2.0) scale = 2.0;
+            iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+        }
+    }
+    
+    return results;
+}
+
+void BenchRegistry::printTable(const std::vector<BenchResult>& results, std::ostream& out) {
+    out << std::left << std::setw(48) << "Benchmark"
+        << std::right << std::setw(14) << "ns/op"
+        << std::setw(14) << "iterations"
+        << std::setw(16) << "items/s" << "\n";
+    out << std::string(92, '-') << "\n";
+    
+    for (const auto& r : results) {
+        out << std::left << std::setw(48) << r.name
+            << std::right << std::setw(14) << std::fixed << std::setprecision(1) << r.nsPerOp
+            << std::setw(14) << r.iterations
+            << std::setw(16) << std::setprecision(0) << r.itemsPerSecond << "\n";
+    }
+}
+
+void BenchRegistry::writeJson(const std::vector<BenchResult>& results, std::ostream& out) {
+    auto now = std::time(nullptr);
+    char dateBuffer[32];
+    std::strftime(dateBuffer, sizeof(dateBuffer), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    
+    // Layout follows Google Benchmark's JSON so existing compare tooling can read it
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << dateBuffer << "\",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n  \"benchmarks\": [\n";
+    
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\n"
+            << "      \"name\": \"" << r.name << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << r.iterations << ",\n"
+            << "      \"real_time\": " << std::setprecision(3) << std::fixed << r.nsPerOp << ",\n"
+            << "      \"cpu_time\": " << r.nsPerOp << ",\n"
+            << "      \"time_unit\": \"ns\",\n"
+            << "      \"items_per_second\": " << r.itemsPerSecond << ",\n"
+            << "      \"bytes_per_second\": " << r.bytesPerSecond << "\n"
+            << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    
+    out << "  ]\n}\n";
+}
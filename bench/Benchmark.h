@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <chrono>
+
+// Per-run state handed to a benchmark body.
+// The body loops with `while (state.next()) { ... }` and may report throughput.
+class BenchState {
+private:
+    uint64_t iterations;
+    uint64_t remaining;
+    uint64_t itemsProcessed;
+    uint64_t bytesProcessed;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::duration pausedTime;
+    std::chrono::steady_clock::time_point pauseStart;
+    
+public:
+    explicit BenchState(uint64_t iterations);
+    
+    bool next() {
+        if (remaining == 0) return false;
+        --remaining;
+        return true;
+    }
+    
+    // Exclude setup work inside the loop from the measurement
+    void pauseTiming();
+    void resumeTiming();
+    
+    void setItemsProcessed(uint64_t items) { itemsProcessed = items; }
+    void setBytesProcessed(uint64_t bytes) { bytesProcessed = bytes; }
+    
+    uint64_t getIterations() const { return iterations; }
+    uint64_t getItemsProcessed() const { return itemsProcessed; }
+    uint64_t getBytesProcessed() const { return bytesProcessed; }
+    
+    void start();
+    double elapsedSeconds() const;
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double itemsPerSecond;
+    double bytesPerSecond;
+};
+
+class BenchRegistry {
+private:
+    struct Entry {
+        std::string name;
+        std::function<void(BenchState&)> body;
+    };
+    
+    static std::vector<Entry>& entries();
+    
+public:
+    static void add(const std::string& name, std::function<void(BenchState&)> body);
+    
+    // Runs every benchmark whose name contains `filter`, growing the iteration
+    // count until a single run takes at least `minSeconds`.
+    static std::vector<BenchResult> runAll(const std::string& filter, double minSeconds);
+    
+    static void printTable(const std::vector<BenchResult>& results, std::ostream& out);
+    static void writeJson(const std::vector<BenchResult>& results, std::ostream& out);
+};
+
+// Prevents the optimizer from discarding a computed value
+template <typename T>
+inline void benchDoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
@@ -0,0 +1,776 @@
+#include "Benchmark.h"
+#include "../server/Server.h"
+#include "../server/Client.h"
+#include "../server/World.h"
+#include "../server/AccountStore.h"
+#include "../server/UdpTransport.h"
+#include "../protocol/Packet.h"
+#include "../utils/Logger.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+#ifndef _WIN32
+    #include <poll.h>
+    #include <arpa/inet.h>
+#endif
+
+#ifdef __linux__
+    #include "../server/ShmRing.h"
+#endif
+
+// Discards everything written to it; the server logs on every packet and
+// console I/O would otherwise dominate the measurements.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Access to Server internals for the dispatch and fan-out benchmarks
+class ServerBench {
+public:
+    static void addClient(Server& server, std::shared_ptr<Client> client) {
+        std::lock_guard<std::mutex> lock(server.clientsMutex);
+        server.clients.push_back(client);
+    }
+    
+    static void handleStringPacket(Server& server, std::shared_ptr<Client> client, const std::string& message) {
+        server.handleStringPacket(client, message);
+    }
+    
+    static void handleUpdatePacket(Server& server, std::shared_ptr<Client> client, const GamePacket& packet) {
+        server.handleUpdatePacket(client, packet);
+    }
+};
+
+#ifndef _WIN32
+// Connected socket pairs whose far ends are drained by a background thread,
+// so Client::sendPacket never blocks on a full socket buffer.
+class LoopbackClients {
+private:
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<int> peers;
+    std::atomic<bool> draining;
+    std::thread drainThread;
+    
+    void drain() {
+        std::vector<pollfd> fds;
+        for (int fd : peers) {
+            fds.push_back({fd, POLLIN, 0});
+        }
+        
+        char buffer[64 * 1024];
+        while (draining) {
+            if (poll(fds.data(), fds.size(), 50) <= 0) continue;
+            for (auto& p : fds) {
+                if (p.revents & POLLIN) {
+                    while (recv(p.fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {}
+                }
+            }
+        }
+    }
+    
+public:
+    explicit LoopbackClients(size_t count) : draining(true) {
+        for (size_t i = 0; i < count; ++i) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                throw std::runtime_error("socketpair failed");
+            }
+            auto client = std::make_shared<Client>(pair[0], "127.0.0.1");
+            client->setPlayerName("Bench_" + std::to_string(i));
+            client->setPlayerID(static_cast<int>(i));
+            clients.push_back(client);
+            peers.push_back(pair[1]);
+        }
+        drainThread = std::thread(&LoopbackClients::drain, this);
+    }
+    
+    ~LoopbackClients() {
+        draining = false;
+        drainThread.join();
+        for (auto& client : clients) {
+            client->disconnect();
+        }
+        for (int fd : peers) {
+            close(fd);
+        }
+    }
+    
+    const std::vector<std::shared_ptr<Client>>& get() const { return clients; }
+};
+#endif
+
+static GamePacket sampleMovement() {
+    GamePacket packet;
+    packet.type = PacketType::UPDATE_PACKET;
+    packet.objtype = 0;
+    packet.netid = 42;
+    packet.vec_x = 1024.0f;
+    packet.vec_y = 768.0f;
+    packet.state = 0x20;
+    return packet;
+}
+
+static const std::string kHandshake =
+    "requestedName|BenchUser\nf|1\nprotocol|171\ngame_version|4.54\nfz|12345678\ncbits|0\nplayer_age|20\n"
+    "GDPR|1\nhash2|0\nmeta|localhost\nfhash|-716928004\nrid|0123456789ABCDEF\nplatformID|0\ndeviceVersion|0\n"
+    "country|us\nhash|0\nmac|02:00:00:00:00:00\nwk|NONE0\nzf|-1331849031";
+
+static void registerProtocolBenchmarks() {
+    BenchRegistry::add("PacketBuilder::createStringPacket/short", [](BenchState& state) {
+        std::string message = "action|log\nmsg|Hello";
+        while (state.next()) {
+            auto packet = PacketBuilder::createStringPacket(message);
+            benchDoNotOptimize(packet);
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setBytesProcessed(state.getIterations() * message.size());
+    });
+    
+    BenchRegistry::add("PacketBuilder::createStringPacket/handshake", [](BenchState& state) {
+        while (state.next()) {
+            auto packet = PacketBuilder::createStringPacket(kHandshake);
+            benchDoNotOptimize(packet);
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setBytesProcessed(state.getIterations() * kHandshake.size());
+    });
+    
+    BenchRegistry::add("PacketBuilder::createUpdatePacket", [](BenchState& state) {
+        GamePacket movement = sampleMovement();
+        while (state.next()) {
+            auto packet = PacketBuilder::createUpdatePacket(movement);
+            benchDoNotOptimize(packet);
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    BenchRegistry::add("PacketBuilder::parsePacket/string", [](BenchState& state) {
+        auto raw = PacketBuilder::createStringPacket(kHandshake);
+        while (state.next()) {
+            GamePacket packet = PacketBuilder::parsePacket(raw);
+            benchDoNotOptimize(packet);
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setBytesProcessed(state.getIterations() * raw.size());
+    });
+    
+    BenchRegistry::add("PacketBuilder::parsePacket/update", [](BenchState& state) {
+        auto raw = PacketBuilder::createUpdatePacket(sampleMovement());
+        while (state.next()) {
+            GamePacket packet = PacketBuilder::parsePacket(raw);
+            benchDoNotOptimize(packet);
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setBytesProcessed(state.getIterations() * raw.size());
+    });
+}
+
+#ifndef _WIN32
+static void registerServerBenchmarks() {
+    struct DispatchCase {
+        const char* name;
+        std::string message;
+    };
+    
+    static const std::vector<DispatchCase> dispatchCases = {
+        {"handshake", kHandshake},
+        {"login", "action|login\n"},
+        {"join_request", "action|join_request\nname|START\ninvitedWorld|0"},
+        {"chat", "Hello everyone!"},
+    };
+    
+    for (const auto& dispatchCase : dispatchCases) {
+        std::string message = dispatchCase.message;
+        BenchRegistry::add(std::string("Server::handleStringPacket/") + dispatchCase.name, [message](BenchState& state) {
+            Server server(0);
+            LoopbackClients clients(2);
+            for (auto& client : clients.get()) {
+                ServerBench::addClient(server, client);
+            }
+            auto sender = clients.get().front();
+            
+            while (state.next()) {
+                ServerBench::handleStringPacket(server, sender, message);
+            }
+            state.setItemsProcessed(state.getIterations());
+        });
+    }
+    
+    BenchRegistry::add("Server::handleUpdatePacket/clients:16", [](BenchState& state) {
+        Server server(0);
+        LoopbackClients clients(16);
+        for (auto& client : clients.get()) {
+            ServerBench::addClient(server, client);
+        }
+        auto sender = clients.get().front();
+        GamePacket movement = sampleMovement();
+        
+        while (state.next()) {
+            ServerBench::handleUpdatePacket(server, sender, movement);
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    for (size_t count : {1, 8, 64, 256}) {
+        BenchRegistry::add("Server::broadcastPacket/clients:" + std::to_string(count), [count](BenchState& state) {
+            Server server(0);
+            LoopbackClients clients(count);
+            for (auto& client : clients.get()) {
+                ServerBench::addClient(server, client);
+            }
+            auto packet = PacketBuilder::createUpdatePacket(sampleMovement());
+            
+            while (state.next()) {
+                server.broadcastPacket(packet);
+            }
+            // One item per delivered packet
+            state.setItemsProcessed(state.getIterations() * count);
+        });
+    }
+    
+    // A crowded world: players spread over a 100x60 tile area
+    for (bool nearby : {false, true}) {
+        std::string name = nearby ? "World::broadcastNearby/players:256" : "World::broadcast/players:256";
+        BenchRegistry::add(name, [nearby](BenchState& state) {
+            WorkerPool pool(1);
+            World world("BENCH", pool, 32.0f * 32.0f);
+            LoopbackClients clients(256);
+            for (size_t i = 0; i < clients.get().size(); ++i) {
+                float x = static_cast<float>((i * 37) % 100) * 32.0f;
+                float y = static_cast<float>((i * 11) % 60) * 32.0f;
+                world.addPlayer(clients.get()[i], x, y);
+            }
+            auto sender = clients.get().front();
+            auto packet = PacketBuilder::createUpdatePacket(sampleMovement());
+            
+            while (state.next()) {
+                if (nearby) {
+                    world.broadcastNearby(packet, 1600.0f, 960.0f, sender);
+                } else {
+                    world.broadcast(packet, sender);
+                }
+            }
+            state.setItemsProcessed(state.getIterations());
+        });
+    }
+}
+#endif
+
+#ifdef __linux__
+// Moving one frame to another process and back out: shared-memory ring
+// versus a Unix socket, both written and read on this thread
+static void registerIpcBenchmarks() {
+    for (size_t size : {64, 1024, 16384}) {
+        BenchRegistry::add("ShmRing::write+read/bytes:" + std::to_string(size), [size](BenchState& state) {
+            auto ring = ShmRing::create(1024 * 1024, ShmRing::Producers::SINGLE);
+            std::vector<uint8_t> frame(size, 0x5a);
+            uint64_t checksum = 0;
+            while (state.next()) {
+                ring->tryWrite(frame.data(), frame.size());
+                ring->tryRead([&checksum](const uint8_t* data, uint32_t length) {
+                    checksum += data[length - 1];
+                });
+            }
+            benchDoNotOptimize(checksum);
+            state.setItemsProcessed(state.getIterations());
+            state.setBytesProcessed(state.getIterations() * size);
+        });
+        
+        BenchRegistry::add("ShmRing::write+read/producers:multiple/bytes:" + std::to_string(size), [size](BenchState& state) {
+            auto ring = ShmRing::create(1024 * 1024, ShmRing::Producers::MULTIPLE);
+            std::vector<uint8_t> frame(size, 0x5a);
+            uint64_t checksum = 0;
+            while (state.next()) {
+                ring->tryWrite(frame.data(), frame.size());
+                ring->tryRead([&checksum](const uint8_t* data, uint32_t length) {
+                    checksum += data[length - 1];
+                });
+            }
+            benchDoNotOptimize(checksum);
+            state.setItemsProcessed(state.getIterations());
+            state.setBytesProcessed(state.getIterations() * size);
+        });
+        
+        BenchRegistry::add("socketpair::send+recv/bytes:" + std::to_string(size), [size](BenchState& state) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                throw std::runtime_error("socketpair failed");
+            }
+            std::vector<uint8_t> frame(size + sizeof(uint32_t), 0x5a);
+            std::vector<uint8_t> received(frame.size());
+            while (state.next()) {
+                send(pair[0], frame.data(), frame.size(), 0);
+                recv(pair[1], received.data(), received.size(), MSG_WAITALL);
+            }
+            benchDoNotOptimize(received[0]);
+            close(pair[0]);
+            close(pair[1]);
+            state.setItemsProcessed(state.getIterations());
+            state.setBytesProcessed(state.getIterations() * size);
+        });
+    }
+}
+#endif
+
+#ifndef _WIN32
+// Just enough of an ENet client to drive UdpTransport over loopback: the
+// handshake, reliable and fragmented sends on channel 0, and acknowledging
+// whatever the server wants acknowledged. No checksum and no resending;
+// a reply that never comes is an error.
+class EnetLoopbackClient {
+private:
+    static const uint16_t NO_PEER = 0x0FFF;
+    static const int REPLY_TIMEOUT_MS = 2000;
+
+    int fd;
+    uint16_t peerID;            // Our slot on the server
+    uint8_t sessionID;
+    uint32_t mtu;
+    uint32_t connectID;
+    uint16_t outgoingReliable;
+    uint16_t incomingReliable;
+
+    static void put16(std::vector<uint8_t>& out, uint16_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void put32(std::vector<uint8_t>& out, uint32_t value) {
+        put16(out, static_cast<uint16_t>(value >> 16));
+        put16(out, static_cast<uint16_t>(value));
+    }
+
+    static uint16_t get16(const uint8_t* data) {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    static uint32_t get32(const uint8_t* data) {
+        return (static_cast<uint32_t>(get16(data)) << 16) | get16(data + 2);
+    }
+
+    std::vector<uint8_t> header() const {
+        std::vector<uint8_t> datagram;
+        put16(datagram, static_cast<uint16_t>(peerID | (sessionID << 12) | 0x8000));
+        put16(datagram, 0);
+        return datagram;
+    }
+
+    void send(const std::vector<uint8_t>& datagram) {
+        if (::send(fd, datagram.data(), datagram.size(), 0) != static_cast<ssize_t>(datagram.size())) {
+            throw std::runtime_error("UDP loopback: send failed");
+        }
+    }
+
+    // Reads one datagram, hands each command to `handle` and acknowledges
+    // the ones that ask for it
+    template <typename Handler>
+    void receive(Handler&& handle) {
+        static const size_t COMMAND_SIZES[13] = {0, 8, 48, 44, 8, 4, 6, 8, 24, 8, 12, 16, 24};
+
+        pollfd ready{fd, POLLIN, 0};
+        if (poll(&ready, 1, REPLY_TIMEOUT_MS) <= 0) {
+            throw std::runtime_error("UDP loopback: no reply from the server");
+        }
+        uint8_t buffer[4096];
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 4 || !(get16(buffer) & 0x8000)) {
+            throw std::runtime_error("UDP loopback: malformed datagram");
+        }
+        uint16_t sentTime = get16(buffer + 2);
+
+        std::vector<uint8_t> acknowledgements;
+        size_t offset = 4;
+        while (offset < static_cast<size_t>(received)) {
+            const uint8_t* command = buffer + offset;
+            uint8_t number = command[0] & 0x0F;
+            if (number == 0 || number >= 13 || offset + COMMAND_SIZES[number] > static_cast<size_t>(received)) {
+                throw std::runtime_error("UDP loopback: malformed command");
+            }
+            size_t size = COMMAND_SIZES[number];
+            if (number == 6) {
+                size += get16(command + 4);
+            } else if (number == 7 || number == 8 || number == 9 || number == 12) {
+                size += get16(command + 6);
+            }
+            if (offset + size > static_cast<size_t>(received)) {
+                throw std::runtime_error("UDP loopback: truncated command");
+            }
+
+            if (command[0] & 0x80) {
+                acknowledgements.push_back(1);
+                acknowledgements.push_back(command[1]);
+                put16(acknowledgements, 0);
+                put16(acknowledgements, get16(command + 2));
+                put16(acknowledgements, sentTime);
+            }
+            handle(command, size);
+            offset += size;
+        }
+
+        // Built after handling, so a VERIFY_CONNECT's acknowledgement
+        // already carries the slot it assigned
+        if (!acknowledgements.empty()) {
+            std::vector<uint8_t> datagram = header();
+            datagram.insert(datagram.end(), acknowledgements.begin(), acknowledgements.end());
+            send(datagram);
+        }
+    }
+
+public:
+    explicit EnetLoopbackClient(int port)
+        : fd(-1), peerID(NO_PEER), sessionID(0), mtu(1400), connectID(0), outgoingReliable(0), incomingReliable(0) {
+        fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || ::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+            throw std::runtime_error("UDP loopback: socket failed");
+        }
+    }
+
+    ~EnetLoopbackClient() {
+        close(fd);
+    }
+
+    EnetLoopbackClient(const EnetLoopbackClient&) = delete;
+    EnetLoopbackClient& operator=(const EnetLoopbackClient&) = delete;
+
+    // CONNECT, then wait for VERIFY_CONNECT and acknowledge it
+    void connect() {
+        peerID = NO_PEER;
+        sessionID = 0;
+        outgoingReliable = 0;
+        incomingReliable = 0;
+
+        std::vector<uint8_t> datagram = header();
+        datagram.push_back(0x82);       // CONNECT, acknowledged
+        datagram.push_back(0xFF);       // Control channel
+        put16(datagram, 1);
+        put16(datagram, 0);             // Our own peer ID
+        datagram.push_back(0);          // Sessions as after an earlier connection; the
+        datagram.push_back(1);          // server's two replies differ, so a swap shows
+        put32(datagram, 1400);          // MTU
+        put32(datagram, 32768);         // Window
+        put32(datagram, 2);             // Channels
+        put32(datagram, 0);             // Incoming bandwidth
+        put32(datagram, 0);             // Outgoing bandwidth
+        put32(datagram, 5000);          // Throttle interval, acceleration, deceleration
+        put32(datagram, 2);
+        put32(datagram, 2);
+        put32(datagram, ++connectID);
+        put32(datagram, 0);             // Connect data
+        send(datagram);
+
+        bool verified = false;
+        while (!verified) {
+            receive([&](const uint8_t* command, size_t) {
+                if ((command[0] & 0x0F) == 3) {
+                    peerID = get16(command + 4);
+                    sessionID = command[7];     // Its incoming session is our outgoing one
+                    mtu = get32(command + 8);
+                    verified = true;
+                }
+            });
+        }
+    }
+
+    // One frame on channel 0, fragmented if it doesn't fit the MTU
+    void sendFrame(const std::vector<uint8_t>& frame) {
+        size_t room = mtu - 4;
+        if (frame.size() + 6 <= room) {
+            std::vector<uint8_t> datagram = header();
+            datagram.push_back(0x86);   // SEND_RELIABLE, acknowledged
+            datagram.push_back(0);
+            put16(datagram, ++outgoingReliable);
+            put16(datagram, static_cast<uint16_t>(frame.size()));
+            datagram.insert(datagram.end(), frame.begin(), frame.end());
+            send(datagram);
+            return;
+        }
+
+        size_t fragmentLength = room - 24;
+        uint32_t fragmentCount = static_cast<uint32_t>((frame.size() + fragmentLength - 1) / fragmentLength);
+        uint16_t startSequence = static_cast<uint16_t>(outgoingReliable + 1);
+        for (uint32_t fragment = 0; fragment < fragmentCount; ++fragment) {
+            size_t offset = fragment * fragmentLength;
+            size_t length = std::min(fragmentLength, frame.size() - offset);
+
+            std::vector<uint8_t> datagram = header();
+            datagram.push_back(0x88);   // SEND_FRAGMENT, acknowledged
+            datagram.push_back(0);
+            put16(datagram, ++outgoingReliable);
+            put16(datagram, startSequence);
+            put16(datagram, static_cast<uint16_t>(length));
+            put32(datagram, fragmentCount);
+            put32(datagram, fragment);
+            put32(datagram, static_cast<uint32_t>(frame.size()));
+            put32(datagram, static_cast<uint32_t>(offset));
+            datagram.insert(datagram.end(), frame.begin() + offset, frame.begin() + offset + length);
+            send(datagram);
+        }
+    }
+
+    // Waits for the next reliable frame on channel 0, reassembling fragments
+    std::vector<uint8_t> receiveFrame() {
+        std::vector<uint8_t> frame;
+        uint32_t fragmentsLeft = 0;
+        bool complete = false;
+        while (!complete) {
+            receive([&](const uint8_t* command, size_t size) {
+                uint8_t number = command[0] & 0x0F;
+                if (complete || command[1] != 0 || (number != 6 && number != 8)) {
+                    return;
+                }
+                uint16_t sequence = get16(command + 2);
+                if (sequence != static_cast<uint16_t>(incomingReliable + 1)) {
+                    return; // Resent
+                }
+                incomingReliable = sequence;
+
+                if (number == 6) {
+                    frame.assign(command + 6, command + size);
+                    complete = true;
+                    return;
+                }
+                uint32_t totalLength = get32(command + 16);
+                uint32_t offset = get32(command + 20);
+                if (get32(command + 12) == 0) {
+                    frame.assign(totalLength, 0);
+                    fragmentsLeft = get32(command + 8);
+                }
+                if (fragmentsLeft == 0 || offset > frame.size() || size - 24 > frame.size() - offset) {
+                    throw std::runtime_error("UDP loopback: malformed fragment");
+                }
+                std::memcpy(frame.data() + offset, command + 24, size - 24);
+                complete = --fragmentsLeft == 0;
+            });
+        }
+        return frame;
+    }
+
+    void disconnect() {
+        std::vector<uint8_t> datagram = header();
+        datagram.push_back(0x44);       // DISCONNECT, unsequenced
+        datagram.push_back(0xFF);
+        put16(datagram, 0);
+        put32(datagram, 0);
+        send(datagram);
+    }
+};
+
+// A UdpTransport on a free loopback port that echoes every frame back
+class UdpEchoServer {
+private:
+    UdpTransport transport;
+    std::thread thread;
+
+    static UdpTransport::Handlers echoHandlers() {
+        UdpTransport::Handlers handlers;
+        handlers.connected = [](const std::shared_ptr<UdpClient>&) { return true; };
+        handlers.received = [](const std::shared_ptr<UdpClient>& peer, const std::vector<uint8_t>& frame) {
+            peer->sendPacket(frame);
+        };
+        handlers.disconnected = [](const std::shared_ptr<UdpClient>&) {};
+        return handlers;
+    }
+
+public:
+    UdpEchoServer() : transport(false, echoHandlers()) {
+        if (!transport.open(0)) {
+            throw std::runtime_error("UDP loopback: bind failed");
+        }
+        thread = std::thread(&UdpTransport::run, &transport);
+    }
+
+    ~UdpEchoServer() {
+        transport.stop();
+        thread.join();
+    }
+
+    int getPort() const { return transport.getPort(); }
+};
+
+static void checkEcho(const std::vector<uint8_t>& sent, const std::vector<uint8_t>& received) {
+    if (received != sent) {
+        throw std::runtime_error("UDP loopback: echoed frame doesn't match (" + std::to_string(received.size()) +
+                                 " of " + std::to_string(sent.size()) + " bytes)");
+    }
+}
+
+// UdpTransport end to end against a client on the same machine. Every
+// iteration checks the echoed frame, so a handshake or reassembly bug
+// fails the run instead of skewing it.
+static void registerUdpBenchmarks() {
+    BenchRegistry::add("UdpTransport::connect+echo+disconnect", [](BenchState& state) {
+        UdpEchoServer server;
+        EnetLoopbackClient client(server.getPort());
+        std::vector<uint8_t> frame(64, 0x5a);
+        while (state.next()) {
+            client.connect();
+            client.sendFrame(frame);
+            checkEcho(frame, client.receiveFrame());
+            client.disconnect();
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+
+    // Past the MTU the frame is fragmented both ways
+    for (size_t size : {64, 1024, 16384, 262144}) {
+        BenchRegistry::add("UdpTransport::echo/bytes:" + std::to_string(size), [size](BenchState& state) {
+            UdpEchoServer server;
+            EnetLoopbackClient client(server.getPort());
+            client.connect();
+
+            std::vector<uint8_t> frame(size);
+            for (size_t i = 0; i < size; ++i) {
+                frame[i] = static_cast<uint8_t>(i * 31 + 7);
+            }
+            while (state.next()) {
+                client.sendFrame(frame);
+                checkEcho(frame, client.receiveFrame());
+            }
+            client.disconnect();
+            state.setItemsProcessed(state.getIterations());
+            state.setBytesProcessed(state.getIterations() * size);
+        });
+    }
+}
+#endif
+
+// Posting game logic from an I/O thread to a world's executor: the
+// work-stealing pool's locked deques versus per-core lock-free inboxes
+static void registerWorkerPoolBenchmarks() {
+    for (bool perCore : {false, true}) {
+        std::string name = std::string("SerialExecutor::post/pool:") + (perCore ? "per-core" : "work-stealing");
+        BenchRegistry::add(name, [perCore](BenchState& state) {
+            WorkerPool pool(2, perCore);
+            auto executor = std::make_shared<SerialExecutor>(pool, perCore ? 0 : WorkerPool::ANY_WORKER);
+            std::atomic<uint64_t> completed{0};
+            uint64_t posted = 0;
+            while (state.next()) {
+                executor->post([&completed] { completed.fetch_add(1, std::memory_order_relaxed); });
+                ++posted;
+            }
+            while (completed.load() < posted) {
+                std::this_thread::yield();
+            }
+            state.setItemsProcessed(state.getIterations());
+        });
+    }
+}
+
+static void registerAccountBenchmarks() {
+    // Capacity 0 disables the verified-login cache, so every login hashes
+    for (size_t capacity : {AccountStore::DEFAULT_CACHE_CAPACITY, size_t(0)}) {
+        std::string name = std::string("AccountStore::login/") + (capacity ? "cached" : "uncached");
+        BenchRegistry::add(name, [capacity](BenchState& state) {
+            std::string path = "bench_accounts.tmp.db";
+            std::remove(path.c_str());
+            {
+                // Registering the account hashes once; keep it out of the result
+                state.pauseTiming();
+                AccountStore accounts(capacity);
+                accounts.open(path);
+                accounts.login("benchplayer", "hunter2");
+                state.resumeTiming();
+                
+                while (state.next()) {
+                    accounts.login("benchplayer", "hunter2");
+                }
+            }
+            std::remove(path.c_str());
+            state.setItemsProcessed(state.getIterations());
+        });
+    }
+}
+
+static void registerLoggerBenchmarks() {
+    BenchRegistry::add("Logger::writeLog/console", [](BenchState& state) {
+        while (state.next()) {
+            Logger::info("Received string packet from 127.0.0.1: action|join_request");
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    BenchRegistry::add("Logger::writeLog/console+file", [](BenchState& state) {
+        std::string path = "bench_logger.tmp.log";
+        Logger::enableFileLogging(path);
+        while (state.next()) {
+            Logger::info("Received string packet from 127.0.0.1: action|join_request");
+        }
+        Logger::disableFileLogging();
+        std::remove(path.c_str());
+        state.setItemsProcessed(state.getIterations());
+    });
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--filter <substring>] [--min-time <seconds>] [--json <file>]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string jsonPath;
+    double minSeconds = 0.2;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            minSeconds = std::stod(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    registerProtocolBenchmarks();
+#ifndef _WIN32
+    registerServerBenchmarks();
+#endif
+#ifdef __linux__
+    registerIpcBenchmarks();
+#endif
+#ifndef _WIN32
+    registerUdpBenchmarks();
+#endif
+    registerWorkerPoolBenchmarks();
+    registerAccountBenchmarks();
+    registerLoggerBenchmarks();
+    
+    // Silence the server's console logging while measuring
+    NullBuffer nullBuffer;
+    auto* coutBuffer = std::cout.rdbuf(&nullBuffer);
+    auto* cerrBuffer = std::cerr.rdbuf(&nullBuffer);
+    
+    auto results = BenchRegistry::runAll(filter, minSeconds);
+    
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+    
+    BenchRegistry::printTable(results, std::cout);
+    
+    if (!jsonPath.empty()) {
+        std::ofstream jsonFile(jsonPath);
+        if (!jsonFile) {
+            std::cerr << "Failed to open " << jsonPath << std::endl;
+            return 1;
+        }
+        BenchRegistry::writeJson(results, jsonFile);
+        std::cout << "Results written to " << jsonPath << std::endl;
+    }
+    
+    return 0;
+}
@@ -9,30 +9,51 @@ if ! command -v g++ &> /dev/null; then
     sudo apt install -y build-essential g++ make
 fi
 
-# Create obj directories
-mkdir -p obj/server
-mkdir -p obj/utils
-mkdir -p obj/protocol
+# Source files (keep in sync with CORE_SOURCES in CMakeLists.txt)
+SOURCES=(
+    main.cpp
+    server/Server.cpp
+    server/Client.cpp
+    server/TrafficCapture.cpp
+    server/WorkerPool.cpp
+    server/World.cpp
+    server/SpatialGrid.cpp
+    server/KeyValueStore.cpp
+    server/AccountStore.cpp
+    server/ItemDatabase.cpp
+    server/ResponseCache.cpp
+    server/ServerSettings.cpp
+    server/AdmissionControl.cpp
+    server/SessionArena.cpp
+    server/UdpTransport.cpp
+    server/EventLoop.cpp
+    server/IoUring.cpp
+    server/HotRestart.cpp
+    server/ShardLink.cpp
+    server/ShmRing.cpp
+    server/ShardRouter.cpp
+    server/RemoteClient.cpp
+    utils/Logger.cpp
+    utils/Trace.cpp
+    utils/Config.cpp
+    utils/Sha256.cpp
+    utils/CpuAffinity.cpp
+    protocol/Packet.cpp
+)
 
 # Compile source files
-echo "Compiling main.cpp..."
-g++ -std=c++17 -Wall -Wextra -O2 -c main.cpp -o obj/main.o
-
-echo "Compiling Server.cpp..."
-g++ -std=c++17 -Wall -Wextra -O2 -c server/Server.cpp -o obj/server/Server.o
-
-echo "Compiling Client.cpp..."
-g++ -std=c++17 -Wall -Wextra -O2 -c server/Client.cpp -o obj/server/Client.o
-
-echo "Compiling Logger.cpp..."
-g++ -std=c++17 -Wall -Wextra -O2 -c utils/Logger.cpp -o obj/utils/Logger.o
-
-echo "Compiling Packet.cpp..."
-g++ -std=c++17 -Wall -Wextra -O2 -c protocol/Packet.cpp -o obj/protocol/Packet.o
+OBJECTS=()
+for src in "${SOURCES[@]}"; do
+    obj="obj/${src%.cpp}.o"
+    mkdir -p "$(dirname "$obj")"
+    echo "Compiling $src..."
+    g++ -std=c++20 -Wall -Wextra -O2 -DGT_ENABLE_TRACING -I. -c "$src" -o "$obj" || { echo "Build failed!"; exit 1; }
+    OBJECTS+=("$obj")
+done
 
 # Link executable
 echo "Linking executable..."
-g++ obj/main.o obj/server/Server.o obj/server/Client.o obj/utils/Logger.o obj/protocol/Packet.o -o growtopia_server -lpthread
+g++ "${OBJECTS[@]}" -o growtopia_server -lpthread
 
 if [ $? -eq 0 ]; then
     echo "Build successful! Run ./growtopia_server to start the server."
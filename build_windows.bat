@@ -25,25 +25,15 @@ if not exist obj\server mkdir obj\server
 if not exist obj\utils mkdir obj\utils
 if not exist obj\protocol mkdir obj\protocol
 
-REM Compile source files
-echo Compiling main.cpp...
-cl /c /EHsc /std:c++17 main.cpp /Fo:obj\main.obj
-
-echo Compiling Server.cpp...
-cl /c /EHsc /std:c++17 server\Server.cpp /Fo:obj\server\Server.obj
-
-echo Compiling Client.cpp...
-cl /c /EHsc /std:c++17 server\Client.cpp /Fo:obj\server\Client.obj
-
-echo Compiling Logger.cpp...
-cl /c /EHsc /std:c++17 utils\Logger.cpp /Fo:obj\utils\Logger.obj
-
-echo Compiling Packet.cpp...
-cl /c /EHsc /std:c++17 protocol\Packet.cpp /Fo:obj\protocol\Packet.obj
+REM Compile source files (keep in sync with CORE_SOURCES in CMakeLists.txt)
+for %%F in (main server\Server server\Client server\TrafficCapture server\WorkerPool server\World server\SpatialGrid server\KeyValueStore server\AccountStore server\ItemDatabase server\ResponseCache server\ServerSettings server\AdmissionControl server\SessionArena server\UdpTransport utils\Logger utils\Trace utils\Config utils\Sha256 utils\CpuAffinity protocol\Packet) do (
+    echo Compiling %%F.cpp...
+    cl /c /EHsc /std:c++20 /DGT_ENABLE_TRACING /I. %%F.cpp /Fo:obj\%%F.obj
+)
 
 REM Link executable
 echo Linking executable...
-link obj\main.obj obj\server\Server.obj obj\server\Client.obj obj\utils\Logger.obj obj\protocol\Packet.obj ws2_32.lib /OUT:growtopia_server.exe
+link obj\main.obj obj\server\Server.obj obj\server\Client.obj obj\server\TrafficCapture.obj obj\server\WorkerPool.obj obj\server\World.obj obj\server\SpatialGrid.obj obj\utils\Logger.obj obj\utils\Trace.obj obj\protocol\Packet.obj ws2_32.lib /OUT:growtopia_server.exe
 
 if %ERRORLEVEL% EQU 0 (
     echo Build successful! Run growtopia_server.exe to start the server.
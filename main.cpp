@@ -5,7 +5,9 @@
 #include <csignal>
 #include <atomic>
 #include "server/Server.h"
+#include "server/TrafficCapture.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 
 // Global flag for graceful shutdown
 std::atomic<bool> shutdownRequested(false);
@@ -20,6 +22,22 @@ void signalHandler(int signal) {
             globalServer->stop();
         }
     }
+#ifndef _WIN32
+    else if (signal == SIGUSR1) {
+        // Written on the server's next housekeeping tick
+        Trace::requestDump();
+    } else if (signal == SIGHUP) {
+        // Re-read config.ini on the server's next housekeeping tick
+        if (globalServer) {
+            globalServer->requestReload();
+        }
+    } else if (signal == SIGUSR2) {
+        // Logged on the server's next housekeeping tick
+        if (globalServer) {
+            globalServer->requestMemoryReport();
+        }
+    }
+#endif
 }
 
 int main(int argc, char* argv[]) {
@@ -29,29 +47,144 @@ int main(int argc, char* argv[]) {
         Logger::info("Cross-platform C++ implementation");
         Logger::info("================================");
         
-        // Enable file logging
-        Logger::enableFileLogging("server.log");
-        Logger::info("File logging enabled: server.log");
+        // Parse options; any remaining argument selects interactive mode
+        std::vector<std::string> positionalArgs;
+        bool threadedMode = false;
+        bool ioUringMode = false;
+        bool takeoverMode = false;
+        std::string hotRestartPath;
+        std::string shardPath;
+        std::vector<std::string> shardPaths;
+        std::string configPath = "config.ini";
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--capture" && i + 1 < argc) {
+                // Record all inbound frames for later replay (see growtopia_replay)
+                if (!TrafficCapture::start(argv[++i])) {
+                    return -1;
+                }
+            } else if (arg == "--hot-restart" && i + 1 < argc) {
+                // Control socket a successor connects to for a zero-downtime restart
+                hotRestartPath = argv[++i];
+            } else if (arg == "--takeover") {
+                // Take the port and live sessions over from the running server
+                takeoverMode = true;
+            } else if (arg == "--shard" && i + 1 < argc) {
+                // Serve worlds for a front-door router instead of game clients
+                shardPath = argv[++i];
+            } else if (arg == "--router" && i + 1 < argc) {
+                // Front door: comma-separated shard socket paths
+                std::string list = argv[++i];
+                size_t start = 0;
+                while (start <= list.size()) {
+                    size_t end = list.find(',', start);
+                    if (end == std::string::npos) end = list.size();
+                    if (end > start) shardPaths.push_back(list.substr(start, end - start));
+                    start = end + 1;
+                }
+            } else if (arg == "--threaded") {
+                // Blocking thread per client instead of the event loop
+                threadedMode = true;
+            } else if (arg == "--io-uring") {
+                // Event loop completes socket I/O through io_uring when available
+                ioUringMode = true;
+            } else if (arg == "--config" && i + 1 < argc) {
+                // Settings file; SIGHUP re-reads it
+                configPath = argv[++i];
+            } else if (arg == "--trace") {
+                // Record trace spans; dump with SIGUSR1 or at shutdown
+                Trace::enable();
+            } else {
+                positionalArgs.push_back(arg);
+            }
+        }
         
         // Check if running in daemon mode (no arguments = daemon mode)
-        bool daemonMode = (argc == 1);
+        bool daemonMode = positionalArgs.empty();
         
         // Set up signal handlers for graceful shutdown
         std::signal(SIGINT, signalHandler);
         std::signal(SIGTERM, signalHandler);
+#ifndef _WIN32
+        // Peers that vanish mid-send (e.g. replayed captures) must not kill the process
+        std::signal(SIGPIPE, SIG_IGN);
+        std::signal(SIGUSR1, signalHandler);
+        std::signal(SIGHUP, signalHandler);
+        std::signal(SIGUSR2, signalHandler);
+#endif
         
-        // Initialize server on port 17091 (default Growtopia port)
-        Server server(17091);
+        ServerSettings settings;
+        if (!settings.load(configPath)) {
+            Logger::warning(configPath + " not found, using defaults");
+        }
+        
+        // Default port 17091 is the standard Growtopia port
+        Server server(settings.port, settings.workerThreads, settings.coreShards);
         globalServer = &server;
+        server.configure(settings, configPath);
+        
+        // Shards trust the router, which checks logins for them
+        if (settings.enableAuthentication && shardPath.empty()) {
+            if (!server.enableAuthentication(settings.accountsFile)) {
+                return -1;
+            }
+            Logger::info("GrowID authentication enabled");
+        }
+        
+        if (!server.loadItems(settings.itemsFile)) {
+            Logger::warning("Running without item data; build " + settings.itemsFile + " with growtopia_itemdb");
+        }
+        if (threadedMode) {
+            server.setUseEventLoop(false);
+        }
+        if (ioUringMode) {
+            server.setUseIoUring(true);
+        }
         
-        if (!server.initialize()) {
+        bool initialized = false;
+#ifdef __linux__
+        if (!shardPath.empty() && !shardPaths.empty()) {
+            Logger::error("--shard and --router are mutually exclusive");
+            return -1;
+        }
+        if (!shardPath.empty()) {
+            server.enableShard(shardPath);
+        }
+        if (!shardPaths.empty()) {
+            server.enableRouter(shardPaths);
+        }
+        if (!hotRestartPath.empty()) {
+            server.enableHotRestart(hotRestartPath);
+        }
+        if (takeoverMode) {
+            if (hotRestartPath.empty()) {
+                Logger::error("--takeover requires --hot-restart <path>");
+                return -1;
+            }
+            initialized = server.takeover();
+        } else {
+            initialized = server.initialize();
+        }
+#else
+        if (!hotRestartPath.empty() || takeoverMode) {
+            Logger::warning("Hot restart is only available on Linux");
+        }
+        if (!shardPath.empty() || !shardPaths.empty()) {
+            Logger::warning("World sharding is only available on Linux");
+        }
+        initialized = server.initialize();
+#endif
+        
+        if (!initialized) {
             Logger::error("Failed to initialize server");
             return -1;
         }
         
         Logger::info("Server initialized successfully");
-        Logger::info("Server listening on port 17091");
-        Logger::info("Ready to accept client connections");
+        if (shardPath.empty()) {
+            Logger::info("Server listening on port " + std::to_string(settings.port));
+            Logger::info("Ready to accept client connections");
+        }
         
         if (daemonMode) {
             Logger::info("Running in daemon mode (use SIGTERM to stop)");
@@ -63,6 +196,11 @@ int main(int argc, char* argv[]) {
             server.run();
         }
         
+        TrafficCapture::stop();
+        if (Trace::isEnabled()) {
+            Trace::requestDump();
+            Trace::servicePendingDump();
+        }
         Logger::info("Server shutdown complete");
         
     } catch (const std::exception& e) {
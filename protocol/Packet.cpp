@@ -1,4 +1,5 @@
 #include "Packet.h"
+#include "../utils/Trace.h"
 #include <cstring>
 
 std::vector<uint8_t> PacketBuilder::createStringPacket(const std::string& str) {
@@ -55,7 +56,8 @@ std::vector<uint8_t> PacketBuilder::createUpdatePacket(const GamePacket& gamePac
     return packet;
 }
 
-GamePacket PacketBuilder::parsePacket(const std::vector<uint8_t>& data) {
+GamePacket PacketBuilder::parsePacket(std::span<const uint8_t> data) {
+    TRACE_SCOPE("parsePacket");
     GamePacket packet;
     
     if (data.size() < 4) {
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <span>
 #include <cstdint>
 
 // Growtopia packet types
@@ -14,6 +15,16 @@ enum class PacketType : uint8_t {
     UPDATE_PACKET = 6
 };
 
+// Update packet subtypes (carried in GamePacket::objtype)
+enum class UpdateType : uint8_t {
+    STATE = 0,                 // Player movement
+    CALL_FUNCTION = 1,
+    TILE_CHANGE_REQUEST = 3,   // Block place/break
+    SEND_TILE_UPDATE_DATA = 5,
+    SEND_PARTICLE_EFFECT = 17,
+    ITEM_EFFECT = 19
+};
+
 // Basic packet structure
 struct GamePacket {
     PacketType type;
@@ -48,7 +59,7 @@ class PacketBuilder {
 public:
     static std::vector<uint8_t> createStringPacket(const std::string& str);
     static std::vector<uint8_t> createUpdatePacket(const GamePacket& packet);
-    static GamePacket parsePacket(const std::vector<uint8_t>& data);
+    static GamePacket parsePacket(std::span<const uint8_t> data);
     
     // Helper functions for common packets
     static std::vector<uint8_t> createLoginResponse(bool success, const std::string& message = "");
@@ -0,0 +1,175 @@
+#include "AccountStore.h"
+#include "../utils/Logger.h"
+#include "../utils/Trace.h"
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include <vector>
+
+namespace {
+    const char* HASH_SCHEME = "pbkdf2-sha256";
+    const size_t SALT_SIZE = 16;
+
+    // Names are case-insensitive; the store is keyed by the lowercase form
+    std::string accountKey(const std::string& name) {
+        std::string key = name;
+        std::transform(key.begin(), key.end(), key.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return key;
+    }
+
+    void randomBytes(uint8_t* out, size_t length) {
+        std::random_device source;
+        for (size_t i = 0; i < length; ++i) {
+            out[i] = static_cast<uint8_t>(source());
+        }
+    }
+}
+
+AccountStore::AccountStore(size_t cacheCapacity, Clock::duration cacheTTL, uint32_t iterations)
+    : iterations(iterations), cacheCapacity(cacheCapacity), cacheTTL(cacheTTL) {
+    randomBytes(cacheSecret, sizeof(cacheSecret));
+}
+
+bool AccountStore::open(const std::string& path) {
+    if (!store.open(path)) {
+        return false;
+    }
+    Logger::info("Loaded " + std::to_string(store.size()) + " accounts from " + path);
+    return true;
+}
+
+bool AccountStore::isValidName(const std::string& name) {
+    if (name.size() < 3 || name.size() > 18) return false;
+    return std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isalnum(c) != 0; });
+}
+
+AccountStore::LoginResult AccountStore::login(const std::string& name, const std::string& password) {
+    if (!isValidName(name) || password.empty()) {
+        return LoginResult::INVALID_NAME;
+    }
+
+    std::string key = accountKey(name);
+    Sha256::Digest digest = cacheDigest(key, password);
+
+    // A mismatch falls through to the slow hash, which is what throttles
+    // password guessing
+    if (checkCache(key, digest)) {
+        return LoginResult::OK;
+    }
+
+    std::string record;
+    if (store.get(key, record)) {
+        if (!verifyPassword(record, password)) {
+            return LoginResult::WRONG_PASSWORD;
+        }
+        remember(key, digest);
+        return LoginResult::OK;
+    }
+
+    std::string hashed = hashPassword(password);
+    if (!store.insert(key, hashed)) {
+        // Lost a race with another first login for the same name
+        if (store.get(key, record)) {
+            if (!verifyPassword(record, password)) {
+                return LoginResult::WRONG_PASSWORD;
+            }
+            remember(key, digest);
+            return LoginResult::OK;
+        }
+        return LoginResult::STORE_ERROR;
+    }
+
+    remember(key, digest);
+    return LoginResult::CREATED;
+}
+
+std::string AccountStore::hashPassword(const std::string& password) const {
+    TRACE_SCOPE("AccountStore::hashPassword");
+    std::vector<uint8_t> salt(SALT_SIZE);
+    randomBytes(salt.data(), salt.size());
+    Sha256::Digest hash = Sha256::pbkdf2(password, salt, iterations);
+
+    return std::string(HASH_SCHEME) + "$" + std::to_string(iterations) + "$" +
+           toHex(salt.data(), salt.size()) + "$" + toHex(hash.data(), hash.size());
+}
+
+bool AccountStore::verifyPassword(const std::string& record, const std::string& password) const {
+    TRACE_SCOPE("AccountStore::verifyPassword");
+
+    // scheme$iterations$salt$hash
+    size_t first = record.find('$');
+    size_t second = first == std::string::npos ? first : record.find('$', first + 1);
+    size_t third = second == std::string::npos ? second : record.find('$', second + 1);
+    if (third == std::string::npos || record.compare(0, first, HASH_SCHEME) != 0) {
+        Logger::error("Unrecognized password record format");
+        return false;
+    }
+
+    uint32_t recordIterations = 0;
+    std::vector<uint8_t> salt;
+    std::vector<uint8_t> expected;
+    try {
+        recordIterations = static_cast<uint32_t>(std::stoul(record.substr(first + 1, second - first - 1)));
+    } catch (...) {
+        return false;
+    }
+    if (recordIterations == 0 || !fromHex(record.substr(second + 1, third - second - 1), salt) ||
+        !fromHex(record.substr(third + 1), expected) || expected.size() != sizeof(Sha256::Digest)) {
+        Logger::error("Corrupt password record");
+        return false;
+    }
+
+    Sha256::Digest hash = Sha256::pbkdf2(password, salt, recordIterations);
+    return constantTimeEquals(hash.data(), expected.data(), hash.size());
+}
+
+Sha256::Digest AccountStore::cacheDigest(const std::string& key, const std::string& password) const {
+    std::string message = key;
+    message.push_back('\0');
+    message += password;
+    return Sha256::hmac(cacheSecret, sizeof(cacheSecret),
+                        reinterpret_cast<const uint8_t*>(message.data()), message.size());
+}
+
+bool AccountStore::checkCache(const std::string& key, const Sha256::Digest& digest) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = recentIndex.find(key);
+    if (it == recentIndex.end()) {
+        return false;
+    }
+
+    auto entry = it->second;
+    if (entry->expires <= Clock::now() ||
+        !constantTimeEquals(entry->digest.data(), digest.data(), digest.size())) {
+        recent.erase(entry);
+        recentIndex.erase(it);
+        return false;
+    }
+    recent.splice(recent.begin(), recent, entry);
+    return true;
+}
+
+void AccountStore::remember(const std::string& key, const Sha256::Digest& digest) {
+    if (cacheCapacity == 0) return;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = recentIndex.find(key);
+    if (it != recentIndex.end()) {
+        recent.erase(it->second);
+        recentIndex.erase(it);
+    }
+
+    recent.push_front({key, digest, Clock::now() + cacheTTL});
+    recentIndex[key] = recent.begin();
+
+    while (recent.size() > cacheCapacity) {
+        recentIndex.erase(recent.back().key);
+        recent.pop_back();
+    }
+}
+
+size_t AccountStore::getCachedCount() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return recent.size();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "KeyValueStore.h"
+#include "../utils/Sha256.h"
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// GrowID accounts (name -> salted PBKDF2-SHA256 password hash) persisted in
+// a KeyValueStore. A full verification is deliberately slow (~100 ms), so
+// successful logins are remembered in a bounded LRU cache: a player who
+// reconnects within the TTL is checked with one HMAC-SHA256 instead. Only
+// matches are answered from the cache; a wrong password still pays for the
+// full hash, so guessing never gets cheaper.
+//
+// login() is thread-safe and may block on hashing; call it from the worker
+// pool, never from an I/O thread.
+class AccountStore {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class LoginResult {
+        OK,
+        CREATED,        // First login with this name registered it
+        WRONG_PASSWORD,
+        INVALID_NAME,
+        STORE_ERROR
+    };
+
+private:
+    struct CachedLogin {
+        std::string key;
+        Sha256::Digest digest;
+        Clock::time_point expires;
+    };
+
+    KeyValueStore store;
+    uint32_t iterations;
+
+    // Recently verified logins, most recent first. Digests are keyed with a
+    // per-process secret, so the cache holds nothing useful off-host.
+    std::mutex cacheMutex;
+    std::list<CachedLogin> recent;
+    std::unordered_map<std::string, std::list<CachedLogin>::iterator> recentIndex;
+    size_t cacheCapacity;
+    Clock::duration cacheTTL;
+    uint8_t cacheSecret[32];
+
+    Sha256::Digest cacheDigest(const std::string& key, const std::string& password) const;
+    bool checkCache(const std::string& key, const Sha256::Digest& digest); // A mismatch evicts the entry
+    void remember(const std::string& key, const Sha256::Digest& digest);
+
+    std::string hashPassword(const std::string& password) const;
+    bool verifyPassword(const std::string& record, const std::string& password) const;
+
+public:
+    static const uint32_t DEFAULT_ITERATIONS = 100000;
+    static const size_t DEFAULT_CACHE_CAPACITY = 4096;
+
+    AccountStore(size_t cacheCapacity = DEFAULT_CACHE_CAPACITY,
+                 Clock::duration cacheTTL = std::chrono::minutes(15),
+                 uint32_t iterations = DEFAULT_ITERATIONS);
+
+    bool open(const std::string& path);
+
+    // Verifies the password, registering the name on first use
+    LoginResult login(const std::string& name, const std::string& password);
+
+    // GrowID rules: 3-18 letters or digits
+    static bool isValidName(const std::string& name);
+
+    size_t getAccountCount() const { return store.size(); }
+    size_t getCachedCount();
+};
@@ -0,0 +1,123 @@
+#include "AdmissionControl.h"
+#include "Client.h"
+#include <algorithm>
+
+AdmissionControl::AdmissionControl() : players(0) {
+}
+
+AdmissionControl::Changes AdmissionControl::setLimits(const Limits& newLimits) {
+    std::lock_guard<std::mutex> lock(mutex);
+    limits = newLimits;
+    return promoteLocked(false);
+}
+
+AdmissionControl::Verdict AdmissionControl::connect(const std::shared_ptr<Client>& client) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string ip(client->getIP());
+
+    auto counted = perIP.find(ip);
+    if (limits.maxPerIP > 0 && counted != perIP.end() && counted->second >= limits.maxPerIP) {
+        return Verdict::TOO_MANY_FROM_IP;
+    }
+
+    // Room for every player and everyone who could be waiting; connections
+    // that never log in hold a place until the handshake timeout
+    if (limits.maxPlayers > 0 && connections.size() >= limits.maxPlayers + limits.maxQueue) {
+        return Verdict::SERVER_FULL;
+    }
+
+    connections[client.get()].ip = ip;
+    ++perIP[ip];
+    return Verdict::ACCEPTED;
+}
+
+void AdmissionControl::adopt(const std::shared_ptr<Client>& client) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = connections[client.get()];
+    entry.ip = client->getIP();
+    entry.admitted = true;
+    ++perIP[entry.ip];
+    ++players;
+}
+
+AdmissionControl::LoginResult AdmissionControl::login(const std::shared_ptr<Client>& client, const std::string& message, size_t& position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = connections.find(client.get());
+    if (it == connections.end() || it->second.admitted) {
+        return LoginResult::ADMITTED; // Not ours to limit, or already in
+    }
+
+    // Nobody skips ahead of a waiting login
+    if (queue.empty() && (limits.maxPlayers == 0 || players < limits.maxPlayers)) {
+        it->second.admitted = true;
+        ++players;
+        return LoginResult::ADMITTED;
+    }
+
+    if (queue.size() >= limits.maxQueue) {
+        return LoginResult::QUEUE_FULL;
+    }
+    queue.push_back({client, message});
+    position = queue.size();
+    return LoginResult::QUEUED;
+}
+
+AdmissionControl::Changes AdmissionControl::disconnect(const Client* client) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = connections.find(client);
+    if (it == connections.end()) {
+        return {};
+    }
+
+    auto counted = perIP.find(it->second.ip);
+    if (counted != perIP.end() && --counted->second == 0) {
+        perIP.erase(counted);
+    }
+
+    bool queueChanged = false;
+    if (it->second.admitted) {
+        --players;
+    } else {
+        auto waiting = std::find_if(queue.begin(), queue.end(),
+                                    [client](const Waiting& entry) { return entry.client.get() == client; });
+        if (waiting != queue.end()) {
+            queue.erase(waiting);
+            queueChanged = true;
+        }
+    }
+    connections.erase(it);
+    return promoteLocked(queueChanged);
+}
+
+AdmissionControl::Changes AdmissionControl::promoteLocked(bool reportMoves) {
+    Changes changes;
+    while (!queue.empty() && (limits.maxPlayers == 0 || players < limits.maxPlayers)) {
+        Waiting next = std::move(queue.front());
+        queue.pop_front();
+
+        auto it = connections.find(next.client.get());
+        if (it == connections.end()) {
+            continue;
+        }
+        it->second.admitted = true;
+        ++players;
+        changes.admitted.push_back({std::move(next.client), std::move(next.message)});
+    }
+
+    if (reportMoves || !changes.admitted.empty()) {
+        for (size_t i = 0; i < queue.size(); ++i) {
+            changes.moved.emplace_back(queue[i].client, i + 1);
+        }
+    }
+    return changes;
+}
+
+size_t AdmissionControl::getPlayerCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return players;
+}
+
+size_t AdmissionControl::getQueueLength() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+class Client;
+
+// Decides who may connect and who may play. Connections are capped in
+// total and per IP when accepted; logins beyond the player cap wait in a
+// bounded first-come, first-served queue instead of loading the handlers,
+// and are let in as players leave. Every limit of 0 means unlimited, except
+// the queue, where 0 turns extra logins away at once. Thread-safe; the
+// caller delivers the resulting messages.
+class AdmissionControl {
+public:
+    struct Limits {
+        size_t maxPlayers = 0;
+        size_t maxPerIP = 0;
+        size_t maxQueue = 0;
+    };
+
+    enum class Verdict {
+        ACCEPTED,
+        SERVER_FULL,       // Every player slot and queue place is taken
+        TOO_MANY_FROM_IP
+    };
+
+    enum class LoginResult {
+        ADMITTED,
+        QUEUED,
+        QUEUE_FULL
+    };
+
+    // A queued login that got a slot, with the logon message to replay
+    struct Promotion {
+        std::shared_ptr<Client> client;
+        std::string message;
+    };
+
+    // What changed in the queue: logins to resume, and new positions
+    // (1-based) for those still waiting
+    struct Changes {
+        std::vector<Promotion> admitted;
+        std::vector<std::pair<std::shared_ptr<Client>, size_t>> moved;
+    };
+
+private:
+    struct Entry {
+        std::string ip;
+        bool admitted = false;
+    };
+
+    struct Waiting {
+        std::shared_ptr<Client> client;
+        std::string message;
+    };
+
+    mutable std::mutex mutex;
+    Limits limits;
+    std::unordered_map<const Client*, Entry> connections;
+    std::unordered_map<std::string, size_t> perIP;
+    std::deque<Waiting> queue;
+    size_t players;
+
+    Changes promoteLocked(bool reportMoves);
+
+public:
+    AdmissionControl();
+
+    // Raising a limit may let queued logins in
+    Changes setLimits(const Limits& newLimits);
+
+    // On accept; a refused client should be told why and closed
+    Verdict connect(const std::shared_ptr<Client>& client);
+
+    // Hot restart: sessions from the previous process were already playing
+    void adopt(const std::shared_ptr<Client>& client);
+
+    // On the logon packet; `position` is set when queued
+    LoginResult login(const std::shared_ptr<Client>& client, const std::string& message, size_t& position);
+
+    // On disconnect, from any state; frees the slot or queue place
+    Changes disconnect(const Client* client);
+
+    size_t getPlayerCount() const;
+    size_t getQueueLength() const;
+};
@@ -1,13 +1,44 @@
 #include "Client.h"
+#include "TrafficCapture.h"
 #include "../utils/Logger.h"
+#include "../utils/Trace.h"
 #include <cstring>
 
+#ifdef __linux__
+    #include <fcntl.h>
+#endif
+
+static std::atomic<uint32_t> nextConnectionID(1);
+
+static ConnectionLimits connectionLimits;
+
+void Client::setLimits(const ConnectionLimits& newLimits) {
+    connectionLimits = newLimits;
+}
+
+const ConnectionLimits& Client::getLimits() {
+    return connectionLimits;
+}
+
 Client::Client(socket_t socket, const std::string& ip) 
-    : clientSocket(socket), ipAddress(ip), connected(true), playerID(-1), worldX(0), worldY(0) {
+    : clientSocket(socket), connectionID(nextConnectionID++), ipAddress(ip, &arena), connected(true),
+      playerName(&arena), playerID(-1), authenticated(false), inLoginQueue(false), worldX(0), worldY(0)
+#ifdef __linux__
+      , eventLoop(nullptr), inbound(&arena), inboundOffset(0), outbound(&arena), outboundOffset(0),
+      flushScheduled(false), inflight(&arena)
+#endif
+{
+    TrafficCapture::recordConnect(connectionID);
 }
 
 Client::~Client() {
     disconnect();
+#ifdef __linux__
+    // The session never got to close it (e.g. the loop never ran)
+    if (eventLoop && clientSocket != INVALID_SOCKET) {
+        CLOSE_SOCKET(clientSocket);
+    }
+#endif
 }
 
 bool Client::isConnected() const {
@@ -15,8 +46,18 @@ bool Client::isConnected() const {
 }
 
 void Client::disconnect() {
-    if (connected) {
-        connected = false;
+    if (connected.exchange(false)) {
+        TrafficCapture::recordDisconnect(connectionID);
+#ifdef __linux__
+        if (eventLoop) {
+            // Wake the session with EOF; the loop closes the descriptor
+            std::lock_guard<std::mutex> lock(socketMutex);
+            if (clientSocket != INVALID_SOCKET) {
+                shutdown(clientSocket, SHUT_RDWR);
+            }
+            return;
+        }
+#endif
         if (clientSocket != INVALID_SOCKET) {
             CLOSE_SOCKET(clientSocket);
             clientSocket = INVALID_SOCKET;
@@ -24,6 +65,14 @@ void Client::disconnect() {
     }
 }
 
+void Client::discardReceived() {
+#ifndef _WIN32
+    char scratch[4096];
+    while (recv(clientSocket, scratch, sizeof(scratch), MSG_DONTWAIT) > 0) {
+    }
+#endif
+}
+
 std::vector<uint8_t> Client::receivePacket() {
     if (!connected) {
         return {};
@@ -35,20 +84,22 @@ std::vector<uint8_t> Client::receivePacket() {
     
     if (bytesReceived <= 0) {
         if (bytesReceived == 0) {
-            Logger::info("Client " + ipAddress + " disconnected gracefully");
+            Logger::info(Logger::concat({"Client ", getIP(), " disconnected gracefully"}));
         } else {
-            Logger::error("Error receiving packet length from " + ipAddress + ". Error: " + std::to_string(SOCKET_ERROR_CODE));
+            Logger::error(Logger::concat({"Error receiving packet length from ", getIP(), ". Error: ", std::to_string(SOCKET_ERROR_CODE)}));
         }
         disconnect();
         return {};
     }
     
+    TRACE_SCOPE_ID("receivePacket", connectionID);
+    
     // Convert from network byte order if needed
     // packetLength = ntohl(packetLength);
     
     // Sanity check for packet length
-    if (packetLength > 1024 * 1024) { // 1MB max
-        Logger::error("Packet too large from " + ipAddress + ": " + std::to_string(packetLength));
+    if (packetLength > connectionLimits.maxPacketSize) {
+        Logger::error(Logger::concat({"Packet too large from ", getIP(), ": ", std::to_string(packetLength)}));
         disconnect();
         return {};
     }
@@ -62,7 +113,7 @@ std::vector<uint8_t> Client::receivePacket() {
                            packetLength - totalReceived, 0);
         
         if (received <= 0) {
-            Logger::error("Error receiving packet data from " + ipAddress);
+            Logger::error(Logger::concat({"Error receiving packet data from ", getIP()}));
             disconnect();
             return {};
         }
@@ -70,14 +121,23 @@ std::vector<uint8_t> Client::receivePacket() {
         totalReceived += received;
     }
     
+    TrafficCapture::recordFrame(connectionID, packet);
     return packet;
 }
 
-bool Client::sendPacket(const std::vector<uint8_t>& packet) {
+bool Client::sendPacket(std::span<const uint8_t> packet) {
     if (!connected || packet.empty()) {
         return false;
     }
     
+    TRACE_SCOPE_ID("sendPacket", connectionID);
+    
+#ifdef __linux__
+    if (eventLoop) {
+        return queuePacket(packet);
+    }
+#endif
+    
     std::lock_guard<std::mutex> lock(sendMutex);
     
     // Send packet length first
@@ -86,7 +146,7 @@ bool Client::sendPacket(const std::vector<uint8_t>& packet) {
     
     int bytesSent = send(clientSocket, (char*)&packetLength, sizeof(packetLength), 0);
     if (bytesSent != sizeof(packetLength)) {
-        Logger::error("Failed to send packet length to " + ipAddress);
+        Logger::error(Logger::concat({"Failed to send packet length to ", getIP()}));
         disconnect();
         return false;
     }
@@ -98,7 +158,7 @@ bool Client::sendPacket(const std::vector<uint8_t>& packet) {
                        packet.size() - totalSent, 0);
         
         if (sent <= 0) {
-            Logger::error("Failed to send packet data to " + ipAddress);
+            Logger::error(Logger::concat({"Failed to send packet data to ", getIP()}));
             disconnect();
             return false;
         }
@@ -107,4 +167,318 @@ bool Client::sendPacket(const std::vector<uint8_t>& packet) {
     }
     
     return true;
-}
\ No newline at end of file
+}
+
+#ifdef __linux__
+bool Client::attachEventLoop(EventLoop& loop) {
+    int flags = fcntl(clientSocket, F_GETFL, 0);
+    if (flags < 0 || fcntl(clientSocket, F_SETFL, flags | O_NONBLOCK) < 0) {
+        Logger::error(Logger::concat({"Failed to make socket non-blocking for ", getIP()}));
+        return false;
+    }
+    
+    if (!loop.registerSocket(clientSocket)) {
+        return false;
+    }
+    eventLoop = &loop;
+    
+    // Output inherited from a previous process goes out first
+    std::lock_guard<std::mutex> lock(sendMutex);
+    if (outboundOffset < outbound.size() && !flushScheduled) {
+        flushScheduled = true;
+        if (usesRing()) {
+            spawn(flushThroughRing());
+        } else {
+            spawn(flushWhenWritable());
+        }
+    }
+    return true;
+}
+
+void Client::exportPending(SessionSnapshot& snapshot) {
+    snapshot.pendingInbound.assign(inbound.begin() + inboundOffset, inbound.end());
+    
+    std::lock_guard<std::mutex> lock(sendMutex);
+    snapshot.pendingOutbound.assign(outbound.begin() + outboundOffset, outbound.end());
+}
+
+socket_t Client::releaseSocket() {
+    socket_t released;
+    {
+        std::lock_guard<std::mutex> sendLock(sendMutex);
+        std::lock_guard<std::mutex> socketLock(socketMutex);
+        released = clientSocket;
+        clientSocket = INVALID_SOCKET;
+    }
+    if (released == INVALID_SOCKET) {
+        return INVALID_SOCKET;
+    }
+    
+    if (connected.exchange(false)) {
+        TrafficCapture::recordDisconnect(connectionID);
+    }
+    
+    // Wakes the session coroutine, which unwinds without touching the socket
+    eventLoop->unregisterSocket(released);
+    return released;
+}
+
+void Client::importPending(const SessionSnapshot& snapshot) {
+    inbound.assign(snapshot.pendingInbound.begin(), snapshot.pendingInbound.end());
+    inboundOffset = 0;
+    
+    std::lock_guard<std::mutex> lock(sendMutex);
+    outbound.assign(snapshot.pendingOutbound.begin(), snapshot.pendingOutbound.end());
+    outboundOffset = 0;
+}
+
+void Client::closeSocket() {
+    disconnect();
+    
+    std::lock_guard<std::mutex> sendLock(sendMutex);
+    std::lock_guard<std::mutex> socketLock(socketMutex);
+    if (clientSocket != INVALID_SOCKET) {
+        eventLoop->unregisterSocket(clientSocket);
+        CLOSE_SOCKET(clientSocket);
+        clientSocket = INVALID_SOCKET;
+    }
+}
+
+bool Client::flushOutboundLocked() {
+    while (outboundOffset < outbound.size()) {
+        ssize_t sent = send(clientSocket, outbound.data() + outboundOffset,
+                            outbound.size() - outboundOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent > 0) {
+            outboundOffset += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        
+        Logger::error(Logger::concat({"Failed to send packet data to ", getIP(), ". Error: ", std::to_string(SOCKET_ERROR_CODE)}));
+        return false;
+    }
+    
+    if (outboundOffset == outbound.size()) {
+        outbound.clear();
+        outboundOffset = 0;
+    } else if (outboundOffset > outbound.size() / 2) {
+        outbound.erase(outbound.begin(), outbound.begin() + outboundOffset);
+        outboundOffset = 0;
+    }
+    return true;
+}
+
+bool Client::queuePacket(std::span<const uint8_t> packet) {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    if (clientSocket == INVALID_SOCKET) {
+        return false;
+    }
+    
+    if (outbound.size() - outboundOffset + packet.size() > connectionLimits.maxOutboundBytes) {
+        Logger::warning(Logger::concat({"Send queue overflow for ", getIP(), ", disconnecting"}));
+        disconnect();
+        return false;
+    }
+    
+    uint32_t packetLength = static_cast<uint32_t>(packet.size());
+    const uint8_t* lengthBytes = reinterpret_cast<const uint8_t*>(&packetLength);
+    outbound.insert(outbound.end(), lengthBytes, lengthBytes + sizeof(packetLength));
+    outbound.insert(outbound.end(), packet.begin(), packet.end());
+    
+    // The ring sends from the loop thread, batching everything queued
+    // until the flush runs into one submission
+    if (usesRing()) {
+        scheduleFlushLocked();
+        return true;
+    }
+    
+    if (!flushOutboundLocked()) {
+        disconnect();
+        return false;
+    }
+    
+    // Whatever the kernel didn't take is written once the socket drains
+    if (outboundOffset < outbound.size()) {
+        scheduleFlushLocked();
+    }
+    return true;
+}
+
+void Client::scheduleFlushLocked() {
+    if (flushScheduled) return;
+    flushScheduled = true;
+    
+    auto self = shared_from_this();
+    if (usesRing()) {
+        eventLoop->post([self] { spawn(self->flushThroughRing()); });
+    } else {
+        eventLoop->post([self] { spawn(self->flushWhenWritable()); });
+    }
+}
+
+Task<void> Client::flushWhenWritable() {
+    auto self = shared_from_this();
+    
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            bool failed = clientSocket == INVALID_SOCKET || !flushOutboundLocked();
+            if (failed || outboundOffset == outbound.size()) {
+                flushScheduled = false;
+                if (failed) disconnect();
+                co_return;
+            }
+        }
+        
+        if (!co_await eventLoop->writable(clientSocket)) {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            flushScheduled = false;
+            co_return;
+        }
+    }
+}
+
+Task<void> Client::flushThroughRing() {
+    auto self = shared_from_this();
+    
+    while (true) {
+        socket_t fd;
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (clientSocket == INVALID_SOCKET || outboundOffset == outbound.size()) {
+                flushScheduled = false;
+                co_return;
+            }
+            if (outboundOffset > 0) {
+                outbound.erase(outbound.begin(), outbound.begin() + outboundOffset);
+                outboundOffset = 0;
+            }
+            // Swapping keeps both buffers' capacity around for the next round
+            inflight.clear();
+            inflight.swap(outbound);
+            fd = clientSocket;
+        }
+        
+        size_t sent = 0;
+        while (sent < inflight.size()) {
+            int result = co_await eventLoop->send(fd, inflight.data() + sent, inflight.size() - sent);
+            if (result <= 0) {
+                if (result < 0 && result != -ECANCELED && connected) {
+                    Logger::error(Logger::concat({"Failed to send packet data to ", getIP(), ". Error: ", std::to_string(-result)}));
+                }
+                std::lock_guard<std::mutex> lock(sendMutex);
+                flushScheduled = false;
+                disconnect();
+                co_return;
+            }
+            sent += static_cast<size_t>(result);
+        }
+    }
+}
+
+Task<bool> Client::asyncSendPacket(const std::vector<uint8_t>& packet) {
+    if (!sendPacket(packet)) {
+        co_return false;
+    }
+    if (usesRing()) {
+        co_return true;
+    }
+    
+    // Complete once everything queued so far has reached the kernel
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (outboundOffset == outbound.size()) co_return true;
+            if (!connected || clientSocket == INVALID_SOCKET) co_return false;
+            if (!flushOutboundLocked()) {
+                disconnect();
+                co_return false;
+            }
+            if (outboundOffset == outbound.size()) co_return true;
+        }
+        
+        if (!co_await eventLoop->writable(clientSocket)) {
+            co_return false;
+        }
+    }
+}
+
+Task<std::vector<uint8_t>> Client::asyncReceivePacket(std::optional<EventLoop::Clock::time_point> deadline) {
+    while (connected) {
+        // Hand out a complete buffered frame first
+        size_t available = inbound.size() - inboundOffset;
+        if (available >= sizeof(uint32_t)) {
+            uint32_t packetLength = 0;
+            std::memcpy(&packetLength, inbound.data() + inboundOffset, sizeof(packetLength));
+            
+            if (packetLength > connectionLimits.maxPacketSize) {
+                Logger::error(Logger::concat({"Packet too large from ", getIP(), ": ", std::to_string(packetLength)}));
+                disconnect();
+                break;
+            }
+            
+            if (available >= sizeof(uint32_t) + packetLength) {
+                TRACE_SCOPE_ID("receivePacket", connectionID);
+                auto begin = inbound.begin() + inboundOffset + sizeof(uint32_t);
+                std::vector<uint8_t> packet(begin, begin + packetLength);
+                inboundOffset += sizeof(uint32_t) + packetLength;
+                if (inboundOffset == inbound.size()) {
+                    inbound.clear();
+                    inboundOffset = 0;
+                }
+                
+                TrafficCapture::recordFrame(connectionID, packet);
+                co_return packet;
+            }
+        }
+        
+        // Need more bytes
+        if (inboundOffset > 0) {
+            inbound.erase(inbound.begin(), inbound.begin() + inboundOffset);
+            inboundOffset = 0;
+        }
+        
+        if (usesRing()) {
+            ssize_t received = co_await eventLoop->receive(clientSocket, inbound, deadline);
+            if (received > 0) continue;
+            if (received == 0) {
+                Logger::info(Logger::concat({"Client ", getIP(), " disconnected gracefully"}));
+            } else if (received == -ETIMEDOUT || received == -ECANCELED) {
+                break; // Deadline passed or the loop is stopping
+            } else if (connected) {
+                Logger::error(Logger::concat({"Error receiving packet from ", getIP(), ". Error: ", std::to_string(-received)}));
+            }
+            disconnect();
+            break;
+        }
+        size_t previousSize = inbound.size();
+        inbound.resize(previousSize + connectionLimits.receiveChunkSize);
+        ssize_t received = recv(clientSocket, inbound.data() + previousSize, connectionLimits.receiveChunkSize, MSG_DONTWAIT);
+        inbound.resize(previousSize + (received > 0 ? static_cast<size_t>(received) : 0));
+        
+        if (received > 0) continue;
+        
+        if (received == 0) {
+            Logger::info(Logger::concat({"Client ", getIP(), " disconnected gracefully"}));
+            disconnect();
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!co_await eventLoop->readable(clientSocket, deadline)) {
+                break; // Deadline passed or the loop is stopping
+            }
+            continue;
+        }
+        
+        if (connected) {
+            Logger::error(Logger::concat({"Error receiving packet from ", getIP(), ". Error: ", std::to_string(SOCKET_ERROR_CODE)}));
+        }
+        disconnect();
+        break;
+    }
+    
+    co_return std::vector<uint8_t>();
+}
+#endif
@@ -20,36 +20,150 @@
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include "SessionArena.h"
 
-class Client {
+#ifdef __linux__
+    #include "EventLoop.h"
+    #include "Task.h"
+    #include "HotRestart.h"
+#endif
+
+class SerialExecutor;
+class World;
+
+// Buffer limits shared by every connection
+struct ConnectionLimits {
+    uint32_t maxPacketSize = 1024 * 1024;       // Largest frame accepted from a client
+    size_t maxOutboundBytes = 4 * 1024 * 1024;  // Unsent bytes a slow reader may pile up before it is dropped
+    size_t receiveChunkSize = 16 * 1024;        // Bytes requested per non-blocking recv
+};
+
+class Client : public std::enable_shared_from_this<Client> {
 private:
+    // Holds the strings and buffers below; declared first so it outlives them
+    SessionArena arena;
+    
     socket_t clientSocket;
-    std::string ipAddress;
+    uint32_t connectionID;
+    std::pmr::string ipAddress;
     std::atomic<bool> connected;
     std::mutex sendMutex;
     
     // Player data
-    std::string playerName;
+    std::pmr::string playerName;
     int playerID;
+    bool authenticated;
+    bool inLoginQueue;   // Waiting for a player slot; session executor only
     int worldX, worldY;
     
+    // Game logic for this session runs in order on its own executor;
+    // `world` is only read and written from that executor.
+    std::shared_ptr<SerialExecutor> sessionExecutor;
+    std::shared_ptr<World> world;
+    
+#ifdef __linux__
+    // Event-loop mode: the socket is non-blocking and only closed by the loop.
+    // `inbound` belongs to the loop thread, `outbound` is guarded by sendMutex.
+    EventLoop* eventLoop;
+    std::mutex socketMutex;
+    std::pmr::vector<uint8_t> inbound;
+    size_t inboundOffset;
+    std::pmr::vector<uint8_t> outbound;
+    size_t outboundOffset;
+    bool flushScheduled;
+    
+    // io_uring backend: bytes handed to the kernel by the current send,
+    // swapped out of `outbound` (loop thread only)
+    std::pmr::vector<uint8_t> inflight;
+    
+    bool usesRing() const { return eventLoop->getBackend() == EventLoop::Backend::IO_URING; }
+    bool queuePacket(std::span<const uint8_t> packet);
+    bool flushOutboundLocked();
+    void scheduleFlushLocked();
+    Task<void> flushWhenWritable();
+    Task<void> flushThroughRing();
+#endif
+    
+protected:
+    // For subclasses' own session-lifetime state
+    std::pmr::memory_resource* getArena() { return &arena; }
+    
 public:
     Client(socket_t socket, const std::string& ip);
-    ~Client();
+    virtual ~Client();
+    
+    // Applies to every connection; set before the server starts
+    static void setLimits(const ConnectionLimits& newLimits);
+    static const ConnectionLimits& getLimits();
     
     bool isConnected() const;
-    void disconnect();
+    virtual void disconnect();
     
     std::vector<uint8_t> receivePacket();
-    bool sendPacket(const std::vector<uint8_t>& packet);
+    virtual bool sendPacket(std::span<const uint8_t> packet);
+    
+    // For frames the next one supersedes, such as movement. Datagram
+    // transports may drop them rather than hold up later frames; stream
+    // connections deliver them like any other.
+    virtual bool sendUnreliable(std::span<const uint8_t> packet) { return sendPacket(packet); }
+    
+    // Bytes this session holds: the object itself plus everything it has
+    // allocated from its arena. Subclasses add their own queues.
+    virtual size_t getMemoryUsage() const { return sizeof(Client) + arena.getBytesInUse(); }
+    
+    // Drops bytes the peer already sent, so that closing right after a
+    // final message doesn't reset the connection and lose the message
+    void discardReceived();
+    
+#ifdef __linux__
+    // Switches the socket to non-blocking mode owned by `loop` (loop thread only)
+    bool attachEventLoop(EventLoop& loop);
+    
+    // Awaitable I/O for coroutine sessions; both must run on the loop thread.
+    // receive returns an empty frame on disconnect, deadline or loop shutdown.
+    // With the io_uring backend, send completes once the frame is queued;
+    // the loop keeps sends to the socket in order.
+    Task<std::vector<uint8_t>> asyncReceivePacket(std::optional<EventLoop::Clock::time_point> deadline = std::nullopt);
+    Task<bool> asyncSendPacket(const std::vector<uint8_t>& packet);
+    
+    // Unregisters and closes the socket once the session has ended
+    void closeSocket();
+    
+    // Hot restart (loop thread): copies buffered I/O into the snapshot, then,
+    // once the successor has a copy of the descriptor, gives it up without
+    // shutting the connection down
+    void exportPending(SessionSnapshot& snapshot);
+    socket_t getSocket() const { return clientSocket; }
+    socket_t releaseSocket();
+    
+    // Restores buffered I/O from a previous process; call before attachEventLoop
+    void importPending(const SessionSnapshot& snapshot);
+#endif
     
     // Getters
-    const std::string& getIP() const { return ipAddress; }
-    const std::string& getPlayerName() const { return playerName; }
+    uint32_t getConnectionID() const { return connectionID; }
+    // Views into the session's own strings; copy them to keep them past the session
+    std::string_view getIP() const { return ipAddress; }
+    std::string_view getPlayerName() const { return playerName; }
     int getPlayerID() const { return playerID; }
+    bool isAuthenticated() const { return authenticated; }
+    bool isInLoginQueue() const { return inLoginQueue; }
+    int getWorldX() const { return worldX; }
+    int getWorldY() const { return worldY; }
+    const std::shared_ptr<SerialExecutor>& getSessionExecutor() const { return sessionExecutor; }
+    const std::shared_ptr<World>& getWorld() const { return world; }
     
     // Setters
     void setPlayerName(const std::string& name) { playerName = name; }
     void setPlayerID(int id) { playerID = id; }
+    void setAuthenticated(bool value) { authenticated = value; }
+    void setInLoginQueue(bool value) { inLoginQueue = value; }
     void setPosition(int x, int y) { worldX = x; worldY = y; }
+    void setSessionExecutor(std::shared_ptr<SerialExecutor> executor) { sessionExecutor = std::move(executor); }
+    void setWorld(std::shared_ptr<World> newWorld) { world = std::move(newWorld); }
 };
\ No newline at end of file
@@ -0,0 +1,646 @@
+#include "EventLoop.h"
+#include "IoUring.h"
+#include "../utils/Logger.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+
+namespace {
+    const int MAX_EVENTS = 256;
+    
+    // Upper bound on shutdown passes; each pass resumes whatever re-awaited
+    const int MAX_SHUTDOWN_PASSES = 16;
+    
+    // io_uring sizing: SQ entries, and the default provided-buffer pool
+    // multishot receives land in (one buffer per completion, recycled right
+    // after the bytes are copied to the socket's pending data)
+    const unsigned RING_ENTRIES = 1024;
+    const uint16_t RECEIVE_BUFFER_GROUP = 0;
+    const unsigned RECEIVE_BUFFER_COUNT = 256;
+    const size_t RECEIVE_BUFFER_SIZE = 16 * 1024;
+    
+    // Received bytes a socket may hold before its multishot receive is
+    // paused until the session catches up
+    const size_t MAX_PENDING_RECEIVE = 1024 * 1024;
+    
+    // How long shutdown waits for cancelled ring operations to complete
+    const auto RING_DRAIN_TIMEOUT = std::chrono::seconds(1);
+}
+
+EventLoop::EventLoop()
+    : backend(Backend::EPOLL), epollFd(-1), wakeFd(-1), nextSocketGeneration(1), operationsInFlight(0),
+      multishotAccept(true), multishotReceive(true), receiveBufferCount(RECEIVE_BUFFER_COUNT),
+      receiveBufferSize(RECEIVE_BUFFER_SIZE), stopping(false), nextTimerSequence(0) {
+}
+
+void EventLoop::setReceiveBuffers(unsigned count, size_t size) {
+    receiveBufferCount = count;
+    receiveBufferSize = size;
+}
+
+EventLoop::~EventLoop() {
+    // Closing the ring cancels anything still in flight
+    ring.reset();
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool EventLoop::initialize(Backend preferred) {
+    if (preferred == Backend::IO_URING) {
+        if (initializeRing()) {
+            backend = Backend::IO_URING;
+            return true;
+        }
+        Logger::warning("io_uring unavailable, falling back to epoll");
+        ring.reset();
+        if (wakeFd >= 0) {
+            close(wakeFd);
+            wakeFd = -1;
+        }
+    }
+    backend = Backend::EPOLL;
+    
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        Logger::error("epoll_create1 failed. Error: " + std::to_string(errno));
+        return false;
+    }
+    
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        Logger::error("eventfd failed. Error: " + std::to_string(errno));
+        return false;
+    }
+    
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) {
+        Logger::error("Failed to register eventfd. Error: " + std::to_string(errno));
+        return false;
+    }
+    
+    return true;
+}
+
+bool EventLoop::initializeRing() {
+    ring = std::make_unique<IoUring>();
+    if (!ring->initialize(RING_ENTRIES)) {
+        return false;
+    }
+    
+    if (!ring->supportsOps({IORING_OP_POLL_ADD, IORING_OP_ACCEPT, IORING_OP_RECV,
+                            IORING_OP_SEND, IORING_OP_ASYNC_CANCEL})) {
+        Logger::warning("io_uring lacks the operations the event loop needs");
+        return false;
+    }
+    
+    // Also fails on kernels before 5.19, which lack fd-based cancellation too
+    if (!ring->setupBuffers(RECEIVE_BUFFER_GROUP, receiveBufferCount, receiveBufferSize)) {
+        return false;
+    }
+    
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        Logger::error("eventfd failed. Error: " + std::to_string(errno));
+        return false;
+    }
+    
+    // Posted callbacks: one multishot poll on the eventfd for the loop's life
+    io_uring_sqe* sqe = prepareOperation(new Operation{Operation::Kind::WAKE, wakeFd, 0, nullptr}, IORING_OP_POLL_ADD);
+    if (!sqe) {
+        return false;
+    }
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    return ring->submit() >= 0;
+}
+
+void EventLoop::post(std::function<void()> callback) {
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        wasEmpty = posted.empty();
+        posted.push_back(std::move(callback));
+    }
+    
+    // A non-empty queue already has a wakeup pending
+    if (!wasEmpty) return;
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+void EventLoop::stop() {
+    stopping = true;
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+bool EventLoop::registerSocket(int fd) {
+    if (backend == Backend::IO_URING) {
+        // Operations are submitted lazily by whichever awaiter needs them
+        SocketWaiters& socket = sockets[fd];
+        socket.generation = nextSocketGeneration++;
+        return true;
+    }
+    
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        Logger::error("Failed to register socket with epoll. Error: " + std::to_string(errno));
+        return false;
+    }
+    sockets[fd];
+    return true;
+}
+
+void EventLoop::unregisterSocket(int fd) {
+    auto it = sockets.find(fd);
+    
+    if (backend == Backend::IO_URING) {
+        if (it == sockets.end()) return;
+        
+        // Cancel now, while the descriptor still names this socket; the
+        // completions that follow no longer match a registered socket
+        if (io_uring_sqe* sqe = ring->getSqe()) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->fd = fd;
+            sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+            ring->submit();
+        }
+    } else {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        if (it == sockets.end()) return;
+    }
+    
+    // Anyone still waiting on this socket is told it is gone
+    SocketWaiters waiters = std::move(it->second);
+    sockets.erase(it);
+    for (int accepted : waiters.accepted) {
+        close(accepted);
+    }
+    completeAll(waiters.readers, false);
+    completeAll(waiters.writers, false);
+    completeAll(waiters.receivers, false);
+}
+
+EventLoop::SocketWaiters* EventLoop::findSocket(int fd, uint64_t generation) {
+    auto it = sockets.find(fd);
+    if (it == sockets.end() || it->second.generation != generation) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void EventLoop::IoAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>();
+    waiter->handle = handle;
+    
+    auto it = loop.sockets.find(fd);
+    if (it == loop.sockets.end()) {
+        // Not registered (already closed): resume as not ready on the next tick
+        auto pending = waiter;
+        loop.post([this_loop = &loop, pending] { this_loop->complete(pending, false); });
+        return;
+    }
+    
+    auto& waiters = forWrite ? it->second.writers : it->second.readers;
+    
+    // Drop waiters that already timed out so idle sockets don't accumulate them
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                 [](const std::shared_ptr<Waiter>& w) { return w->done; }),
+                  waiters.end());
+    waiters.push_back(waiter);
+    if (deadline) {
+        loop.timers.push({*deadline, loop.nextTimerSequence++, waiter});
+    }
+    
+    if (loop.backend == Backend::IO_URING) {
+        loop.armPoll(fd, it->second, forWrite);
+    }
+}
+
+bool EventLoop::AcceptAwaiter::await_ready() {
+    if (loop.stopping) return true;
+    auto it = loop.sockets.find(fd);
+    if (it == loop.sockets.end()) return true;
+    generation = it->second.generation;
+    return it->second.hasResult();
+}
+
+void EventLoop::AcceptAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>();
+    waiter->handle = handle;
+    
+    SocketWaiters& socket = loop.sockets[fd];
+    socket.receivers.push_back(waiter);
+    loop.armReceive(fd, socket, true);
+}
+
+int EventLoop::AcceptAwaiter::await_resume() {
+    SocketWaiters* socket = loop.findSocket(fd, generation);
+    if (!socket) {
+        return loop.stopping ? -ECANCELED : -EBADF;
+    }
+    if (!socket->accepted.empty()) {
+        int accepted = socket->accepted.front();
+        socket->accepted.pop_front();
+        return accepted;
+    }
+    if (socket->receiveError) {
+        int error = socket->receiveError;
+        socket->receiveError = 0;
+        return -error;
+    }
+    return -ECANCELED;
+}
+
+bool EventLoop::ReceiveAwaiter::await_ready() {
+    if (loop.stopping) return true;
+    auto it = loop.sockets.find(fd);
+    if (it == loop.sockets.end()) return true;
+    generation = it->second.generation;
+    return it->second.hasResult();
+}
+
+void EventLoop::ReceiveAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>();
+    waiter->handle = handle;
+    
+    SocketWaiters& socket = loop.sockets[fd];
+    auto& waiters = socket.receivers;
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                 [](const std::shared_ptr<Waiter>& w) { return w->done; }),
+                  waiters.end());
+    waiters.push_back(waiter);
+    if (deadline) {
+        loop.timers.push({*deadline, loop.nextTimerSequence++, waiter});
+    }
+    loop.armReceive(fd, socket, false);
+}
+
+ssize_t EventLoop::ReceiveAwaiter::await_resume() {
+    SocketWaiters* socket = loop.findSocket(fd, generation);
+    if (!socket) {
+        return loop.stopping ? -ECANCELED : -EBADF;
+    }
+    if (!socket->received.empty()) {
+        ssize_t count = static_cast<ssize_t>(socket->received.size());
+        // Copied rather than swapped: `dest` may draw on a session's arena
+        dest.insert(dest.end(), socket->received.begin(), socket->received.end());
+        socket->received.clear();
+        return count;
+    }
+    if (socket->receiveError) {
+        return -socket->receiveError;
+    }
+    if (socket->receiveClosed) {
+        return 0;
+    }
+    return loop.stopping ? -ECANCELED : -ETIMEDOUT;
+}
+
+void EventLoop::SendAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>();
+    waiter->handle = handle;
+    
+    io_uring_sqe* sqe = loop.prepareOperation(new Operation{Operation::Kind::SEND, fd, 0, waiter}, IORING_OP_SEND);
+    if (!sqe) {
+        waiter->result = -EAGAIN;
+        auto pending = waiter;
+        loop.post([this_loop = &loop, pending] { this_loop->complete(pending, true); });
+        return;
+    }
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(length);
+    sqe->msg_flags = MSG_NOSIGNAL;
+}
+
+void EventLoop::SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    waiter = std::make_shared<Waiter>();
+    waiter->handle = handle;
+    loop.timers.push({deadline, loop.nextTimerSequence++, waiter});
+}
+
+void EventLoop::complete(const std::shared_ptr<Waiter>& waiter, bool ready) {
+    if (waiter->done) return;
+    waiter->done = true;
+    waiter->ready = ready;
+    waiter->handle.resume();
+}
+
+void EventLoop::completeAll(std::vector<std::shared_ptr<Waiter>>& waiters, bool ready) {
+    // Resumed coroutines may register new waiters, so detach the list first
+    std::vector<std::shared_ptr<Waiter>> current;
+    current.swap(waiters);
+    for (auto& waiter : current) {
+        complete(waiter, ready);
+    }
+}
+
+void EventLoop::runPosted() {
+    uint64_t counter;
+    while (read(wakeFd, &counter, sizeof(counter)) > 0) {}
+    
+    std::vector<std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        callbacks.swap(posted);
+    }
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
+
+void EventLoop::fireExpiredTimers() {
+    auto now = Clock::now();
+    while (!timers.empty() && timers.top().deadline <= now) {
+        auto waiter = timers.top().waiter;
+        timers.pop();
+        // Socket waiters that timed out stay in their list until the next
+        // event on that socket; complete() ignores them once done
+        complete(waiter, false);
+    }
+}
+
+int EventLoop::nextTimeoutMs() const {
+    if (timers.empty()) return -1;
+    
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(timers.top().deadline - Clock::now());
+    if (remaining.count() <= 0) return 0;
+    return static_cast<int>(remaining.count()) + 1;
+}
+
+void EventLoop::run() {
+    loopThread = std::this_thread::get_id();
+    
+    if (backend == Backend::IO_URING) {
+        runRing();
+    } else {
+        runEpoll();
+    }
+    
+    cancelAllWaiters();
+}
+
+void EventLoop::runEpoll() {
+    epoll_event events[MAX_EVENTS];
+    
+    while (!stopping) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, nextTimeoutMs());
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            Logger::error("epoll_wait failed. Error: " + std::to_string(errno));
+            break;
+        }
+        
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                runPosted();
+                continue;
+            }
+            
+            auto it = sockets.find(fd);
+            if (it == sockets.end()) continue;
+            
+            uint32_t flags = events[i].events;
+            bool failed = (flags & (EPOLLERR | EPOLLHUP)) != 0;
+            if (flags & (EPOLLIN | EPOLLRDHUP) || failed) {
+                completeAll(it->second.readers, true);
+            }
+            
+            // The reader may have unregistered the socket
+            it = sockets.find(fd);
+            if (it != sockets.end() && (flags & EPOLLOUT || failed)) {
+                completeAll(it->second.writers, true);
+            }
+        }
+        
+        fireExpiredTimers();
+    }
+}
+
+void EventLoop::runRing() {
+    auto handle = [this](const io_uring_cqe& cqe) { handleCompletion(cqe); };
+    
+    while (!stopping) {
+        // Everything coroutines queued since the last pass goes out here
+        if (ring->submitAndWait(nextTimeoutMs()) < 0) {
+            break;
+        }
+        ring->drainCompletions(handle);
+        fireExpiredTimers();
+    }
+}
+
+io_uring_sqe* EventLoop::prepareOperation(Operation* operation, uint8_t opcode) {
+    io_uring_sqe* sqe = ring->getSqe();
+    if (!sqe) {
+        Logger::error("io_uring submission queue is full");
+        delete operation;
+        return nullptr;
+    }
+    
+    sqe->opcode = opcode;
+    sqe->fd = operation->fd;
+    sqe->user_data = reinterpret_cast<uint64_t>(operation);
+    ++operationsInFlight;
+    return sqe;
+}
+
+void EventLoop::armPoll(int fd, SocketWaiters& socket, bool forWrite) {
+    bool& polling = forWrite ? socket.pollingWrite : socket.pollingRead;
+    if (polling || stopping) return;
+    
+    auto kind = forWrite ? Operation::Kind::POLL_WRITE : Operation::Kind::POLL_READ;
+    io_uring_sqe* sqe = prepareOperation(new Operation{kind, fd, socket.generation, nullptr}, IORING_OP_POLL_ADD);
+    if (!sqe) return;
+    sqe->poll32_events = forWrite ? POLLOUT : (POLLIN | POLLRDHUP);
+    polling = true;
+}
+
+void EventLoop::armReceive(int fd, SocketWaiters& socket, bool accepting) {
+    if (socket.receiving || stopping) return;
+    
+    if (accepting) {
+        io_uring_sqe* sqe = prepareOperation(new Operation{Operation::Kind::ACCEPT, fd, socket.generation, nullptr}, IORING_OP_ACCEPT);
+        if (!sqe) return;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        if (multishotAccept) {
+            sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+        }
+    } else {
+        io_uring_sqe* sqe = prepareOperation(new Operation{Operation::Kind::RECEIVE, fd, socket.generation, nullptr}, IORING_OP_RECV);
+        if (!sqe) return;
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = RECEIVE_BUFFER_GROUP;
+        if (multishotReceive) {
+            sqe->ioprio |= IORING_RECV_MULTISHOT;
+        }
+    }
+    socket.receiving = true;
+}
+
+void EventLoop::handleCompletion(const io_uring_cqe& cqe) {
+    auto* operation = reinterpret_cast<Operation*>(cqe.user_data);
+    if (!operation) {
+        return; // Cancellation requests
+    }
+    
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    
+    switch (operation->kind) {
+        case Operation::Kind::WAKE:
+            runPosted();
+            if (!more && !stopping) {
+                // The kernel may end a multishot poll at any time
+                io_uring_sqe* sqe = prepareOperation(new Operation{Operation::Kind::WAKE, wakeFd, 0, nullptr}, IORING_OP_POLL_ADD);
+                if (sqe) {
+                    sqe->poll32_events = POLLIN;
+                    sqe->len = IORING_POLL_ADD_MULTI;
+                }
+            }
+            break;
+            
+        case Operation::Kind::POLL_READ:
+        case Operation::Kind::POLL_WRITE: {
+            SocketWaiters* socket = findSocket(operation->fd, operation->generation);
+            if (!socket) break;
+            if (operation->kind == Operation::Kind::POLL_WRITE) {
+                socket->pollingWrite = false;
+                completeAll(socket->writers, true);
+            } else {
+                socket->pollingRead = false;
+                completeAll(socket->readers, true);
+            }
+            break;
+        }
+            
+        case Operation::Kind::ACCEPT:
+        case Operation::Kind::RECEIVE:
+            handleReceive(operation, cqe);
+            break;
+            
+        case Operation::Kind::SEND:
+            operation->waiter->result = cqe.res;
+            complete(operation->waiter, true);
+            break;
+    }
+    
+    if (!more) {
+        --operationsInFlight;
+        delete operation;
+    }
+}
+
+void EventLoop::handleReceive(Operation* operation, const io_uring_cqe& cqe) {
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    bool accepting = operation->kind == Operation::Kind::ACCEPT;
+    SocketWaiters* socket = findSocket(operation->fd, operation->generation);
+    
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        // Copy out and hand the buffer straight back to the pool
+        uint16_t bufferID = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (socket && cqe.res > 0) {
+            const uint8_t* data = ring->getBuffer(bufferID);
+            socket->received.insert(socket->received.end(), data, data + cqe.res);
+        }
+        ring->recycleBuffer(bufferID);
+    }
+    
+    if (!socket) {
+        // Late completion for a socket that was unregistered
+        if (accepting && cqe.res >= 0) {
+            close(cqe.res);
+        }
+        return;
+    }
+    
+    bool& multishot = accepting ? multishotAccept : multishotReceive;
+    if (cqe.res == -EINVAL && multishot && !more) {
+        Logger::warning(std::string("Kernel lacks multishot ") + (accepting ? "accept" : "receive") + ", using single-shot operations");
+        multishot = false;
+    } else if (accepting && cqe.res >= 0) {
+        socket->accepted.push_back(cqe.res);
+    } else if (!accepting && cqe.res == 0) {
+        socket->receiveClosed = true;
+    } else if (cqe.res < 0 && cqe.res != -ECANCELED && cqe.res != -ENOBUFS) {
+        // -ENOBUFS only means the buffer pool ran dry; the receive is re-armed
+        socket->receiveError = -cqe.res;
+    }
+    
+    if (!more) {
+        socket->receiving = false;
+    } else if (!accepting && socket->received.size() >= MAX_PENDING_RECEIVE && !operation->cancelling) {
+        // The session is behind: stop pulling data in until it catches up
+        if (io_uring_sqe* sqe = ring->getSqe()) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = reinterpret_cast<uint64_t>(operation);
+            operation->cancelling = true;
+        }
+    }
+    
+    if (socket->hasResult()) {
+        completeAll(socket->receivers, true);
+    } else if (!socket->receivers.empty()) {
+        armReceive(operation->fd, *socket, accepting);
+    }
+}
+
+void EventLoop::cancelRingOperations() {
+    if (io_uring_sqe* sqe = ring->getSqe()) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL;
+    }
+    
+    // Senders must not resume before the kernel is done with their data
+    auto handle = [this](const io_uring_cqe& cqe) { handleCompletion(cqe); };
+    auto giveUp = Clock::now() + RING_DRAIN_TIMEOUT;
+    while (operationsInFlight > 0 && Clock::now() < giveUp) {
+        if (ring->submitAndWait(50) < 0) break;
+        ring->drainCompletions(handle);
+    }
+}
+
+void EventLoop::cancelAllWaiters() {
+    if (backend == Backend::IO_URING) {
+        cancelRingOperations();
+    }
+    
+    // Let suspended coroutines observe the shutdown and unwind
+    for (int pass = 0; pass < MAX_SHUTDOWN_PASSES; ++pass) {
+        runPosted();
+        
+        std::vector<std::shared_ptr<Waiter>> pending;
+        for (auto& entry : sockets) {
+            pending.insert(pending.end(), entry.second.readers.begin(), entry.second.readers.end());
+            pending.insert(pending.end(), entry.second.writers.begin(), entry.second.writers.end());
+            pending.insert(pending.end(), entry.second.receivers.begin(), entry.second.receivers.end());
+            entry.second.readers.clear();
+            entry.second.writers.clear();
+            entry.second.receivers.clear();
+        }
+        while (!timers.empty()) {
+            pending.push_back(timers.top().waiter);
+            timers.pop();
+        }
+        
+        bool resumedAny = false;
+        for (auto& waiter : pending) {
+            if (!waiter->done) resumedAny = true;
+            complete(waiter, false);
+        }
+        if (!resumedAny) {
+            std::lock_guard<std::mutex> lock(postedMutex);
+            if (posted.empty()) break;
+        }
+    }
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <coroutine>
+#include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <optional>
+#include <deque>
+#include <cerrno>
+#include <sys/types.h>
+
+class IoUring;
+struct io_uring_cqe;
+struct io_uring_sqe;
+
+// Single-threaded reactor that resumes coroutines when their socket is
+// ready or their timer expires. Sockets are registered edge-triggered, so a
+// coroutine must try its recv/send first and only await after EAGAIN.
+//
+// With the io_uring backend the loop also completes I/O itself: accept()
+// and receive() are fed by one multishot operation per socket that lands
+// data in a provided-buffer pool, and send() is a single ring operation.
+// Submissions queue up while coroutines run and go to the kernel in one
+// io_uring_enter per loop iteration.
+//
+// Everything except post() and stop() must be called on the loop thread.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    enum class Backend {
+        EPOLL,
+        IO_URING
+    };
+    
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        bool done = false;
+        bool ready = false; // false when woken by a timeout or shutdown
+        int result = 0;     // io_uring send result
+    };
+    
+    struct SocketWaiters {
+        std::vector<std::shared_ptr<Waiter>> readers;
+        std::vector<std::shared_ptr<Waiter>> writers;
+        
+        // io_uring mode. `generation` tells a reused descriptor apart from
+        // the socket an operation was submitted for.
+        uint64_t generation = 0;
+        std::vector<std::shared_ptr<Waiter>> receivers;
+        std::deque<int> accepted;
+        std::vector<uint8_t> received;
+        int receiveError = 0;
+        bool receiveClosed = false;
+        bool receiving = false;
+        bool pollingRead = false;
+        bool pollingWrite = false;
+        
+        bool hasResult() const {
+            return !accepted.empty() || !received.empty() || receiveError != 0 || receiveClosed;
+        }
+    };
+    
+    // Identifies an in-flight ring operation through its user_data
+    struct Operation {
+        enum class Kind {
+            WAKE,
+            POLL_READ,
+            POLL_WRITE,
+            ACCEPT,
+            RECEIVE,
+            SEND
+        };
+        
+        Kind kind;
+        int fd;
+        uint64_t generation;
+        std::shared_ptr<Waiter> waiter; // SEND only
+        bool cancelling = false;
+    };
+    
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t sequence;
+        std::shared_ptr<Waiter> waiter;
+        
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+    
+    Backend backend;
+    int epollFd;
+    int wakeFd;
+    std::unique_ptr<IoUring> ring;
+    uint64_t nextSocketGeneration;
+    size_t operationsInFlight;
+    bool multishotAccept;
+    bool multishotReceive;
+    unsigned receiveBufferCount;
+    size_t receiveBufferSize;
+    std::atomic<bool> stopping;
+    std::thread::id loopThread;
+    
+    std::unordered_map<int, SocketWaiters> sockets;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t nextTimerSequence;
+    
+    std::mutex postedMutex;
+    std::vector<std::function<void()>> posted;
+    
+    void complete(const std::shared_ptr<Waiter>& waiter, bool ready);
+    void completeAll(std::vector<std::shared_ptr<Waiter>>& waiters, bool ready);
+    void runPosted();
+    void fireExpiredTimers();
+    int nextTimeoutMs() const;
+    void cancelAllWaiters();
+    
+    bool initializeRing();
+    void runEpoll();
+    void runRing();
+    io_uring_sqe* prepareOperation(Operation* operation, uint8_t opcode);
+    void armReceive(int fd, SocketWaiters& socket, bool accepting);
+    void armPoll(int fd, SocketWaiters& socket, bool forWrite);
+    void handleCompletion(const io_uring_cqe& cqe);
+    void handleReceive(Operation* operation, const io_uring_cqe& cqe);
+    void cancelRingOperations();
+    SocketWaiters* findSocket(int fd, uint64_t generation);
+    
+public:
+    // Resumes with true when the socket is ready, false on timeout or shutdown
+    class IoAwaiter {
+    private:
+        EventLoop& loop;
+        int fd;
+        bool forWrite;
+        std::optional<Clock::time_point> deadline;
+        std::shared_ptr<Waiter> waiter;
+        
+    public:
+        IoAwaiter(EventLoop& loop, int fd, bool forWrite, std::optional<Clock::time_point> deadline)
+            : loop(loop), fd(fd), forWrite(forWrite), deadline(deadline) {}
+        
+        bool await_ready() const noexcept { return loop.stopping; }
+        void await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const noexcept { return waiter && waiter->ready; }
+    };
+    
+    // Resumes with true after the duration, false if the loop is shutting down
+    class SleepAwaiter {
+    private:
+        EventLoop& loop;
+        Clock::time_point deadline;
+        std::shared_ptr<Waiter> waiter;
+        
+    public:
+        SleepAwaiter(EventLoop& loop, Clock::time_point deadline) : loop(loop), deadline(deadline) {}
+        
+        bool await_ready() const noexcept { return loop.stopping; }
+        void await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const noexcept { return waiter && waiter->ready; }
+    };
+    
+    // io_uring only: resumes with an accepted descriptor or -errno
+    // (-ECANCELED on shutdown, -EBADF once the listener is unregistered)
+    class AcceptAwaiter {
+    private:
+        EventLoop& loop;
+        int fd;
+        uint64_t generation;
+        std::shared_ptr<Waiter> waiter;
+        
+    public:
+        AcceptAwaiter(EventLoop& loop, int fd) : loop(loop), fd(fd), generation(0) {}
+        
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> handle);
+        int await_resume();
+    };
+    
+    // io_uring only: appends whatever arrived on the socket to `dest` and
+    // resumes with the byte count, 0 at end of stream or -errno
+    // (-ETIMEDOUT at the deadline, -ECANCELED on shutdown)
+    class ReceiveAwaiter {
+    private:
+        EventLoop& loop;
+        int fd;
+        std::pmr::vector<uint8_t>& dest;
+        std::optional<Clock::time_point> deadline;
+        uint64_t generation;
+        std::shared_ptr<Waiter> waiter;
+        
+    public:
+        ReceiveAwaiter(EventLoop& loop, int fd, std::pmr::vector<uint8_t>& dest, std::optional<Clock::time_point> deadline)
+            : loop(loop), fd(fd), dest(dest), deadline(deadline), generation(0) {}
+        
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> handle);
+        ssize_t await_resume();
+    };
+    
+    // io_uring only: resumes with bytes sent or -errno. The data must stay
+    // alive until then; the kernel may read it after the coroutine suspends.
+    class SendAwaiter {
+    private:
+        EventLoop& loop;
+        int fd;
+        const uint8_t* data;
+        size_t length;
+        std::shared_ptr<Waiter> waiter;
+        
+    public:
+        SendAwaiter(EventLoop& loop, int fd, const uint8_t* data, size_t length)
+            : loop(loop), fd(fd), data(data), length(length) {}
+        
+        bool await_ready() const noexcept { return loop.stopping; }
+        void await_suspend(std::coroutine_handle<> handle);
+        int await_resume() const noexcept { return waiter ? waiter->result : -ECANCELED; }
+    };
+    
+    EventLoop();
+    ~EventLoop();
+    
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    
+    // Falls back to epoll (with a warning) when io_uring is requested but the
+    // kernel can't provide what the backend needs
+    bool initialize(Backend preferred = Backend::EPOLL);
+    Backend getBackend() const { return backend; }
+    
+    // io_uring provided-buffer pool; `count` must be a power of two.
+    // Call before initialize().
+    void setReceiveBuffers(unsigned count, size_t size);
+    
+    // Runs until stop(); on exit every pending awaiter is resumed with false
+    void run();
+    void stop();
+    bool isStopping() const { return stopping; }
+    bool isLoopThread() const { return std::this_thread::get_id() == loopThread; }
+    
+    // Queues a callback to run on the loop thread
+    void post(std::function<void()> callback);
+    
+    bool registerSocket(int fd);
+    void unregisterSocket(int fd);
+    
+    IoAwaiter readable(int fd, std::optional<Clock::time_point> deadline = std::nullopt) {
+        return IoAwaiter(*this, fd, false, deadline);
+    }
+    IoAwaiter writable(int fd, std::optional<Clock::time_point> deadline = std::nullopt) {
+        return IoAwaiter(*this, fd, true, deadline);
+    }
+    SleepAwaiter sleep(Clock::duration duration) {
+        return SleepAwaiter(*this, Clock::now() + duration);
+    }
+    
+    AcceptAwaiter accept(int listenFd) {
+        return AcceptAwaiter(*this, listenFd);
+    }
+    ReceiveAwaiter receive(int fd, std::pmr::vector<uint8_t>& dest, std::optional<Clock::time_point> deadline = std::nullopt) {
+        return ReceiveAwaiter(*this, fd, dest, deadline);
+    }
+    SendAwaiter send(int fd, const uint8_t* data, size_t length) {
+        return SendAwaiter(*this, fd, data, length);
+    }
+};
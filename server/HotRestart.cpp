@@ -0,0 +1,302 @@
+#include "HotRestart.h"
+#include "WireFormat.h"
+#include "../utils/Logger.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+namespace {
+    // Largest message either side handles; sessions whose buffers don't fit
+    // in one (or in the smaller send buffer the kernel grants) continue in
+    // PENDING messages
+    const size_t MAX_MESSAGE_SIZE = 4 * 1024 * 1024;
+    const size_t MIN_MESSAGE_LIMIT = 4 * 1024;
+    
+    bool fillAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            Logger::error("Control socket path too long: " + path);
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+    }
+}
+
+HandoffChannel::~HandoffChannel() {
+    if (fd >= 0) close(fd);
+}
+
+size_t HandoffChannel::getMessageLimit() {
+    if (messageLimit == 0) {
+        // A datagram must fit the sender's buffer, less some bookkeeping
+        int bufferSize = 0;
+        socklen_t optionLength = sizeof(bufferSize);
+        if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferSize, &optionLength) != 0 || bufferSize <= 0) {
+            bufferSize = static_cast<int>(MIN_MESSAGE_LIMIT * 2);
+        }
+        messageLimit = std::clamp(static_cast<size_t>(bufferSize) / 2, MIN_MESSAGE_LIMIT, MAX_MESSAGE_SIZE);
+    }
+    return messageLimit;
+}
+
+bool HandoffChannel::sendRaw(HandoffMessageType type, const uint8_t* payload, size_t length, int passFd) {
+    uint8_t typeByte = static_cast<uint8_t>(type);
+    iovec io[2] = {{&typeByte, 1}, {const_cast<uint8_t*>(payload), length}};
+    msghdr header{};
+    header.msg_iov = io;
+    header.msg_iovlen = length > 0 ? 2 : 1;
+    
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (passFd >= 0) {
+        std::memset(control, 0, sizeof(control));
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &passFd, sizeof(int));
+    }
+    
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &header, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    
+    if (sent != static_cast<ssize_t>(length + 1)) {
+        Logger::error("Hot restart: failed to send handoff message. Error: " + std::to_string(errno));
+        return false;
+    }
+    return true;
+}
+
+bool HandoffChannel::sendTakeover() {
+    return sendRaw(HandoffMessageType::TAKEOVER, nullptr, 0, -1);
+}
+
+bool HandoffChannel::sendListener(int listenFd, int32_t port) {
+    WireWriter writer;
+    writer.i32(port);
+    return sendRaw(HandoffMessageType::LISTENER, writer.bytes.data(), writer.bytes.size(), listenFd);
+}
+
+bool HandoffChannel::sendSession(int clientFd, const SessionSnapshot& session) {
+    const std::vector<uint8_t>& inbound = session.pendingInbound;
+    const std::vector<uint8_t>& outbound = session.pendingOutbound;
+    size_t limit = getMessageLimit() - 1;
+    
+    WireWriter writer;
+    writer.str(session.ipAddress);
+    writer.str(session.playerName);
+    writer.i32(session.playerID);
+    writer.str(session.worldName);
+    writer.i32(session.worldX);
+    writer.i32(session.worldY);
+    
+    // As much of the buffers as fits goes with the state; the four length
+    // prefixes and counts below take 20 bytes
+    const size_t trailer = 5 * sizeof(uint32_t);
+    if (writer.bytes.size() + trailer > limit) {
+        Logger::warning("Hot restart: session state for " + session.ipAddress + " too large to hand off");
+        return false;
+    }
+    size_t room = limit - writer.bytes.size() - trailer;
+    size_t inboundHead = std::min(inbound.size(), room);
+    size_t outboundHead = std::min(outbound.size(), room - inboundHead);
+    writer.blob(inbound.data(), inboundHead);
+    writer.blob(outbound.data(), outboundHead);
+    writer.u32(session.authenticated ? 1 : 0);
+    writer.u32(static_cast<uint32_t>(inbound.size() - inboundHead));
+    writer.u32(static_cast<uint32_t>(outbound.size() - outboundHead));
+    
+    if (!sendRaw(HandoffMessageType::SESSION, writer.bytes.data(), writer.bytes.size(), clientFd)) {
+        return false;
+    }
+    
+    // The rest of inbound, then the rest of outbound
+    for (auto [buffer, offset] : {std::pair(&inbound, inboundHead), std::pair(&outbound, outboundHead)}) {
+        while (offset < buffer->size()) {
+            size_t length = std::min(buffer->size() - offset, limit);
+            if (!sendRaw(HandoffMessageType::PENDING, buffer->data() + offset, length, -1)) {
+                return false;
+            }
+            offset += length;
+        }
+    }
+    return true;
+}
+
+bool HandoffChannel::sendDone() {
+    return sendRaw(HandoffMessageType::DONE, nullptr, 0, -1);
+}
+
+ssize_t HandoffChannel::receiveRaw(int& passedFd) {
+    if (!receiveBuffer) {
+        receiveBuffer.reset(new uint8_t[MAX_MESSAGE_SIZE]);
+    }
+    iovec io{receiveBuffer.get(), MAX_MESSAGE_SIZE};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    
+    msghdr header{};
+    header.msg_iov = &io;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &header, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    
+    passedFd = -1;
+    if (received <= 0) {
+        return -1;
+    }
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::memcpy(&passedFd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    
+    if (header.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+        Logger::error("Hot restart: truncated handoff message");
+        if (passedFd >= 0) close(passedFd);
+        passedFd = -1;
+        return -1;
+    }
+    return received;
+}
+
+bool HandoffChannel::receive(HandoffMessage& message) {
+    ssize_t received = receiveRaw(message.fd);
+    if (received <= 0) {
+        return false;
+    }
+    
+    message.type = static_cast<HandoffMessageType>(receiveBuffer[0]);
+    WireReader reader(receiveBuffer.get() + 1, static_cast<size_t>(received) - 1);
+    uint32_t inboundRest = 0;
+    uint32_t outboundRest = 0;
+    
+    if (message.type == HandoffMessageType::LISTENER) {
+        message.port = reader.i32();
+    } else if (message.type == HandoffMessageType::SESSION) {
+        message.session.ipAddress = reader.str();
+        message.session.playerName = reader.str();
+        message.session.playerID = reader.i32();
+        message.session.worldName = reader.str();
+        message.session.worldX = reader.i32();
+        message.session.worldY = reader.i32();
+        message.session.pendingInbound = reader.vec();
+        message.session.pendingOutbound = reader.vec();
+        // Absent when the sender predates account logins or PENDING
+        message.session.authenticated = !reader.atEnd() && reader.u32() != 0;
+        if (!reader.atEnd()) {
+            inboundRest = reader.u32();
+            outboundRest = reader.u32();
+        }
+    } else if (message.type == HandoffMessageType::PENDING) {
+        Logger::error("Hot restart: buffered bytes without a session");
+        reader.ok = false;
+    }
+    
+    // Fold the continuation messages into the snapshot
+    while (reader.ok && size_t(inboundRest) + outboundRest > 0) {
+        int strayFd = -1;
+        ssize_t length = receiveRaw(strayFd);
+        if (strayFd >= 0) close(strayFd);
+        if (length <= 0 || static_cast<HandoffMessageType>(receiveBuffer[0]) != HandoffMessageType::PENDING ||
+            static_cast<size_t>(length - 1) > size_t(inboundRest) + outboundRest) {
+            reader.ok = false;
+            break;
+        }
+        
+        const uint8_t* data = receiveBuffer.get() + 1;
+        size_t remaining = static_cast<size_t>(length - 1);
+        size_t toInbound = std::min<size_t>(remaining, inboundRest);
+        message.session.pendingInbound.insert(message.session.pendingInbound.end(), data, data + toInbound);
+        message.session.pendingOutbound.insert(message.session.pendingOutbound.end(), data + toInbound, data + remaining);
+        inboundRest -= static_cast<uint32_t>(toInbound);
+        outboundRest -= static_cast<uint32_t>(remaining - toInbound);
+    }
+    
+    if (!reader.ok) {
+        Logger::error("Hot restart: malformed handoff message");
+        if (message.fd >= 0) close(message.fd);
+        return false;
+    }
+    return true;
+}
+
+int HotRestart::listenControl(const std::string& path) {
+    sockaddr_un address;
+    if (!fillAddress(path, address)) return -1;
+    
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        Logger::error("Hot restart: failed to create control socket. Error: " + std::to_string(errno));
+        return -1;
+    }
+    
+    // The previous owner (or a crashed process) may have left the file behind
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 1) != 0) {
+        Logger::error("Hot restart: failed to bind control socket " + path + ". Error: " + std::to_string(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+HandoffChannel HotRestart::acceptTakeover(int controlFd, int timeoutMs) {
+    pollfd waiter{controlFd, POLLIN, 0};
+    if (poll(&waiter, 1, timeoutMs) <= 0) {
+        return HandoffChannel();
+    }
+    
+    int connection = accept4(controlFd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) {
+        return HandoffChannel();
+    }
+    
+    int bufferSize = static_cast<int>(MAX_MESSAGE_SIZE);
+    setsockopt(connection, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+    
+    HandoffChannel channel(connection);
+    HandoffMessage request;
+    if (!channel.receive(request) || request.type != HandoffMessageType::TAKEOVER) {
+        Logger::warning("Hot restart: ignoring unexpected control connection");
+        return HandoffChannel();
+    }
+    return channel;
+}
+
+HandoffChannel HotRestart::requestTakeover(const std::string& path) {
+    sockaddr_un address;
+    if (!fillAddress(path, address)) return HandoffChannel();
+    
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) return HandoffChannel();
+    
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        Logger::error("Hot restart: no server listening on " + path + ". Error: " + std::to_string(errno));
+        close(fd);
+        return HandoffChannel();
+    }
+    
+    int bufferSize = static_cast<int>(MAX_MESSAGE_SIZE);
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    
+    HandoffChannel channel(fd);
+    if (!channel.sendTakeover()) {
+        return HandoffChannel();
+    }
+    return channel;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+// Zero-downtime restart: a running server hands its listening socket and its
+// live sessions to a newly started process over a Unix domain socket
+// (SOCK_SEQPACKET, descriptors passed with SCM_RIGHTS), then drains and exits.
+//
+//   old process                         new process (--takeover)
+//   listens on the control socket  <--  connects, sends TAKEOVER
+//   LISTENER (+listen fd)          -->  adopts the listening socket
+//   SESSION  (+client fd, state)   -->  rebuilds each session  (repeated)
+//   PENDING  (buffered bytes)      -->  rest of its buffers, if they didn't fit
+//   DONE                           -->  starts serving, binds the control socket
+
+// Minimal state needed to continue a session in another process
+struct SessionSnapshot {
+    std::string ipAddress;
+    std::string playerName;
+    int32_t playerID = -1;
+    std::string worldName;
+    int32_t worldX = 0;
+    int32_t worldY = 0;
+    std::vector<uint8_t> pendingInbound;  // Bytes read but not yet framed
+    std::vector<uint8_t> pendingOutbound; // Framed bytes not yet sent
+    bool authenticated = false;
+};
+
+enum class HandoffMessageType : uint8_t {
+    TAKEOVER = 1,
+    LISTENER = 2,
+    SESSION = 3,
+    DONE = 4,
+    PENDING = 5     // Continues the previous SESSION; receive() folds it in
+};
+
+struct HandoffMessage {
+    HandoffMessageType type;
+    int fd = -1;                  // Descriptor received with the message, if any
+    int32_t port = 0;             // LISTENER
+    SessionSnapshot session;      // SESSION
+};
+
+// One end of a connected control socket
+class HandoffChannel {
+private:
+    int fd;
+    
+    // Largest message the socket takes in one piece; the kernel caps the
+    // send buffer below what we ask for, so it is read back on first use
+    size_t messageLimit;
+    
+    // Reused for every message received
+    std::unique_ptr<uint8_t[]> receiveBuffer;
+    
+    size_t getMessageLimit();
+    bool sendRaw(HandoffMessageType type, const uint8_t* payload, size_t length, int passFd);
+    ssize_t receiveRaw(int& passedFd);
+    
+public:
+    explicit HandoffChannel(int fd = -1) : fd(fd), messageLimit(0) {}
+    ~HandoffChannel();
+    
+    HandoffChannel(HandoffChannel&& other) noexcept
+        : fd(other.fd), messageLimit(other.messageLimit), receiveBuffer(std::move(other.receiveBuffer)) {
+        other.fd = -1;
+    }
+    HandoffChannel(const HandoffChannel&) = delete;
+    HandoffChannel& operator=(const HandoffChannel&) = delete;
+    
+    bool isOpen() const { return fd >= 0; }
+    
+    bool sendTakeover();
+    bool sendListener(int listenFd, int32_t port);
+    // Buffered bytes that don't fit next to the state follow in PENDING
+    // messages. The descriptor is duplicated into the receiver, so on
+    // failure the caller still owns a working connection.
+    bool sendSession(int clientFd, const SessionSnapshot& session);
+    bool sendDone();
+    
+    // Blocks for the next message; false on EOF, error or malformed data
+    bool receive(HandoffMessage& message);
+};
+
+class HotRestart {
+public:
+    // Binds the control socket (replacing a stale socket file); -1 on failure
+    static int listenControl(const std::string& path);
+    
+    // Waits up to timeoutMs for a takeover request on the control socket
+    static HandoffChannel acceptTakeover(int controlFd, int timeoutMs);
+    
+    // Connects to a running server's control socket and requests takeover
+    static HandoffChannel requestTakeover(const std::string& path);
+};
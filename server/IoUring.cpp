@@ -0,0 +1,212 @@
+#include "IoUring.h"
+#include "../utils/Logger.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <vector>
+
+IoUring::IoUring()
+    : ringFd(-1), features(0), sqRing(nullptr), sqRingSize(0), sqHead(nullptr), sqTail(nullptr),
+      sqMask(0), sqEntries(0), sqes(nullptr), sqesSize(0), sqeTail(0), submittedTail(0),
+      cqHead(nullptr), cqTail(nullptr), cqMask(0), cqes(nullptr),
+      bufferRing(nullptr), bufferRingSize(0), buffers(nullptr), buffersSize(0),
+      bufferCount(0), bufferSize(0), bufferGroup(0), bufferTail(0) {
+}
+
+IoUring::~IoUring() {
+    if (bufferRing) munmap(bufferRing, bufferRingSize);
+    if (buffers) munmap(buffers, buffersSize);
+    if (sqes) munmap(sqes, sqesSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ringFd >= 0) close(ringFd);
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+bool IoUring::initialize(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ringFd < 0) {
+        Logger::warning("io_uring_setup failed. Error: " + std::to_string(errno));
+        return false;
+    }
+
+    // One mapping for both rings, and timeouts passed to io_uring_enter
+    features = params.features;
+    unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((features & required) != required) {
+        Logger::warning("io_uring is missing required features");
+        return false;
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqRingSize = sqSize > cqSize ? sqSize : cqSize;
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        Logger::warning("Failed to map io_uring rings. Error: " + std::to_string(errno));
+        return false;
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMapping = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqeMapping == MAP_FAILED) {
+        Logger::warning("Failed to map io_uring SQEs. Error: " + std::to_string(errno));
+        return false;
+    }
+    sqes = static_cast<io_uring_sqe*>(sqeMapping);
+
+    uint8_t* base = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // SQE slot i is always submitted through array slot i
+    unsigned* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; ++i) {
+        array[i] = i;
+    }
+    sqeTail = submittedTail = *sqTail;
+    return true;
+}
+
+bool IoUring::supportsOps(std::initializer_list<uint8_t> ops) {
+    const unsigned probeOps = 256;
+    std::vector<uint8_t> storage(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, probeOps) < 0) {
+        return false;
+    }
+    for (uint8_t op : ops) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    if (sqeTail - head >= sqEntries) {
+        submit();
+        head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqeTail - head >= sqEntries) {
+            return nullptr;
+        }
+    }
+
+    io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqeTail;
+    return sqe;
+}
+
+int IoUring::submit() {
+    unsigned toSubmit = sqeTail - submittedTail;
+    if (toSubmit == 0) return 0;
+
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    int submitted;
+    do {
+        submitted = enter(toSubmit, 0, 0, nullptr, 0);
+    } while (submitted < 0 && errno == EINTR);
+
+    if (submitted > 0) {
+        submittedTail += static_cast<unsigned>(submitted);
+    }
+    return submitted;
+}
+
+int IoUring::submitAndWait(int timeoutMs) {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqeTail - submittedTail;
+
+    // Completions already waiting: just submit
+    bool pending = *cqHead != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    }
+
+    int result = enter(toSubmit, pending ? 0 : 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (result >= 0) {
+        submittedTail += static_cast<unsigned>(result);
+        return result;
+    }
+    
+    // Timed out, interrupted, or the completion queue needs draining first
+    if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+        return 0;
+    }
+    Logger::error("io_uring_enter failed. Error: " + std::to_string(errno));
+    return -errno;
+}
+
+bool IoUring::setupBuffers(uint16_t group, unsigned count, size_t size) {
+    if (count == 0 || (count & (count - 1)) != 0 || count > 32768) {
+        return false;
+    }
+
+    bufferRingSize = count * sizeof(io_uring_buf);
+    void* ringMapping = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringMapping == MAP_FAILED) {
+        return false;
+    }
+    bufferRing = static_cast<io_uring_buf_ring*>(ringMapping);
+
+    buffersSize = count * size;
+    void* bufferMapping = mmap(nullptr, buffersSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufferMapping == MAP_FAILED) {
+        buffers = nullptr;
+        return false;
+    }
+    buffers = static_cast<uint8_t*>(bufferMapping);
+    bufferCount = count;
+    bufferSize = size;
+    bufferGroup = group;
+
+    io_uring_buf_reg registration;
+    std::memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+    registration.ring_entries = count;
+    registration.bgid = group;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        Logger::warning("io_uring buffer ring registration failed. Error: " + std::to_string(errno));
+        return false;
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        recycleBuffer(static_cast<uint16_t>(i));
+    }
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t id) {
+    // Index from the start of the ring: in C++ the uapi flex-array wrapper
+    // shifts `bufs` past the empty member, off the kernel's layout
+    io_uring_buf* slots = reinterpret_cast<io_uring_buf*>(bufferRing);
+    io_uring_buf& slot = slots[bufferTail & (bufferCount - 1)];
+    slot.addr = reinterpret_cast<uint64_t>(buffers + static_cast<size_t>(id) * bufferSize);
+    slot.len = static_cast<uint32_t>(bufferSize);
+    slot.bid = id;
+    ++bufferTail;
+    __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+}
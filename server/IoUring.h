@@ -0,0 +1,99 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing): ring setup,
+// SQE allocation with batched submission, completion draining and one
+// provided-buffer ring for receives. Single-threaded: everything runs on
+// the owning event loop thread.
+class IoUring {
+private:
+    int ringFd;
+    unsigned features;
+
+    // Submission queue
+    void* sqRing;
+    size_t sqRingSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned sqeTail;       // Next SQE we hand out
+    unsigned submittedTail; // Last tail passed to the kernel
+
+    // Completion queue (shares sqRing's mapping)
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    io_uring_cqe* cqes;
+
+    // Provided buffers: `bufferCount` buffers of `bufferSize` bytes
+    io_uring_buf_ring* bufferRing;
+    size_t bufferRingSize;
+    uint8_t* buffers;
+    size_t buffersSize;
+    unsigned bufferCount;
+    size_t bufferSize;
+    uint16_t bufferGroup;
+    uint16_t bufferTail;
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argSize);
+
+public:
+    IoUring();
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // False if the kernel has no usable io_uring (or lacks needed features)
+    bool initialize(unsigned entries);
+
+    // True if the kernel implements every listed IORING_OP_*
+    bool supportsOps(std::initializer_list<uint8_t> ops);
+
+    int getFd() const { return ringFd; }
+
+    // Zeroed SQE to fill in; submits queued entries first if the ring is
+    // full. nullptr only if the kernel refuses to take more.
+    io_uring_sqe* getSqe();
+
+    // Passes queued SQEs to the kernel without waiting
+    int submit();
+
+    // Submits, then waits up to timeoutMs (-1 = forever) for a completion
+    int submitAndWait(int timeoutMs);
+
+    // Calls handler(const io_uring_cqe&) for every available completion
+    template<typename Handler>
+    unsigned drainCompletions(Handler&& handler) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            // Copy out: the handler may submit, and the slot is reused once
+            // the head moves
+            io_uring_cqe cqe = cqes[head & cqMask];
+            ++head;
+            ++count;
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            handler(cqe);
+            tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        }
+        return count;
+    }
+
+    // Registers `count` (a power of two) buffers of `size` bytes as group
+    // `group` for IOSQE_BUFFER_SELECT receives
+    bool setupBuffers(uint16_t group, unsigned count, size_t size);
+    uint16_t getBufferGroup() const { return bufferGroup; }
+    const uint8_t* getBuffer(uint16_t id) const { return buffers + static_cast<size_t>(id) * bufferSize; }
+
+    // Hands a consumed buffer back to the kernel
+    void recycleBuffer(uint16_t id);
+};
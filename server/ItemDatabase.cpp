@@ -0,0 +1,182 @@
+#include "ItemDatabase.h"
+#include "../utils/Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    const char FILE_MAGIC[4] = {'G', 'T', 'I', 'D'};
+
+    struct alignas(64) FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t recordSize;
+    };
+
+    static_assert(sizeof(FileHeader) == sizeof(ItemInfo), "Records must stay cache-aligned in the mapping");
+}
+
+ItemDatabase::ItemDatabase()
+    : mapping(nullptr), mappingSize(0), items(nullptr), count(0), fileHash(0) {
+#ifdef _WIN32
+    fileHandle = INVALID_HANDLE_VALUE;
+    mappingHandle = nullptr;
+#endif
+}
+
+ItemDatabase::~ItemDatabase() {
+    unmap();
+}
+
+void ItemDatabase::unmap() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (mapping) munmap(const_cast<uint8_t*>(mapping), mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    items = nullptr;
+    count = 0;
+    fileHash = 0;
+}
+
+bool ItemDatabase::load(const std::string& path) {
+    unmap();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        Logger::error("Failed to open item database " + path);
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+        Logger::error("Item database " + path + " is truncated");
+        unmap();
+        return false;
+    }
+    mappingSize = static_cast<size_t>(fileSize.QuadPart);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    mapping = mappingHandle ? static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    if (!mapping) {
+        Logger::error("Failed to map item database " + path);
+        unmap();
+        return false;
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("Failed to open item database " + path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        Logger::error("Item database " + path + " is truncated");
+        close(fd);
+        return false;
+    }
+    mappingSize = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if (address == MAP_FAILED) {
+        Logger::error("Failed to map item database " + path);
+        mappingSize = 0;
+        return false;
+    }
+    mapping = static_cast<const uint8_t*>(address);
+#endif
+
+    FileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION ||
+        header.recordSize != sizeof(ItemInfo)) {
+        Logger::error("Item database " + path + " has an unsupported format");
+        unmap();
+        return false;
+    }
+    if (mappingSize != sizeof(FileHeader) + static_cast<size_t>(header.count) * sizeof(ItemInfo)) {
+        Logger::error("Item database " + path + " size does not match its item count");
+        unmap();
+        return false;
+    }
+
+    // The mapping is page-aligned and the header is one record long, so
+    // every record starts on a cache line
+    items = reinterpret_cast<const ItemInfo*>(mapping + sizeof(FileHeader));
+    count = header.count;
+    fileHash = hashBytes(mapping, mappingSize);
+
+    Logger::info("Mapped " + std::to_string(count) + " items from " + path);
+    return true;
+}
+
+bool ItemDatabase::write(const std::string& path, const std::vector<ItemInfo>& entries) {
+    uint32_t itemCount = 0;
+    for (const auto& item : entries) {
+        if (item.id > MAX_ITEM_ID) {
+            Logger::error("Item ID " + std::to_string(item.id) + " is above the maximum of " +
+                          std::to_string(MAX_ITEM_ID));
+            return false;
+        }
+        itemCount = std::max(itemCount, item.id + 1);
+    }
+
+    // Unused IDs stay zeroed, i.e. ItemAction::NONE
+    std::vector<ItemInfo> records(itemCount);
+    std::memset(static_cast<void*>(records.data()), 0, records.size() * sizeof(ItemInfo));
+    for (const auto& item : entries) {
+        records[item.id] = item;
+    }
+
+    FileHeader header;
+    std::memset(static_cast<void*>(&header), 0, sizeof(header));
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.count = itemCount;
+    header.recordSize = sizeof(ItemInfo);
+
+    // Write aside and rename, so a running server never maps a half-written file
+    std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        Logger::error("Failed to create " + tempPath);
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(records.data(), sizeof(ItemInfo), records.size(), file) == records.size();
+    written = std::fclose(file) == 0 && written;
+
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename() won't replace an existing file here
+#endif
+    if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        Logger::error("Failed to write item database " + path);
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint32_t ItemDatabase::hashBytes(const uint8_t* data, size_t length) {
+    uint32_t hash = 0x55555555;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash >> 27) + (hash << 5) + data[i];
+    }
+    return hash;
+}
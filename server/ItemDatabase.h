@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// How an item behaves when used on a tile
+enum class ItemAction : uint8_t {
+    NONE = 0,       // Unused ID
+    FIST = 1,
+    WRENCH = 2,
+    FOREGROUND = 3, // Placeable block
+    BACKGROUND = 4,
+    SEED = 5,
+    CLOTHING = 6,
+    CONSUMABLE = 7
+};
+
+// One item, laid out exactly as stored in the database file. Records are
+// one cache line each and stored at their item ID, so a lookup is a single
+// array index and touches one line.
+struct alignas(64) ItemInfo {
+    uint32_t id;
+    ItemAction action;
+    uint8_t collision;      // 0 none, 1 solid, 2 platform, ...
+    uint8_t clothingSlot;
+    uint8_t maxStack;       // Usually 200
+    uint16_t rarity;
+    uint16_t breakHits;     // Punches to break
+    uint32_t growSeconds;   // Seeds only
+    uint32_t flags;
+    char name[40];          // NUL-terminated, truncated if longer
+};
+
+static_assert(sizeof(ItemInfo) == 64, "ItemInfo must stay one cache line; bump the file version if it changes");
+
+// Read-only item metadata mapped from a binary file built offline with
+// growtopia_itemdb. Opening maps the file, checks its header and hashes
+// it in one sequential pass: there is no parsing and no per-item
+// allocation. Immutable once loaded and safe to read from any thread.
+//
+// File layout (native byte order):
+//   Header (64 bytes): "GTID", version, item count, record size
+//   ItemInfo records [count], record i describing item ID i
+class ItemDatabase {
+private:
+    const uint8_t* mapping;
+    size_t mappingSize;
+    const ItemInfo* items;
+    uint32_t count;
+    uint32_t fileHash;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+    void unmap();
+
+public:
+    static const uint32_t FILE_VERSION = 1;
+
+    // Records are stored at their ID, so the ID bounds the file size
+    // (64 MB at this limit)
+    static const uint32_t MAX_ITEM_ID = 1u << 20;
+
+    ItemDatabase();
+    ~ItemDatabase();
+
+    ItemDatabase(const ItemDatabase&) = delete;
+    ItemDatabase& operator=(const ItemDatabase&) = delete;
+
+    bool load(const std::string& path);
+
+    bool isLoaded() const { return items != nullptr; }
+    uint32_t size() const { return count; }
+
+    // Null for IDs past the end; unused IDs return a record with action NONE
+    const ItemInfo* find(uint32_t id) const {
+        return id < count ? &items[id] : nullptr;
+    }
+
+    bool isValid(uint32_t id) const {
+        return id < count && items[id].action != ItemAction::NONE;
+    }
+
+    // Hash of the whole file, sent to clients so they know when to refetch it
+    uint32_t getHash() const { return fileHash; }
+
+    // Writes items (any order, gaps allowed) in the format load() expects;
+    // fails if any ID is above MAX_ITEM_ID
+    static bool write(const std::string& path, const std::vector<ItemInfo>& items);
+
+    // The 32-bit rolling hash the client uses for item data
+    static uint32_t hashBytes(const uint8_t* data, size_t length);
+};
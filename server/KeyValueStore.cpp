@@ -0,0 +1,231 @@
+#include "KeyValueStore.h"
+#include "../utils/Logger.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <cstring>
+
+namespace {
+    // Record: keyLength u32, valueLength u32, key, value, checksum u32
+    // (native byte order). A tombstone has valueLength == TOMBSTONE.
+    const uint32_t TOMBSTONE = 0xffffffff;
+    const size_t RECORD_HEADER_SIZE = 8;
+    const size_t CHECKSUM_SIZE = 4;
+
+    // Largest key or value accepted; anything bigger in the log is corruption
+    const uint32_t MAX_FIELD_SIZE = 16 * 1024 * 1024;
+
+    // Rewrite on open once dead records outnumber live ones by this much
+    const size_t COMPACT_MIN_STALE = 1024;
+
+    uint32_t checksum(const uint8_t* data, size_t length, uint32_t hash = 2166136261u) {
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void encodeRecord(std::vector<uint8_t>& out, const std::string& key, const std::string* value) {
+        uint32_t header[2] = {static_cast<uint32_t>(key.size()),
+                              value ? static_cast<uint32_t>(value->size()) : TOMBSTONE};
+        size_t start = out.size();
+        const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(header);
+        out.insert(out.end(), headerBytes, headerBytes + sizeof(header));
+        out.insert(out.end(), key.begin(), key.end());
+        if (value) {
+            out.insert(out.end(), value->begin(), value->end());
+        }
+
+        uint32_t sum = checksum(out.data() + start, out.size() - start);
+        const uint8_t* sumBytes = reinterpret_cast<const uint8_t*>(&sum);
+        out.insert(out.end(), sumBytes, sumBytes + sizeof(sum));
+    }
+}
+
+KeyValueStore::KeyValueStore() : log(nullptr), staleRecords(0) {
+}
+
+KeyValueStore::~KeyValueStore() {
+    close();
+}
+
+bool KeyValueStore::open(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(mutex);
+    path = filePath;
+    table.clear();
+    staleRecords = 0;
+
+    if (!replay()) {
+        return false;
+    }
+    if (staleRecords >= COMPACT_MIN_STALE && staleRecords > table.size() && !compact()) {
+        Logger::warning("Failed to compact " + path + ", continuing with the existing log");
+    }
+
+    log = std::fopen(path.c_str(), "ab");
+    if (!log) {
+        Logger::error("Failed to open " + path + " for writing");
+        return false;
+    }
+    return true;
+}
+
+void KeyValueStore::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (log) {
+        std::fclose(log);
+        log = nullptr;
+    }
+}
+
+bool KeyValueStore::replay() {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return true; // Created on first write
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        if (data.size() - offset < RECORD_HEADER_SIZE + CHECKSUM_SIZE) break;
+
+        uint32_t keyLength;
+        uint32_t valueLength;
+        std::memcpy(&keyLength, data.data() + offset, sizeof(keyLength));
+        std::memcpy(&valueLength, data.data() + offset + 4, sizeof(valueLength));
+        bool tombstone = valueLength == TOMBSTONE;
+        size_t bodyLength = static_cast<size_t>(keyLength) + (tombstone ? 0 : valueLength);
+        if (keyLength > MAX_FIELD_SIZE || (!tombstone && valueLength > MAX_FIELD_SIZE) ||
+            data.size() - offset < RECORD_HEADER_SIZE + bodyLength + CHECKSUM_SIZE) {
+            break;
+        }
+
+        size_t recordLength = RECORD_HEADER_SIZE + bodyLength;
+        uint32_t stored;
+        std::memcpy(&stored, data.data() + offset + recordLength, sizeof(stored));
+        if (stored != checksum(data.data() + offset, recordLength)) {
+            break;
+        }
+
+        const char* body = reinterpret_cast<const char*>(data.data() + offset + RECORD_HEADER_SIZE);
+        std::string key(body, keyLength);
+        auto existing = table.find(key);
+        if (existing != table.end()) {
+            ++staleRecords;
+        }
+        if (tombstone) {
+            if (existing != table.end()) table.erase(existing);
+            ++staleRecords;
+        } else {
+            table[key].assign(body + keyLength, valueLength);
+        }
+        offset += recordLength + CHECKSUM_SIZE;
+    }
+
+    if (offset < data.size()) {
+        // A crash mid-append leaves a partial record; appending after it
+        // would hide every later write
+        Logger::warning("Discarding " + std::to_string(data.size() - offset) + " corrupt trailing bytes in " + path);
+        std::error_code error;
+        std::filesystem::resize_file(path, offset, error);
+        if (error) {
+            Logger::error("Failed to truncate " + path + ": " + error.message());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool KeyValueStore::compact() {
+    std::vector<uint8_t> data;
+    for (const auto& entry : table) {
+        encodeRecord(data, entry.first, &entry.second);
+    }
+
+    // Write aside and rename, so a crash leaves either the old or new file
+    std::string tempPath = path + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = std::fflush(file) == 0 && written;
+    std::fclose(file);
+
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(tempPath, path, error);
+    }
+    if (!written || error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    Logger::info("Compacted " + path + ": dropped " + std::to_string(staleRecords) + " stale records");
+    staleRecords = 0;
+    return true;
+}
+
+bool KeyValueStore::appendRecord(const std::string& key, const std::string* value) {
+    if (!log) {
+        return false;
+    }
+
+    std::vector<uint8_t> record;
+    encodeRecord(record, key, value);
+    if (std::fwrite(record.data(), 1, record.size(), log) != record.size() || std::fflush(log) != 0) {
+        Logger::error("Failed to write to " + path);
+        return false;
+    }
+    return true;
+}
+
+bool KeyValueStore::get(const std::string& key, std::string& value) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = table.find(key);
+    if (it == table.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+bool KeyValueStore::put(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!appendRecord(key, &value)) {
+        return false;
+    }
+    auto result = table.insert_or_assign(key, value);
+    if (!result.second) {
+        ++staleRecords;
+    }
+    return true;
+}
+
+bool KeyValueStore::insert(const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (table.count(key) || !appendRecord(key, &value)) {
+        return false;
+    }
+    table.emplace(key, value);
+    return true;
+}
+
+bool KeyValueStore::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = table.find(key);
+    if (it == table.end() || !appendRecord(key, nullptr)) {
+        return false;
+    }
+    table.erase(it);
+    staleRecords += 2;
+    return true;
+}
+
+size_t KeyValueStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return table.size();
+}
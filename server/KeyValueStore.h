@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+// Embedded string key/value store backed by one append-only log file.
+// Every write appends a checksummed record and the whole table lives in
+// memory, so reads never touch the disk. Opening replays the log, cuts off
+// a torn final record, and rewrites the file when stale records outnumber
+// live ones. Safe to share between threads.
+class KeyValueStore {
+private:
+    std::string path;
+    std::FILE* log;
+    std::unordered_map<std::string, std::string> table;
+    size_t staleRecords;
+    mutable std::mutex mutex;
+
+    bool replay();
+    bool compact();
+    bool appendRecord(const std::string& key, const std::string* value);
+
+public:
+    KeyValueStore();
+    ~KeyValueStore();
+
+    KeyValueStore(const KeyValueStore&) = delete;
+    KeyValueStore& operator=(const KeyValueStore&) = delete;
+
+    // Creates the file if needed
+    bool open(const std::string& filePath);
+    void close();
+
+    bool get(const std::string& key, std::string& value) const;
+    bool put(const std::string& key, const std::string& value);
+
+    // Stores only if the key is new; false if it exists or the write failed
+    bool insert(const std::string& key, const std::string& value);
+
+    bool erase(const std::string& key);
+    size_t size() const;
+};
@@ -0,0 +1,27 @@
+#include "RemoteClient.h"
+#include "../utils/Trace.h"
+
+RemoteClient::RemoteClient(uint32_t sessionID, const std::string& ip, std::shared_ptr<ShardLink> link)
+    : Client(INVALID_SOCKET, ip), sessionID(sessionID), link(std::move(link)), attached(true) {
+}
+
+bool RemoteClient::sendPacket(std::span<const uint8_t> packet) {
+    if (!isConnected() || packet.empty()) {
+        return false;
+    }
+    
+    TRACE_SCOPE_ID("sendPacket", getConnectionID());
+    return link->sendFrame(sessionID, packet);
+}
+
+void RemoteClient::disconnect() {
+    if (attached.exchange(false)) {
+        link->sendClose(sessionID);
+    }
+    Client::disconnect();
+}
+
+void RemoteClient::detach() {
+    attached = false;
+    Client::disconnect();
+}
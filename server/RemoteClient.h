@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Client.h"
+#include "ShardLink.h"
+
+// A session whose connection is held by a front-door router (world-shard
+// mode). It has no socket of its own: frames sent to it travel back over
+// the router link.
+class RemoteClient : public Client {
+private:
+    uint32_t sessionID;
+    std::shared_ptr<ShardLink> link;
+    std::atomic<bool> attached;
+    
+public:
+    RemoteClient(uint32_t sessionID, const std::string& ip, std::shared_ptr<ShardLink> link);
+    
+    uint32_t getSessionID() const { return sessionID; }
+    
+    bool sendPacket(std::span<const uint8_t> packet) override;
+    
+    // Ended by this shard (e.g. quit): the router drops the connection
+    void disconnect() override;
+    
+    // Ended by the router (left, migrated or gone): nothing to send back
+    void detach();
+};
@@ -0,0 +1,40 @@
+#include "ResponseCache.h"
+#include "../protocol/Packet.h"
+
+ResponseCache::ResponseCache() {
+    rebuild(ServerIdentity());
+}
+
+void ResponseCache::rebuild(const ServerIdentity& identity) {
+    auto build = [](const std::string& message) {
+        return std::make_shared<const std::vector<uint8_t>>(PacketBuilder::createStringPacket(message));
+    };
+
+    // The item hash tells the client whether its cached item data is current
+    std::string logon = "type|onSuperMainStartAcceptLogon\nUBI_CONNECT_LOBBY_ID|0\nserver|" + identity.address +
+                        "\nport|" + std::to_string(identity.port) + "\ntype|onSuperMainStartAcceptLogon\nlogon_url|" +
+                        identity.address + "\ntoken|1\nuser|2\nprotocol|171\nhash|rt\nfz|12345678\nf|1\ncp|12345\nbeta_server|1\ngame_version|" +
+                        identity.gameVersion;
+    if (identity.hasItemsHash) {
+        logon += "\nitems_hash|" + std::to_string(identity.itemsHash);
+    }
+
+    auto set = std::make_shared<FrameSet>();
+    (*set)[static_cast<size_t>(StaticResponse::LOGON_ACCEPT)] = build(logon);
+    (*set)[static_cast<size_t>(StaticResponse::WELCOME)] =
+        build("action|log\nmsg|`2" + identity.motd + "``\naction|log\nmsg|`9Server is running and ready!``");
+    (*set)[static_cast<size_t>(StaticResponse::LOGIN_REQUIRED)] =
+        build("action|log\nmsg|`4Please log in with a GrowID.``");
+    (*set)[static_cast<size_t>(StaticResponse::WORLD_UNAVAILABLE)] =
+        build("action|log\nmsg|`4World server unavailable, try again later.``");
+    (*set)[static_cast<size_t>(StaticResponse::SERVER_FULL)] =
+        build("action|log\nmsg|`4The server is full, try again later.``");
+    (*set)[static_cast<size_t>(StaticResponse::TOO_MANY_CONNECTIONS)] =
+        build("action|log\nmsg|`4Too many connections from your address.``");
+    (*set)[static_cast<size_t>(StaticResponse::INVALID_WORLD_NAME)] =
+        build("action|log\nmsg|`4World names are 1-24 letters or digits.``");
+    (*set)[static_cast<size_t>(StaticResponse::TOO_MANY_WORLDS)] =
+        build("action|log\nmsg|`4Too many worlds are open, try an existing one.``");
+
+    frames.store(std::move(set), std::memory_order_release);
+}
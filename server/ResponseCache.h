@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Fixed server messages, each prebuilt into a frame
+enum class StaticResponse {
+    LOGON_ACCEPT,       // onSuperMainStartAcceptLogon
+    WELCOME,
+    LOGIN_REQUIRED,     // Unauthenticated packet while GrowIDs are enforced
+    WORLD_UNAVAILABLE,  // Router could not reach the world's shard
+    SERVER_FULL,        // No player slot or login queue place left
+    TOO_MANY_CONNECTIONS, // Per-IP connection limit reached
+    INVALID_WORLD_NAME, // Join request for a name we don't accept
+    TOO_MANY_WORLDS,    // Joining would open a world past max_worlds
+    COUNT
+};
+
+// What the static responses are built from; anything a config reload can change
+struct ServerIdentity {
+    std::string address = "127.0.0.1";
+    int port = 17091;
+    std::string gameVersion = "4.54";
+    std::string motd = "Welcome to the Private Server!";
+    bool hasItemsHash = false;
+    uint32_t itemsHash = 0;
+};
+
+// Immutable frames for responses that are the same for every player, so a
+// login storm sends the same bytes instead of formatting and framing them
+// thousands of times a second. rebuild() swaps in a whole new set at once;
+// readers keep whatever set they loaded, so frames never change under them.
+// Thread-safe.
+class ResponseCache {
+public:
+    using Frame = std::shared_ptr<const std::vector<uint8_t>>;
+
+private:
+    using FrameSet = std::array<Frame, static_cast<size_t>(StaticResponse::COUNT)>;
+    std::atomic<std::shared_ptr<const FrameSet>> frames;
+
+public:
+    ResponseCache();
+
+    void rebuild(const ServerIdentity& identity);
+
+    Frame get(StaticResponse response) const {
+        return (*frames.load(std::memory_order_acquire))[static_cast<size_t>(response)];
+    }
+};
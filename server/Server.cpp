@@ -1,13 +1,117 @@
 #include "Server.h"
 #include "../utils/Logger.h"
+#include "../utils/Trace.h"
+#include "../utils/CpuAffinity.h"
 #include "../protocol/Packet.h"
+#include "World.h"
 #include <iostream>
 #include <algorithm>
+#include <cctype>
 #include <cstdlib>
 #include <ctime>
 #include <chrono>
 
-Server::Server(int port) : listenSocket(INVALID_SOCKET), port(port), running(false) {
+#ifndef _WIN32
+    #include <netinet/tcp.h>
+#endif
+
+#ifdef __linux__
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <future>
+#endif
+
+// Connections that send nothing for this long after connecting are dropped
+static const std::chrono::seconds HANDSHAKE_TIMEOUT(30);
+
+// After a hot-restart handoff, clients that could not be moved get this long
+// to finish before the old process exits
+static const std::chrono::seconds HANDOFF_DRAIN_TIMEOUT(30);
+
+// Default proximity radius: 32 tiles of 32 pixels, a little over one screen
+static const float DEFAULT_PROXIMITY_RADIUS = 32.0f * 32.0f;
+
+// Spawn position for players entering a world
+static const int SPAWN_X = 100;
+static const int SPAWN_Y = 100;
+
+// Updates that only matter to players who can see them
+static bool isProximityUpdate(const GamePacket& packet) {
+    switch (static_cast<UpdateType>(packet.objtype)) {
+        case UpdateType::STATE:
+        case UpdateType::SEND_PARTICLE_EFFECT:
+        case UpdateType::ITEM_EFFECT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Value of a "key|value" line in a text packet, empty if absent
+static std::string getField(const std::string& message, const std::string& key) {
+    std::string prefix = key + "|";
+    size_t start = 0;
+    while (start < message.size()) {
+        size_t end = message.find('\n', start);
+        if (end == std::string::npos) end = message.size();
+        if (message.compare(start, prefix.size(), prefix) == 0) {
+            return message.substr(start + prefix.size(), end - start - prefix.size());
+        }
+        start = end + 1;
+    }
+    return "";
+}
+
+// The message with its password masked, for logging
+static std::string redactPassword(const std::string& message) {
+    static const std::string prefix = "tankIDPass|";
+    std::string redacted = message;
+    size_t start = 0;
+    while (start < redacted.size()) {
+        size_t end = redacted.find('\n', start);
+        if (end == std::string::npos) end = redacted.size();
+        if (redacted.compare(start, prefix.size(), prefix) == 0) {
+            redacted.replace(start + prefix.size(), end - start - prefix.size(), "***");
+            end = start + prefix.size() + 3;
+        }
+        start = end + 1;
+    }
+    return redacted;
+}
+
+// Tells a waiting login where it stands (1 = next in)
+static std::vector<uint8_t> createQueuePositionPacket(size_t position) {
+    return PacketBuilder::createStringPacket("action|log\nmsg|`9Server is full, you are number " +
+                                             std::to_string(position) + " in the login queue.``");
+}
+
+// World name from an "action|join_request" message
+static bool parseJoinRequest(const std::string& message, std::string& worldName) {
+    if (message.rfind("action|join_request", 0) != 0) {
+        return false;
+    }
+    size_t nameStart = message.find("name|");
+    if (nameStart == std::string::npos) {
+        return false;
+    }
+    size_t nameEnd = message.find('\n', nameStart);
+    worldName = message.substr(nameStart + 5, nameEnd == std::string::npos ? std::string::npos : nameEnd - nameStart - 5);
+    return true;
+}
+
+// Every name opens a world, so only plain ones are accepted
+static bool isValidWorldName(const std::string& name) {
+    if (name.empty() || name.size() > 24) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isalnum(c) != 0; });
+}
+
+Server::Server(int port, size_t workerThreads, size_t coreShards)
+    : listenSocket(INVALID_SOCKET), port(port), running(false), useEventLoop(false),
+      maxWorlds(0), proximityRadius(DEFAULT_PROXIMITY_RADIUS), tcpNoDelay(true), sendBufferSize(0), receiveBufferSize(0),
+      reloadRequested(false), tickRate(1), maxSessionMemory(0), memoryReportRequested(false),
+      workerPool(coreShards > 0 ? coreShards : workerThreads, coreShards > 0) {
 #ifdef _WIN32
     WSADATA wsaData;
     if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
@@ -16,6 +120,299 @@ Server::Server(int port) : listenSocket(INVALID_SOCKET), port(port), running(fal
 #endif
     // Seed random number generator for player IDs
     std::srand(static_cast<unsigned int>(std::time(nullptr)));
+#ifdef __linux__
+    useEventLoop = true;
+    useIoUring = false;
+    controlSocket = -1;
+    listenerHandedOff = false;
+    draining = false;
+    drainStarted = false;
+    for (size_t i = 0; i < coreShards; ++i) {
+        cores.push_back(std::make_unique<CoreShard>());
+    }
+#endif
+    rebuildResponses();
+}
+
+void Server::rebuildResponses() {
+    identity.port = port;
+    identity.hasItemsHash = items.isLoaded();
+    identity.itemsHash = items.getHash();
+    responses.rebuild(identity);
+}
+
+bool Server::loadItems(const std::string& path) {
+    bool loaded = items.load(path);
+    rebuildResponses();
+    return loaded;
+}
+
+void Server::setIdentity(const ServerIdentity& newIdentity) {
+    identity = newIdentity;
+    rebuildResponses();
+}
+
+void Server::configure(const ServerSettings& newSettings, const std::string& path) {
+    settings = newSettings;
+    configPath = path;
+    
+    Client::setLimits(settings.limits);
+#ifdef __linux__
+    eventLoop.setReceiveBuffers(settings.ringBufferCount, settings.ringBufferSize);
+    for (auto& core : cores) {
+        core->loop.setReceiveBuffers(settings.ringBufferCount, settings.ringBufferSize);
+    }
+#endif
+    
+    if (!CpuAffinity::parse(settings.threadPlacement, threadPlacement)) {
+        threadPlacement.clear();
+    }
+    if (!threadPlacement.empty()) {
+        Logger::info("Pinning threads to CPUs " + CpuAffinity::describe(threadPlacement));
+        // Per-core workers share their core's CPU; otherwise they follow the I/O thread
+        workerPool.pinWorkers(threadPlacement, workerPool.isPerCore() ? 0 : 1);
+    }
+    
+    Logger::setLevel(settings.logLevel);
+    if (settings.fileLogging) {
+        Logger::enableFileLogging(settings.logFile);
+        Logger::info("File logging enabled: " + settings.logFile);
+    }
+    applyReloadable(settings);
+}
+
+void Server::placeThread(std::thread& thread, size_t slot) {
+    if (!threadPlacement.empty()) {
+        CpuAffinity::pin(thread, threadPlacement[slot % threadPlacement.size()]);
+    }
+}
+
+void Server::logCoreStats() {
+    if (!workerPool.isPerCore()) return;
+    
+    for (size_t i = 0; i < workerPool.getThreadCount(); ++i) {
+        auto stats = workerPool.getWorkerStats(i);
+        std::string line = "Core " + std::to_string(i) + ": " + std::to_string(stats.tasksRun) + " tasks, " +
+                           std::to_string(stats.postedFromElsewhere) + " posted from other threads";
+#ifdef __linux__
+        if (i < cores.size()) {
+            line += ", " + std::to_string(cores[i]->accepted.load()) + " connections accepted";
+        }
+#endif
+        if (!threadPlacement.empty()) {
+            line += " (CPU " + std::to_string(threadPlacement[i % threadPlacement.size()]) + ")";
+        }
+        Logger::info(line);
+    }
+}
+
+bool Server::withinMemoryBudget(const std::shared_ptr<Client>& client) {
+    size_t budget = maxSessionMemory;
+    if (budget == 0) return true;
+    
+    size_t used = client->getMemoryUsage();
+    if (used <= budget) return true;
+    
+    Logger::warning(Logger::concat({"Session ", std::to_string(client->getConnectionID()), " from ", client->getIP(), " holds ",
+                                    std::to_string(used), " bytes, over its ", std::to_string(budget), " byte budget; disconnecting"}));
+    client->disconnect();
+    return false;
+}
+
+void Server::enforceMemoryBudgets() {
+    if (maxSessionMemory == 0) return;
+    
+    std::vector<std::shared_ptr<Client>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        snapshot = clients;
+    }
+    for (const auto& client : snapshot) {
+        if (client->isConnected()) {
+            withinMemoryBudget(client);
+        }
+    }
+}
+
+void Server::logMemoryReport() {
+    std::vector<std::shared_ptr<Client>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        snapshot = clients;
+    }
+    
+    std::vector<std::pair<size_t, std::shared_ptr<Client>>> usage;
+    size_t total = 0;
+    for (const auto& client : snapshot) {
+        size_t used = client->getMemoryUsage();
+        usage.emplace_back(used, client);
+        total += used;
+    }
+    
+    size_t average = usage.empty() ? 0 : total / usage.size();
+    Logger::info("Memory: " + std::to_string(usage.size()) + " sessions hold " + std::to_string(total) + " bytes (" +
+                 std::to_string(average) + " per session, about " + std::to_string((average * 1000 + 512 * 1024) / (1024 * 1024)) +
+                 " MiB per 1,000 players); " + std::to_string(SessionArena::getLiveArenas()) + " arenas hold " +
+                 std::to_string(SessionArena::getTotalBytes()) + " bytes");
+    
+    // The heaviest sessions, to find the ones that bloat
+    const size_t shown = std::min<size_t>(usage.size(), 5);
+    std::partial_sort(usage.begin(), usage.begin() + shown, usage.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; i < shown; ++i) {
+        const auto& client = usage[i].second;
+        std::string_view name = client->getPlayerName();
+        Logger::info(Logger::concat({"  Session ", std::to_string(client->getConnectionID()), " (",
+                                     name.empty() ? std::string_view("not logged in") : name, ", ", client->getIP(), "): ",
+                                     std::to_string(usage[i].first), " bytes"}));
+    }
+}
+
+void Server::applyReloadable(const ServerSettings& next) {
+    applyAdmissionLimits(next);
+    tcpNoDelay = next.tcpNoDelay;
+    sendBufferSize = next.sendBufferSize;
+    receiveBufferSize = next.receiveBufferSize;
+    tickRate = next.tickRate;
+    maxSessionMemory = next.maxSessionMemory;
+    maxWorlds = next.maxWorlds;
+    proximityRadius.store(next.proximityRadius);
+    setIdentity(next.identity);
+}
+
+void Server::reloadConfig() {
+    ServerSettings next;
+    if (!next.load(configPath)) {
+        Logger::error("Config reload failed: cannot read " + configPath);
+        return;
+    }
+    
+    // Sizes and threads are fixed once the server runs
+    if (next.port != settings.port || next.workerThreads != settings.workerThreads ||
+        next.coreShards != settings.coreShards || next.threadPlacement != settings.threadPlacement ||
+        next.limits.maxPacketSize != settings.limits.maxPacketSize ||
+        next.limits.maxOutboundBytes != settings.limits.maxOutboundBytes ||
+        next.limits.receiveChunkSize != settings.limits.receiveChunkSize ||
+        next.ringBufferCount != settings.ringBufferCount || next.ringBufferSize != settings.ringBufferSize ||
+        next.itemsFile != settings.itemsFile || next.enableAuthentication != settings.enableAuthentication ||
+        next.accountsFile != settings.accountsFile || next.enableUdp != settings.enableUdp ||
+        next.udpChecksum != settings.udpChecksum) {
+        Logger::warning("Config reload: port, thread, buffer, item, account and UDP settings take effect on restart");
+        next.port = settings.port;
+        next.workerThreads = settings.workerThreads;
+        next.coreShards = settings.coreShards;
+        next.threadPlacement = settings.threadPlacement;
+        next.limits = settings.limits;
+        next.ringBufferCount = settings.ringBufferCount;
+        next.ringBufferSize = settings.ringBufferSize;
+        next.itemsFile = settings.itemsFile;
+        next.enableAuthentication = settings.enableAuthentication;
+        next.accountsFile = settings.accountsFile;
+        next.enableUdp = settings.enableUdp;
+        next.udpChecksum = settings.udpChecksum;
+    }
+    
+    Logger::setLevel(next.logLevel);
+    if (!next.fileLogging) {
+        Logger::disableFileLogging();
+    } else if (!settings.fileLogging || next.logFile != settings.logFile) {
+        Logger::enableFileLogging(next.logFile);
+    }
+    applyReloadable(next);
+    settings = next;
+    
+    Logger::info("Reloaded " + configPath);
+}
+
+void Server::applyAdmissionLimits(const ServerSettings& source) {
+    AdmissionControl::Limits limits;
+    limits.maxPlayers = source.maxClients;
+    limits.maxPerIP = source.maxConnectionsPerIP;
+    limits.maxQueue = source.loginQueueSize;
+    applyAdmissionChanges(admission.setLimits(limits));
+}
+
+bool Server::admitConnection(const std::shared_ptr<Client>& client) {
+    auto verdict = admission.connect(client);
+    if (verdict == AdmissionControl::Verdict::ACCEPTED) {
+        return true;
+    }
+    
+    // Not attached to a loop yet, so this is a plain blocking send of a
+    // few bytes into an empty socket buffer
+    bool fromIP = verdict == AdmissionControl::Verdict::TOO_MANY_FROM_IP;
+    Logger::warning(Logger::concat({"Refusing connection from ", client->getIP(), (fromIP ? ": too many connections from this address" : ": server full")}));
+    client->sendPacket(*responses.get(fromIP ? StaticResponse::TOO_MANY_CONNECTIONS : StaticResponse::SERVER_FULL));
+    client->discardReceived();
+    client->disconnect();
+    return false;
+}
+
+void Server::applyAdmissionChanges(AdmissionControl::Changes changes) {
+    // Resume each promoted login on its own session, as if it just arrived
+    for (auto& promotion : changes.admitted) {
+        auto client = promotion.client;
+        std::string message = std::move(promotion.message);
+        Logger::info(Logger::concat({"Login queue: admitting ", client->getIP()}));
+        client->getSessionExecutor()->post([this, client, message] {
+            client->setInLoginQueue(false);
+            if (client->isConnected()) {
+                handleStringPacket(client, message);
+            }
+        });
+    }
+    for (auto& moved : changes.moved) {
+        moved.first->sendPacket(createQueuePositionPacket(moved.second));
+    }
+}
+
+void Server::applySocketOptions(socket_t socket) {
+    int noDelay = tcpNoDelay ? 1 : 0;
+    if (setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay)) == SOCKET_ERROR) {
+        Logger::warning("Failed to set TCP_NODELAY");
+    }
+    
+    // 0 leaves the kernel's (auto-tuned) default alone
+    int sendBuffer = sendBufferSize;
+    if (sendBuffer > 0 &&
+        setsockopt(socket, SOL_SOCKET, SO_SNDBUF, (const char*)&sendBuffer, sizeof(sendBuffer)) == SOCKET_ERROR) {
+        Logger::warning("Failed to set SO_SNDBUF");
+    }
+    int receiveBuffer = receiveBufferSize;
+    if (receiveBuffer > 0 &&
+        setsockopt(socket, SOL_SOCKET, SO_RCVBUF, (const char*)&receiveBuffer, sizeof(receiveBuffer)) == SOCKET_ERROR) {
+        Logger::warning("Failed to set SO_RCVBUF");
+    }
+}
+
+void Server::setUseEventLoop(bool enabled) {
+#ifdef __linux__
+    useEventLoop = enabled;
+#else
+    if (enabled) {
+        Logger::warning("Event loop mode is only available on Linux, using a thread per client");
+    }
+#endif
+}
+
+bool Server::enableAuthentication(const std::string& storePath) {
+    accounts = std::make_unique<AccountStore>();
+    if (!accounts->open(storePath)) {
+        Logger::error("Failed to open account store " + storePath);
+        accounts.reset();
+        return false;
+    }
+    return true;
+}
+
+void Server::setUseIoUring(bool enabled) {
+#ifdef __linux__
+    useIoUring = enabled;
+#else
+    if (enabled) {
+        Logger::warning("io_uring is only available on Linux");
+    }
+#endif
 }
 
 Server::~Server() {
@@ -26,6 +423,15 @@ Server::~Server() {
 }
 
 bool Server::initialize() {
+#ifdef __linux__
+    if (!shardPath.empty()) {
+        return initializeShard();
+    }
+    if (router && !router->connect()) {
+        return false;
+    }
+#endif
+    
     // Create socket
     listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (listenSocket == INVALID_SOCKET) {
@@ -42,6 +448,12 @@ bool Server::initialize() {
 #endif
         Logger::warning("Failed to set SO_REUSEADDR");
     }
+#ifdef __linux__
+    // Every core shard binds its own listener to the port
+    if (!cores.empty() && setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == SOCKET_ERROR) {
+        Logger::warning("Failed to set SO_REUSEPORT");
+    }
+#endif
 
     // Bind socket
     sockaddr_in serverAddr{};
@@ -61,64 +473,333 @@ bool Server::initialize() {
         CLOSE_SOCKET(listenSocket);
         return false;
     }
+    
+    if (settings.enableUdp && !openUdp()) {
+        CLOSE_SOCKET(listenSocket);
+        return false;
+    }
 
+#ifdef __linux__
+    return setupListener();
+#else
     return true;
+#endif
 }
 
-void Server::run() {
-    running = true;
+#ifdef __linux__
+bool Server::setupListener() {
+    int flags = fcntl(listenSocket, F_GETFL, 0);
+    if (useEventLoop) {
+        auto backend = useIoUring ? EventLoop::Backend::IO_URING : EventLoop::Backend::EPOLL;
+        if (!eventLoop.initialize(backend) || fcntl(listenSocket, F_SETFL, flags | O_NONBLOCK) < 0) {
+            Logger::warning("Event loop unavailable, falling back to a thread per client");
+            useEventLoop = false;
+        }
+    }
+    if (!useEventLoop) {
+        // An inherited listener may still be non-blocking
+        fcntl(listenSocket, F_SETFL, flags & ~O_NONBLOCK);
+        if (!cores.empty()) {
+            Logger::warning("Core shards need the event loop; accepting on one thread");
+            cores.clear();
+        }
+    }
+    if (useEventLoop && !cores.empty()) {
+        return setupCores();
+    }
+    return true;
+}
+
+bool Server::setupCores() {
+    auto backend = useIoUring ? EventLoop::Backend::IO_URING : EventLoop::Backend::EPOLL;
+    for (size_t i = 0; i < cores.size(); ++i) {
+        CoreShard& core = *cores[i];
+        if (!core.loop.initialize(backend)) {
+            Logger::error("Failed to start the event loop for core " + std::to_string(i));
+            return false;
+        }
+        if (i == 0) {
+            core.listener = listenSocket;
+            continue;
+        }
+        
+        core.listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        int opt = 1;
+        sockaddr_in serverAddr{};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_addr.s_addr = INADDR_ANY;
+        serverAddr.sin_port = htons(port);
+        if (core.listener == INVALID_SOCKET ||
+            setsockopt(core.listener, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) == SOCKET_ERROR ||
+            setsockopt(core.listener, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == SOCKET_ERROR ||
+            bind(core.listener, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR ||
+            listen(core.listener, SOMAXCONN) == SOCKET_ERROR) {
+            Logger::error("Failed to open the listener for core " + std::to_string(i) + ". Error: " +
+                          std::to_string(SOCKET_ERROR_CODE));
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+void Server::startIO() {
+#ifdef __linux__
+    if (!shardPath.empty()) {
+        Logger::info("Serving worlds for routers on " + shardPath);
+        acceptThread = std::thread(&Server::acceptShardLinks, this);
+        return;
+    }
+#endif
     
-    // Start accept thread
+    if (udp) {
+        udpThread = std::thread(&UdpTransport::run, udp.get());
+        placeThread(udpThread, 0);
+    }
+    
+#ifdef __linux__
+    if (!hotRestartPath.empty() && !cores.empty()) {
+        Logger::warning("Hot restart is not available with core shards");
+    } else if (!hotRestartPath.empty()) {
+        controlSocket = HotRestart::listenControl(hotRestartPath);
+        if (controlSocket >= 0) {
+            Logger::info("Hot restart enabled on " + hotRestartPath);
+            controlThread = std::thread(&Server::controlLoop, this);
+        }
+    }
+    
+    if (useEventLoop) {
+        bool ring = eventLoop.getBackend() == EventLoop::Backend::IO_URING;
+        Logger::info(std::string("Using event loop with coroutine sessions (") + (ring ? "io_uring" : "epoll") + ")");
+        if (!cores.empty()) {
+            Logger::info("Running " + std::to_string(cores.size()) + " core shards");
+            for (size_t i = 0; i < cores.size(); ++i) {
+                CoreShard& core = *cores[i];
+                core.loop.registerSocket(core.listener);
+                spawn(acceptLoop(core.loop, core.listener, i));
+                core.thread = std::thread(&EventLoop::run, &core.loop);
+                placeThread(core.thread, i);
+            }
+            return;
+        }
+        eventLoop.registerSocket(listenSocket);
+        adoptSessions();
+        spawn(acceptLoop(eventLoop, listenSocket, WorkerPool::ANY_WORKER));
+        ioThread = std::thread(&EventLoop::run, &eventLoop);
+        placeThread(ioThread, 0);
+        return;
+    }
+#endif
+    
+    // Start accept thread; the connection threads it starts inherit its CPU set (Linux)
     acceptThread = std::thread(&Server::acceptClients, this);
+    CpuAffinity::pin(acceptThread, threadPlacement);
+}
+
+void Server::run() {
+    running = true;
+    startIO();
     
     Logger::info("Server is running. Press Enter to stop...");
-    std::cin.get();
+    
+    // Wait for Enter on the side so signals and a hot-restart drain are
+    // still serviced; the flag outlives us if stop() comes from elsewhere
+    auto enterPressed = std::make_shared<std::atomic<bool>>(false);
+    std::thread([enterPressed]() {
+        std::cin.get();
+        *enterPressed = true;
+    }).detach();
+    
+    while (running && !*enterPressed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / tickRate));
+        housekeepingTick();
+    }
     
     stop();
 }
 
 void Server::runDaemon() {
     running = true;
-    
-    // Start accept thread
-    acceptThread = std::thread(&Server::acceptClients, this);
+    startIO();
     
     Logger::info("Server is running in daemon mode...");
     
     // Keep running until stop() is called
     while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / tickRate));
+        housekeepingTick();
     }
 }
 
+void Server::housekeepingTick() {
+    Trace::servicePendingDump();
+    if (reloadRequested.exchange(false) && !configPath.empty()) {
+        reloadConfig();
+    }
+    enforceMemoryBudgets();
+    if (memoryReportRequested.exchange(false)) {
+        logMemoryReport();
+    }
+    
+#ifdef __linux__
+    // A successor took over: exit once the remaining clients are gone
+    if (draining) {
+        if (!drainStarted) {
+            drainStarted = true;
+            drainStart = std::chrono::steady_clock::now();
+        }
+        if (getClientCount() == 0 || std::chrono::steady_clock::now() - drainStart > HANDOFF_DRAIN_TIMEOUT) {
+            Logger::info("Hot restart: drain complete, exiting");
+            stop();
+        }
+    }
+#endif
+}
+
 void Server::stop() {
     if (!running) return;
     
     running = false;
     
-    // Close listen socket
+#ifdef __linux__
+    // Sessions unwind on the loop thread before the sockets go away
+    if (ioThread.joinable()) {
+        eventLoop.stop();
+        ioThread.join();
+    }
+    for (auto& core : cores) {
+        if (core->thread.joinable()) {
+            core->loop.stop();
+            core->thread.join();
+        }
+    }
+    
+    if (controlThread.joinable()) {
+        controlThread.join();
+    }
+    if (controlSocket >= 0) {
+        close(controlSocket);
+        controlSocket = -1;
+    }
+#endif
+    
+    // Close listen socket (shutdown first so a blocked accept() returns on Linux)
     if (listenSocket != INVALID_SOCKET) {
+#ifdef _WIN32
+        shutdown(listenSocket, SD_BOTH);
+#else
+        shutdown(listenSocket, SHUT_RDWR);
+#endif
         CLOSE_SOCKET(listenSocket);
         listenSocket = INVALID_SOCKET;
     }
+#ifdef __linux__
+    for (size_t i = 1; i < cores.size(); ++i) {
+        if (cores[i]->listener != INVALID_SOCKET) {
+            CLOSE_SOCKET(cores[i]->listener);
+            cores[i]->listener = INVALID_SOCKET;
+        }
+    }
+#endif
     
     // Wait for accept thread to finish
     if (acceptThread.joinable()) {
         acceptThread.join();
     }
+    stopUdp();
+    
+#ifdef __linux__
+    // Shard mode: end every router link so its reader thread returns
+    {
+        std::lock_guard<std::mutex> lock(shardLinksMutex);
+        for (auto& link : shardLinks) {
+            link->shutdown();
+        }
+    }
+    for (auto& linkThread : shardLinkThreads) {
+        linkThread.join();
+    }
+    shardLinkThreads.clear();
+    shardLinks.clear();
+#endif
     
     // Disconnect all clients
-    std::lock_guard<std::mutex> lock(clientsMutex);
-    for (auto& client : clients) {
-        client->disconnect();
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (auto& client : clients) {
+            client->disconnect();
+        }
+        clients.clear();
+    }
+    
+    // Let queued game logic finish before worlds go away
+    workerPool.shutdown();
+    logCoreStats();
+    {
+        std::lock_guard<std::mutex> lock(worldsMutex);
+        worlds.clear();
+    }
+    
+#ifdef __linux__
+    if (router) {
+        router->stop();
     }
-    clients.clear();
+#endif
     
     Logger::info("Server stopped");
 }
 
+bool Server::openUdp() {
+    UdpTransport::Handlers handlers;
+    handlers.connected = [this](const std::shared_ptr<UdpClient>& client) {
+        Logger::info(Logger::concat({"New UDP client connected from: ", client->getIP()}));
+        client->setSessionExecutor(std::make_shared<SerialExecutor>(workerPool));
+        if (!admitConnection(client)) {
+            return false;
+        }
+        addClient(client);
+        return true;
+    };
+    handlers.received = [this](const std::shared_ptr<UdpClient>& client, const std::vector<uint8_t>& frame) {
+        dispatchFrame(client, frame);
+    };
+    handlers.disconnected = [this](const std::shared_ptr<UdpClient>& client) {
+        Logger::info(Logger::concat({"Client disconnected: ", client->getIP()}));
+        removeClient(client);
+        
+        // Leave the world after any packets still queued for this session
+        client->getSessionExecutor()->post([this, client] { leaveWorld(client); });
+    };
+    
+    udp = std::make_unique<UdpTransport>(settings.udpChecksum, std::move(handlers));
+    if (!udp->open(port)) {
+        udp.reset();
+        return false;
+    }
+    Logger::info("Accepting UDP clients on port " + std::to_string(port));
+    return true;
+}
+
+void Server::stopUdp() {
+    if (!udp) return;
+    
+    udp->stop();
+    if (udpThread.joinable()) {
+        udpThread.join();
+    }
+    udp.reset();
+}
+
 void Server::acceptClients() {
     while (running) {
+#ifdef __linux__
+        // Wake up periodically so a hot-restart handoff can take the listener
+        pollfd waiter{listenSocket, POLLIN, 0};
+        int ready = poll(&waiter, 1, 250);
+        if (listenerHandedOff) break;
+        if (ready <= 0) continue;
+#endif
+        
         sockaddr_in clientAddr{};
         socklen_t clientAddrLen = sizeof(clientAddr);
         
@@ -131,20 +812,11 @@ void Server::acceptClients() {
             continue;
         }
         
-        // Get client IP
-        char clientIP[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, INET_ADDRSTRLEN);
-        
-        Logger::info("New client connected from: " + std::string(clientIP));
-        
-        // Create client object
-        auto client = std::make_shared<Client>(clientSocket, std::string(clientIP));
-        
-        // Add to clients list
-        {
-            std::lock_guard<std::mutex> lock(clientsMutex);
-            clients.push_back(client);
+        auto client = createClient(clientSocket, clientAddr);
+        if (!admitConnection(client)) {
+            continue;
         }
+        addClient(client);
         
         // Start handling client in separate thread
         std::thread clientThread(&Server::handleClient, this, client);
@@ -152,8 +824,475 @@ void Server::acceptClients() {
     }
 }
 
+std::shared_ptr<Client> Server::createClient(socket_t clientSocket, const sockaddr_in& clientAddr, size_t home) {
+    TRACE_SCOPE("acceptClients");
+    
+    // Get client IP
+    char clientIP[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &clientAddr.sin_addr, clientIP, INET_ADDRSTRLEN);
+    
+    Logger::info("New client connected from: " + std::string(clientIP));
+    applySocketOptions(clientSocket);
+    
+    // Create client object
+    auto client = std::make_shared<Client>(clientSocket, std::string(clientIP));
+    client->setSessionExecutor(std::make_shared<SerialExecutor>(workerPool, home));
+    return client;
+}
+
+void Server::addClient(std::shared_ptr<Client> client) {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.push_back(client);
+}
+
+#ifdef __linux__
+Task<void> Server::acceptLoop(EventLoop& loop, socket_t listener, size_t core) {
+    bool ring = loop.getBackend() == EventLoop::Backend::IO_URING;
+    
+    while (running) {
+        sockaddr_in clientAddr{};
+        socklen_t clientAddrLen = sizeof(clientAddr);
+        
+        socket_t clientSocket;
+        if (ring) {
+            // Multishot accept: the kernel queues connections on the loop
+            int accepted = co_await loop.accept(listener);
+            if (accepted == -ECANCELED || accepted == -EBADF) {
+                break; // Shutting down or the listener was handed off
+            }
+            if (accepted < 0) {
+                errno = -accepted;
+                clientSocket = INVALID_SOCKET;
+            } else {
+                clientSocket = accepted;
+                getpeername(clientSocket, (sockaddr*)&clientAddr, &clientAddrLen);
+            }
+        } else {
+            clientSocket = accept4(listener, (sockaddr*)&clientAddr, &clientAddrLen, SOCK_CLOEXEC);
+        }
+        
+        if (clientSocket == INVALID_SOCKET) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!co_await loop.readable(listener)) {
+                    break; // Shutting down
+                }
+            } else if (errno == EMFILE || errno == ENFILE) {
+                // Out of descriptors: back off instead of spinning on the ready socket
+                Logger::error("Failed to accept client connection. Error: " + std::to_string(SOCKET_ERROR_CODE));
+                co_await loop.sleep(std::chrono::milliseconds(100));
+            } else if (errno != EINTR && errno != ECONNABORTED && running) {
+                Logger::error("Failed to accept client connection. Error: " + std::to_string(SOCKET_ERROR_CODE));
+            }
+            continue;
+        }
+        
+        // A core's sessions start out on its worker
+        auto client = createClient(clientSocket, clientAddr, core);
+        if (core < cores.size()) {
+            cores[core]->accepted++;
+        }
+        if (!admitConnection(client)) {
+            continue;
+        }
+        if (!client->attachEventLoop(loop)) {
+            admission.disconnect(client.get());
+            client->disconnect();
+            continue;
+        }
+        addClient(client);
+        
+        spawn(runSession(client));
+    }
+}
+
+Task<void> Server::runSession(std::shared_ptr<Client> client, bool resumed) {
+    Logger::info(Logger::concat({"Handling client: ", client->getIP()}));
+    
+    // Only the first frame has a deadline; afterwards the session may idle
+    std::optional<EventLoop::Clock::time_point> deadline;
+    if (!resumed) {
+        Logger::debug("Waiting for client handshake...");
+        deadline = EventLoop::Clock::now() + HANDSHAKE_TIMEOUT;
+    }
+    
+    while (running && client->isConnected()) {
+        auto packetData = co_await client->asyncReceivePacket(deadline);
+        if (packetData.empty()) {
+            if (running && client->isConnected() && deadline) {
+                Logger::info(Logger::concat({"Handshake timeout for ", client->getIP()}));
+            }
+            break; // Client disconnected, timed out or server stopping
+        }
+        
+        deadline.reset();
+        dispatchFrame(client, packetData);
+    }
+    
+    Logger::info(Logger::concat({"Client disconnected: ", client->getIP()}));
+    removeClient(client);
+    client->getSessionExecutor()->post([this, client] { leaveWorld(client); });
+    client->closeSocket();
+}
+
+void Server::controlLoop() {
+    while (running) {
+        HandoffChannel channel = HotRestart::acceptTakeover(controlSocket, 500);
+        if (channel.isOpen()) {
+            handOff(channel);
+            return;
+        }
+    }
+}
+
+void Server::handOff(HandoffChannel& channel) {
+    Logger::info("Hot restart: new process is taking over");
+    
+    // UDP sessions can't be handed over: they are told to disconnect (the
+    // game client reconnects) and the port is freed before DONE, so the
+    // successor can bind it
+    stopUdp();
+    
+    if (useEventLoop && eventLoop.getBackend() == EventLoop::Backend::IO_URING) {
+        // Ring operations in flight can't be carried across processes: hand
+        // over the listener only and let existing clients finish here
+        std::promise<void> finished;
+        eventLoop.post([this, &channel, &finished] {
+            listenerHandedOff = true;
+            eventLoop.unregisterSocket(listenSocket);
+            channel.sendListener(listenSocket, port);
+            CLOSE_SOCKET(listenSocket);
+            listenSocket = INVALID_SOCKET;
+            channel.sendDone();
+            finished.set_value();
+        });
+        finished.get_future().wait();
+    } else if (useEventLoop) {
+        // Sessions and the listener belong to the loop thread
+        std::promise<void> finished;
+        eventLoop.post([this, &channel, &finished] {
+            handOffSessions(channel);
+            finished.set_value();
+        });
+        finished.get_future().wait();
+    } else {
+        // Blocking sessions can't be paused mid-frame: hand over the listener
+        // only and let existing clients finish here
+        listenerHandedOff = true;
+        if (acceptThread.joinable()) {
+            acceptThread.join();
+        }
+        channel.sendListener(listenSocket, port);
+        CLOSE_SOCKET(listenSocket);
+        listenSocket = INVALID_SOCKET;
+        channel.sendDone();
+    }
+    
+    draining = true;
+}
+
+void Server::handOffSessions(HandoffChannel& channel) {
+    // New connections go to the successor from here on
+    listenerHandedOff = true;
+    eventLoop.unregisterSocket(listenSocket);
+    channel.sendListener(listenSocket, port);
+    CLOSE_SOCKET(listenSocket);
+    listenSocket = INVALID_SOCKET;
+    
+    // Nothing new is read while we hold the loop thread; once queued game
+    // logic has finished, session state is stable enough to snapshot
+    workerPool.waitIdle();
+    
+    std::vector<std::shared_ptr<Client>> sessions;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        sessions = clients;
+    }
+    
+    size_t handedOff = 0;
+    for (auto& client : sessions) {
+        if (!client->isConnected()) continue;
+        
+        SessionSnapshot snapshot;
+        snapshot.ipAddress = client->getIP();
+        snapshot.playerName = client->getPlayerName();
+        snapshot.playerID = client->getPlayerID();
+        snapshot.authenticated = client->isAuthenticated();
+        if (client->getWorld()) {
+            snapshot.worldName = client->getWorld()->getName();
+        }
+        snapshot.worldX = client->getWorldX();
+        snapshot.worldY = client->getWorldY();
+        client->exportPending(snapshot);
+        
+        // The successor gets its own descriptor; if that fails, the session
+        // stays here and is served until the drain ends
+        socket_t clientSocket = client->getSocket();
+        if (clientSocket == INVALID_SOCKET) continue;
+        if (!channel.sendSession(clientSocket, snapshot)) {
+            Logger::warning(Logger::concat({"Hot restart: keeping session from ", client->getIP(), ", handoff failed"}));
+            continue;
+        }
+        
+        // Our copy only; the connection stays open in the new process
+        clientSocket = client->releaseSocket();
+        if (clientSocket != INVALID_SOCKET) {
+            CLOSE_SOCKET(clientSocket);
+        }
+        ++handedOff;
+    }
+    
+    channel.sendDone();
+    Logger::info("Hot restart: handed off " + std::to_string(handedOff) + " of " +
+                 std::to_string(sessions.size()) + " sessions");
+}
+
+bool Server::takeover() {
+    if (!cores.empty()) {
+        Logger::error("Hot restart is not available with core shards");
+        return false;
+    }
+    if (router && !router->connect()) {
+        return false;
+    }
+    
+    HandoffChannel channel = HotRestart::requestTakeover(hotRestartPath);
+    if (!channel.isOpen()) {
+        return false;
+    }
+    
+    std::vector<std::pair<int, SessionSnapshot>> sessions;
+    HandoffMessage message;
+    bool complete = false;
+    while (!complete && channel.receive(message)) {
+        switch (message.type) {
+            case HandoffMessageType::LISTENER:
+                listenSocket = message.fd;
+                if (message.port != port) {
+                    Logger::warning("Hot restart: inherited listener is on port " + std::to_string(message.port));
+                    port = message.port;
+                }
+                break;
+            case HandoffMessageType::SESSION:
+                if (message.fd >= 0) {
+                    sessions.emplace_back(message.fd, std::move(message.session));
+                }
+                break;
+            case HandoffMessageType::DONE:
+                complete = true;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    if (listenSocket == INVALID_SOCKET) {
+        Logger::error("Hot restart: previous process did not hand over its listener");
+        for (auto& session : sessions) {
+            close(session.first);
+        }
+        return false;
+    }
+    
+    setupListener();
+    if (settings.enableUdp && !openUdp()) {
+        Logger::warning("Hot restart: continuing without UDP");
+    }
+    
+    for (auto& session : sessions) {
+        if (!useEventLoop) {
+            // Resuming mid-stream needs the event loop's buffered reads
+            close(session.first);
+            continue;
+        }
+        
+        auto client = std::make_shared<Client>(session.first, session.second.ipAddress);
+        client->setSessionExecutor(std::make_shared<SerialExecutor>(workerPool));
+        client->setPlayerName(session.second.playerName);
+        client->setPlayerID(session.second.playerID);
+        client->setAuthenticated(session.second.authenticated);
+        client->importPending(session.second);
+        adoptedSessions.emplace_back(client, std::move(session.second));
+    }
+    
+    Logger::info("Hot restart: took over listener and " + std::to_string(adoptedSessions.size()) + " sessions");
+    return true;
+}
+
+void Server::adoptSessions() {
+    for (auto& adopted : adoptedSessions) {
+        auto client = adopted.first;
+        const SessionSnapshot& snapshot = adopted.second;
+        if (!client->attachEventLoop(eventLoop)) {
+            client->disconnect();
+            continue;
+        }
+        addClient(client);
+        admission.adopt(client);
+        
+        if (!snapshot.worldName.empty() && router) {
+            // Position restarts at the spawn point on the shard
+            auto frame = PacketBuilder::createStringPacket("action|join_request\nname|" + snapshot.worldName + "\n");
+            std::string worldName = snapshot.worldName;
+            client->getSessionExecutor()->post([this, client, worldName, frame] {
+                router->join(client, worldName, frame);
+            });
+        } else if (!snapshot.worldName.empty()) {
+            if (auto world = enterWorld(snapshot.worldName)) {
+                client->setWorld(world);
+                float x = static_cast<float>(snapshot.worldX);
+                float y = static_cast<float>(snapshot.worldY);
+                world->post([world, client, x, y] { world->addPlayer(client, x, y); });
+            }
+        }
+        
+        spawn(runSession(client, true));
+    }
+    adoptedSessions.clear();
+}
+#endif
+
+void Server::dispatchFrame(std::shared_ptr<Client> client, std::span<const uint8_t> packetData) {
+    if (!withinMemoryBudget(client)) {
+        return;
+    }
+    
+    // Decode here, then hand game logic to the worker pool so a slow
+    // handler never stalls this socket's reads
+    auto packet = std::make_shared<GamePacket>(PacketBuilder::parsePacket(packetData));
+    
+    static std::atomic<uint64_t> nextFlowID(1);
+    uint64_t flowID = nextFlowID++;
+    TRACE_FLOW_START("dispatch", flowID);
+    
+#ifdef __linux__
+    if (router) {
+        // Forwarded frames go out unchanged
+        auto frame = std::make_shared<std::vector<uint8_t>>(packetData.begin(), packetData.end());
+        client->getSessionExecutor()->post([this, client, packet, frame, flowID] {
+            TRACE_FLOW_END("dispatch", flowID);
+            routePacket(client, *packet, *frame);
+        });
+        return;
+    }
+#endif
+    
+    client->getSessionExecutor()->post([this, client, packet, flowID] {
+        TRACE_FLOW_END("dispatch", flowID);
+        dispatchPacket(client, *packet);
+    });
+}
+
+#ifdef __linux__
+void Server::enableRouter(const std::vector<std::string>& shardPaths) {
+    router = std::make_unique<ShardRouter>(shardPaths);
+}
+
+void Server::routePacket(std::shared_ptr<Client> client, const GamePacket& packet, const std::vector<uint8_t>& frame) {
+    // Logins are queued and checked here; shards trust the sessions we open
+    if (client->isInLoginQueue() || (accounts && !client->isAuthenticated())) {
+        dispatchPacket(client, packet);
+        return;
+    }
+    
+    // Joins pick the shard owning the world, moving the session if needed
+    std::string worldName;
+    if (packet.type == PacketType::STRING_PACKET &&
+        parseJoinRequest(std::string(packet.data.begin(), packet.data.end()), worldName)) {
+        if (!isValidWorldName(worldName)) {
+            client->sendPacket(*responses.get(StaticResponse::INVALID_WORLD_NAME));
+            return;
+        }
+        Logger::info(Logger::concat({"World join request from ", client->getIP(), " for world: ", worldName,
+                                     " (shard ", std::to_string(router->shardFor(worldName)), ")"}));
+        if (!router->join(client, worldName, frame)) {
+            client->sendPacket(*responses.get(StaticResponse::WORLD_UNAVAILABLE));
+        }
+        return;
+    }
+    
+    // Inside a world the shard handles everything, including chat and quit
+    if (router->forward(client, frame)) {
+        return;
+    }
+    
+    dispatchPacket(client, packet);
+}
+
+bool Server::initializeShard() {
+    // Routers hold few long-lived links; a blocking thread serves each
+    useEventLoop = false;
+    listenSocket = ShardLink::listen(shardPath);
+    return listenSocket != INVALID_SOCKET;
+}
+
+void Server::acceptShardLinks() {
+    while (running) {
+        int linkSocket = accept4(listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (linkSocket < 0) {
+            if (running && errno != EINTR) {
+                Logger::error("Failed to accept router connection. Error: " + std::to_string(errno));
+            }
+            continue;
+        }
+        
+        Logger::info("Router connected");
+        auto link = std::make_shared<ShardLink>(linkSocket);
+        std::lock_guard<std::mutex> lock(shardLinksMutex);
+        shardLinks.push_back(link);
+        shardLinkThreads.emplace_back(&Server::serveShardLink, this, link);
+    }
+}
+
+void Server::serveShardLink(std::shared_ptr<ShardLink> link) {
+    // Session IDs are only unique per router
+    std::unordered_map<uint32_t, std::shared_ptr<RemoteClient>> sessions;
+    ShardMessage message;
+    
+    while (link->receive(message)) {
+        auto it = sessions.find(message.sessionID);
+        
+        if (message.type == ShardMessageType::OPEN) {
+            if (it != sessions.end()) {
+                endRemoteSession(it->second);
+            }
+            auto client = std::make_shared<RemoteClient>(message.sessionID, message.ipAddress, link);
+            client->setSessionExecutor(std::make_shared<SerialExecutor>(workerPool));
+            client->setPlayerName(message.playerName);
+            client->setPlayerID(message.playerID);
+            sessions[message.sessionID] = client;
+            addClient(client);
+            Logger::info("Session from router: " + message.ipAddress + " (" + message.playerName + ")");
+        } else if (message.type == ShardMessageType::FRAME) {
+            if (it != sessions.end() && it->second->isConnected()) {
+                dispatchFrame(it->second, message.payload);
+            }
+        } else if (message.type == ShardMessageType::CLOSE) {
+            if (it != sessions.end()) {
+                endRemoteSession(it->second);
+                sessions.erase(it);
+            }
+        }
+    }
+    
+    if (running) {
+        Logger::warning("Router disconnected, ending " + std::to_string(sessions.size()) + " sessions");
+    }
+    for (auto& entry : sessions) {
+        endRemoteSession(entry.second);
+    }
+}
+
+void Server::endRemoteSession(std::shared_ptr<RemoteClient> client) {
+    client->detach();
+    removeClient(client);
+    
+    // Leave the world after any packets still queued for this session
+    client->getSessionExecutor()->post([this, client] { leaveWorld(client); });
+}
+#endif
+
 void Server::handleClient(std::shared_ptr<Client> client) {
-    Logger::info("Handling client: " + client->getIP());
+    Logger::info(Logger::concat({"Handling client: ", client->getIP()}));
     
     // Don't send welcome packet immediately - wait for client handshake
     Logger::debug("Waiting for client handshake...");
@@ -164,37 +1303,118 @@ void Server::handleClient(std::shared_ptr<Client> client) {
             break; // Client disconnected or error
         }
         
-        // Parse the packet
-        GamePacket packet = PacketBuilder::parsePacket(packetData);
-        
-        // Handle different packet types
-        if (packet.type == PacketType::STRING_PACKET) {
-            std::string message(packet.data.begin(), packet.data.end());
-            Logger::info("Received string packet from " + client->getIP() + ": " + message);
-            
-            // Handle login requests, world joins, etc.
-            handleStringPacket(client, message);
+        dispatchFrame(client, packetData);
+    }
+    
+    Logger::info(Logger::concat({"Client disconnected: ", client->getIP()}));
+    removeClient(client);
+    
+    // Leave the world after any packets still queued for this session
+    client->getSessionExecutor()->post([this, client] { leaveWorld(client); });
+}
+
+void Server::dispatchPacket(std::shared_ptr<Client> client, const GamePacket& packet) {
+    // A queued login waits for its slot; anything else it sends is moot
+    if (client->isInLoginQueue()) {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug(Logger::concat({"Ignoring packet from queued client ", client->getIP()}));
         }
-        else if (packet.type == PacketType::UPDATE_PACKET) {
-            Logger::debug("Received update packet from " + client->getIP());
-            // Handle player movement, actions, etc.
-            handleUpdatePacket(client, packet);
+        return;
+    }
+    
+    // Until a GrowID login succeeds, the logon packet is all we accept
+    if (accounts && !client->isAuthenticated()) {
+        std::string message(packet.data.begin(), packet.data.end());
+        if (packet.type != PacketType::STRING_PACKET || message.find("tankIDName|") == std::string::npos) {
+            Logger::warning(Logger::concat({"Dropping packet from unauthenticated client ", client->getIP()}));
+            client->sendPacket(*responses.get(StaticResponse::LOGIN_REQUIRED));
+            client->disconnect();
+            return;
         }
-        else {
-            Logger::debug("Received unknown packet type from " + client->getIP());
+    }
+    
+    // Handle different packet types
+    if (packet.type == PacketType::STRING_PACKET) {
+        std::string message(packet.data.begin(), packet.data.end());
+        Logger::info(Logger::concat({"Received string packet from ", client->getIP(), ": ", redactPassword(message)}));
+        
+        // Handle login requests, world joins, etc.
+        handleStringPacket(client, message);
+    }
+    else if (packet.type == PacketType::UPDATE_PACKET) {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug(Logger::concat({"Received update packet from ", client->getIP()}));
         }
+        // Handle player movement, actions, etc.
+        handleUpdatePacket(client, packet);
+    }
+    else {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug(Logger::concat({"Received unknown packet type from ", client->getIP()}));
+        }
+    }
+}
+
+std::shared_ptr<World> Server::enterWorld(const std::string& name) {
+    std::lock_guard<std::mutex> lock(worldsMutex);
+    auto it = worlds.find(name);
+    if (it != worlds.end()) {
+        it->second.members++;
+        return it->second.world;
     }
     
-    Logger::info("Client disconnected: " + client->getIP());
-    removeClient(client);
+    size_t limit = maxWorlds;
+    if (limit > 0 && worlds.size() >= limit) {
+        Logger::warning("World limit reached (" + std::to_string(limit) + "), not opening " + name);
+        return nullptr;
+    }
+    
+    // In per-core mode a world lives on one worker for good
+    size_t home = WorkerPool::ANY_WORKER;
+    if (workerPool.isPerCore()) {
+        home = std::hash<std::string>{}(name) % workerPool.getThreadCount();
+    }
+    auto world = std::make_shared<World>(name, workerPool, proximityRadius.load(), home);
+    worlds[name] = WorldEntry{world, 1};
+    Logger::info("Created world: " + name);
+    return world;
+}
+
+void Server::leaveWorld(std::shared_ptr<Client> client) {
+#ifdef __linux__
+    if (router) {
+        router->leave(client);
+        return;
+    }
+#endif
+    
+    auto world = client->getWorld();
+    if (!world) return;
+    
+    client->setWorld(nullptr);
+    world->post([world, client] { world->removePlayer(client); });
+    
+    // Queued tasks keep the World alive until they have run
+    std::lock_guard<std::mutex> lock(worldsMutex);
+    auto it = worlds.find(world->getName());
+    if (it != worlds.end() && it->second.world == world && --it->second.members == 0) {
+        worlds.erase(it);
+        Logger::info("Closed empty world: " + world->getName());
+    }
 }
 
 void Server::removeClient(std::shared_ptr<Client> client) {
-    std::lock_guard<std::mutex> lock(clientsMutex);
-    clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    }
+    
+    // A freed slot lets the next queued login in
+    applyAdmissionChanges(admission.disconnect(client.get()));
 }
 
 void Server::broadcastPacket(const std::vector<uint8_t>& packet, std::shared_ptr<Client> excludeClient) {
+    TRACE_SCOPE("broadcastPacket");
     std::lock_guard<std::mutex> lock(clientsMutex);
     for (auto& client : clients) {
         if (client != excludeClient && client->isConnected()) {
@@ -209,19 +1429,38 @@ size_t Server::getClientCount() const {
 }
 
 void Server::handleStringPacket(std::shared_ptr<Client> client, const std::string& message) {
-    Logger::info("Processing string packet from " + client->getIP() + ": " + message);
+    TRACE_SCOPE_ID("handleStringPacket", client->getConnectionID());
+    Logger::info(Logger::concat({"Processing string packet from ", client->getIP(), ": ", redactPassword(message)}));
     
     // Handle initial connection request (when client first connects)
     if (message.find("requestedName|") != std::string::npos || message.find("tankIDName|") != std::string::npos) {
-        Logger::info("Initial connection/login request from " + client->getIP());
+        Logger::info(Logger::concat({"Initial connection/login request from ", client->getIP()}));
         
-        // Send basic server response to allow connection
-        auto response = PacketBuilder::createStringPacket("type|onSuperMainStartAcceptLogon\nUBI_CONNECT_LOBBY_ID|0\nserver|127.0.0.1\nport|17091\ntype|onSuperMainStartAcceptLogon\nlogon_url|127.0.0.1\ntoken|1\nuser|2\nprotocol|171\nhash|rt\nfz|12345678\nf|1\ncp|12345\nbeta_server|1\ngame_version|4.54");
-        client->sendPacket(response);
+        // Wait for a player slot before any real work, such as hashing
+        size_t position = 0;
+        switch (admission.login(client, message, position)) {
+            case AdmissionControl::LoginResult::ADMITTED:
+                break;
+            case AdmissionControl::LoginResult::QUEUED:
+                Logger::info(Logger::concat({"Login queue: ", client->getIP(), " waiting at position ", std::to_string(position)}));
+                client->setInLoginQueue(true);
+                client->sendPacket(createQueuePositionPacket(position));
+                return;
+            case AdmissionControl::LoginResult::QUEUE_FULL:
+                Logger::warning(Logger::concat({"Login queue full, refusing ", client->getIP()}));
+                client->sendPacket(*responses.get(StaticResponse::SERVER_FULL));
+                client->disconnect();
+                return;
+        }
+        
+        if (accounts && !authenticate(client, message)) {
+            return;
+        }
         
-        // Send welcome message
-        auto welcome = PacketBuilder::createStringPacket("action|log\nmsg|`2Welcome to the Private Server!``\naction|log\nmsg|`9Server is running and ready!``");
-        client->sendPacket(welcome);
+        // Send basic server response to allow connection, then the welcome;
+        // both are prebuilt and identical for every player
+        client->sendPacket(*responses.get(StaticResponse::LOGON_ACCEPT));
+        client->sendPacket(*responses.get(StaticResponse::WELCOME));
         return;
     }
     
@@ -232,59 +1471,161 @@ void Server::handleStringPacket(std::shared_ptr<Client> client, const std::strin
         
         if (action == "login") {
             // Handle login request
-            Logger::info("Login request from " + client->getIP());
+            Logger::info(Logger::concat({"Login request from ", client->getIP()}));
             
             // For now, accept all logins
             auto response = PacketBuilder::createLoginResponse(true, "Welcome to the server!");
             client->sendPacket(response);
             
-            // Set a default player name
-            client->setPlayerName("Guest_" + std::to_string(rand() % 10000));
-            client->setPlayerID(static_cast<int>(clients.size()));
+            // GrowID players keep their account name; guests get a random one
+            if (!client->isAuthenticated()) {
+                client->setPlayerName("Guest_" + std::to_string(rand() % 10000));
+            }
+            client->setPlayerID(static_cast<int>(getClientCount()));
             
         } else if (action == "join_request") {
             // Handle world join request
-            size_t nameStart = message.find("name|");
-            if (nameStart != std::string::npos) {
-                size_t nameEnd = message.find('\n', nameStart);
-                std::string worldName = message.substr(nameStart + 5, nameEnd - nameStart - 5);
+            std::string worldName;
+            if (parseJoinRequest(message, worldName)) {
+                if (!isValidWorldName(worldName)) {
+                    client->sendPacket(*responses.get(StaticResponse::INVALID_WORLD_NAME));
+                    return;
+                }
+                Logger::info(Logger::concat({"World join request from ", client->getIP(), " for world: ", worldName}));
                 
-                Logger::info("World join request from " + client->getIP() + " for world: " + worldName);
+                // Enter before leaving: a player rejoining the only open
+                // world doesn't close and reopen it, and one refused by the
+                // world cap stays where they are
+                auto world = enterWorld(worldName);
+                if (!world) {
+                    client->sendPacket(*responses.get(StaticResponse::TOO_MANY_WORLDS));
+                    return;
+                }
+                leaveWorld(client);
+                client->setWorld(world);
                 
-                // Send world data
-                auto worldData = PacketBuilder::createWorldData(worldName);
-                client->sendPacket(worldData);
+                // Per-core mode: the player's game logic follows them to the world's core
+                if (client->getSessionExecutor()) {
+                    client->getSessionExecutor()->setHome(world->getHome());
+                }
                 
-                // Send player spawn data
-                auto playerData = PacketBuilder::createPlayerData(client->getPlayerID(), 
-                                                                client->getPlayerName(), 
-                                                                100, 100); // Default spawn position
-                client->sendPacket(playerData);
+                // World loading and membership belong to the world's executor
+                int playerID = client->getPlayerID();
+                std::string playerName(client->getPlayerName());
+                world->post([world, client, worldName, playerID, playerName] {
+                    world->addPlayer(client, SPAWN_X, SPAWN_Y);
+                    
+                    // Send world data
+                    auto worldData = PacketBuilder::createWorldData(worldName);
+                    client->sendPacket(worldData);
+                    
+                    // Send player spawn data
+                    auto playerData = PacketBuilder::createPlayerData(playerID, playerName,
+                                                                    SPAWN_X, SPAWN_Y);
+                    client->sendPacket(playerData);
+                });
             }
         } else if (action == "quit") {
-            Logger::info("Client " + client->getIP() + " requested disconnect");
+            Logger::info(Logger::concat({"Client ", client->getIP(), " requested disconnect"}));
             client->disconnect();
-        } else {
+        } else if (Logger::isEnabled(LogLevel::DEBUG)) {
             Logger::debug("Unknown action: " + action);
         }
     } else {
         // Handle other string messages (chat, etc.)
-        Logger::info("Chat message from " + client->getIP() + ": " + message);
+        Logger::info(Logger::concat({"Chat message from ", client->getIP(), ": ", message}));
         
         // Broadcast chat message to all clients
         auto chatPacket = PacketBuilder::createStringPacket("action|log\nmsg|" + 
-                                                           client->getPlayerName() + ": " + message);
+                                                           std::string(client->getPlayerName()) + ": " + message);
         broadcastPacket(chatPacket, client);
     }
 }
 
+bool Server::authenticate(std::shared_ptr<Client> client, const std::string& message) {
+    if (client->isAuthenticated()) {
+        return true;
+    }
+    
+    std::string name = getField(message, "tankIDName");
+    std::string password = getField(message, "tankIDPass");
+    
+    // Runs on the session executor: slow hashing never blocks socket I/O
+    auto result = accounts->login(name, password);
+    std::string failure;
+    switch (result) {
+        case AccountStore::LoginResult::CREATED:
+            Logger::info(Logger::concat({"Registered GrowID ", name, " for ", client->getIP()}));
+            [[fallthrough]];
+        case AccountStore::LoginResult::OK:
+            client->setPlayerName(name);
+            client->setAuthenticated(true);
+            return true;
+        case AccountStore::LoginResult::WRONG_PASSWORD:
+            failure = "`4Wrong password for " + name + ".``";
+            break;
+        case AccountStore::LoginResult::INVALID_NAME:
+            failure = "`4Please log in with a GrowID (3-18 letters or digits) and a password.``";
+            break;
+        case AccountStore::LoginResult::STORE_ERROR:
+            failure = "`4Login is unavailable right now, try again later.``";
+            break;
+    }
+    
+    Logger::warning(Logger::concat({"Login failed for ", client->getIP(), (name.empty() ? "" : " as " + name)}));
+    client->sendPacket(PacketBuilder::createStringPacket("action|log\nmsg|" + failure));
+    client->disconnect();
+    return false;
+}
+
 void Server::handleUpdatePacket(std::shared_ptr<Client> client, const GamePacket& packet) {
+    TRACE_SCOPE_ID("handleUpdatePacket", client->getConnectionID());
     // Handle player movement, block placement, etc.
-    Logger::debug("Update packet from " + client->getIP() + 
-                 " - Type: " + std::to_string(static_cast<int>(packet.objtype)) +
-                 " - NetID: " + std::to_string(packet.netid));
+    if (Logger::isEnabled(LogLevel::DEBUG)) {
+        Logger::debug(Logger::concat({"Update packet from ", client->getIP(),
+                                      " - Type: ", std::to_string(static_cast<int>(packet.objtype)),
+                                      " - NetID: ", std::to_string(packet.netid)}));
+    }
+    
+    // Placing or punching with an item that doesn't exist is a broken or
+    // malicious client; don't relay it
+    if (packet.objtype == static_cast<uint8_t>(UpdateType::TILE_CHANGE_REQUEST) &&
+        items.isLoaded() && !items.isValid(packet.item)) {
+        Logger::warning(Logger::concat({"Dropping tile change with unknown item ", std::to_string(packet.item), " from ", client->getIP()}));
+        return;
+    }
+    
+    auto updateData = std::make_shared<std::vector<uint8_t>>(PacketBuilder::createUpdatePacket(packet));
     
-    // For now, just broadcast the update to all other clients
-    auto updateData = PacketBuilder::createUpdatePacket(packet);
-    broadcastPacket(updateData, client);
+    // Updates stay inside the sender's world; players not in a world yet
+    // still broadcast to everyone
+    auto world = client->getWorld();
+    if (world) {
+        bool proximity = isProximityUpdate(packet);
+        bool movement = packet.objtype == static_cast<uint8_t>(UpdateType::STATE);
+        float x = packet.vec_x;
+        float y = packet.vec_y;
+        
+        // Positions index the spatial grid; off-map or non-finite ones
+        // can't be placed in it
+        if ((proximity || movement) && !World::containsPosition(x, y)) {
+            Logger::warning(Logger::concat({"Dropping update with position outside the world from ", client->getIP()}));
+            return;
+        }
+        
+        world->post([world, client, updateData, proximity, movement, x, y] {
+            if (movement) {
+                world->movePlayer(client, x, y);
+            }
+            if (proximity) {
+                // Each movement update replaces the last; over UDP a lost
+                // one is not worth stalling the next for
+                world->broadcastNearby(*updateData, x, y, client, movement);
+            } else {
+                world->broadcast(*updateData, client);
+            }
+        });
+    } else {
+        broadcastPacket(*updateData, client);
+    }
 }
\ No newline at end of file
@@ -24,9 +24,28 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include "Client.h"
+#include "World.h"
+#include "WorkerPool.h"
+#include "AccountStore.h"
+#include "ItemDatabase.h"
+#include "ResponseCache.h"
+#include "ServerSettings.h"
+#include "AdmissionControl.h"
+#include "UdpTransport.h"
+
+#ifdef __linux__
+    #include "EventLoop.h"
+    #include "Task.h"
+    #include "HotRestart.h"
+    #include "ShardLink.h"
+    #include "ShardRouter.h"
+    #include "RemoteClient.h"
+#endif
 
 // Forward declaration
 struct GamePacket;
@@ -40,19 +59,223 @@ private:
     std::mutex clientsMutex;
     std::thread acceptThread;
     
+    // Event-loop mode: one thread multiplexes every connection through
+    // coroutine sessions instead of a blocking thread per client
+    bool useEventLoop;
+#ifdef __linux__
+    bool useIoUring;
+    EventLoop eventLoop;
+    std::thread ioThread;
+    
+    Task<void> acceptLoop(EventLoop& loop, socket_t listener, size_t core);
+    Task<void> runSession(std::shared_ptr<Client> client, bool resumed = false);
+    
+    // Shard-per-core mode: core k has its own event loop, receive buffer
+    // pool and SO_REUSEPORT listener, all on one CPU, and pool worker k on
+    // the same CPU runs its sessions' game logic. The kernel spreads new
+    // connections over the listeners. Empty outside this mode.
+    struct CoreShard {
+        EventLoop loop;
+        std::thread thread;
+        socket_t listener = INVALID_SOCKET;   // Core 0 uses listenSocket
+        std::atomic<uint64_t> accepted{0};
+    };
+    std::vector<std::unique_ptr<CoreShard>> cores;
+    bool setupCores();
+    
+    // Hot restart: control socket for a successor process, sessions adopted
+    // from a predecessor, and the drain that follows a handoff
+    std::string hotRestartPath;
+    int controlSocket;
+    std::thread controlThread;
+    std::atomic<bool> listenerHandedOff;
+    std::atomic<bool> draining;
+    bool drainStarted;
+    std::chrono::steady_clock::time_point drainStart;
+    std::vector<std::pair<std::shared_ptr<Client>, SessionSnapshot>> adoptedSessions;
+    
+    void controlLoop();
+    void handOff(HandoffChannel& channel);
+    void handOffSessions(HandoffChannel& channel);
+    void adoptSessions();
+    bool setupListener();
+    
+    // World sharding. As a shard, sessions arrive from front-door routers
+    // over Unix sockets instead of TCP; as a router, sessions inside a world
+    // are forwarded to the shard that owns it.
+    std::string shardPath;
+    std::vector<std::shared_ptr<ShardLink>> shardLinks;
+    std::vector<std::thread> shardLinkThreads;
+    std::mutex shardLinksMutex;
+    std::unique_ptr<ShardRouter> router;
+    
+    bool initializeShard();
+    void acceptShardLinks();
+    void serveShardLink(std::shared_ptr<ShardLink> link);
+    void endRemoteSession(std::shared_ptr<RemoteClient> client);
+    void routePacket(std::shared_ptr<Client> client, const GamePacket& packet, const std::vector<uint8_t>& frame);
+#endif
+    
+    // Open worlds. `members` counts sessions that entered and haven't left
+    // yet, including joins whose addPlayer hasn't run; the world closes
+    // when it drops to zero.
+    struct WorldEntry {
+        std::shared_ptr<World> world;
+        size_t members = 0;
+    };
+    std::unordered_map<std::string, WorldEntry> worlds;
+    std::mutex worldsMutex;
+    std::atomic<size_t> maxWorlds;
+    std::atomic<float> proximityRadius;
+    
+    // Item metadata for tile changes; empty when no database was loaded
+    ItemDatabase items;
+    
+    // Prebuilt frames for fixed messages, rebuilt from `identity` whenever
+    // it or the item database changes
+    ServerIdentity identity;
+    ResponseCache responses;
+    void rebuildResponses();
+    
+    // Options set on accepted sockets; reloadable, so read atomically
+    std::atomic<bool> tcpNoDelay;
+    std::atomic<int> sendBufferSize;
+    std::atomic<int> receiveBufferSize;
+    void applySocketOptions(socket_t socket);
+    
+    // config.ini as last applied; SIGHUP has the next housekeeping tick re-read it
+    ServerSettings settings;
+    std::string configPath;
+    std::atomic<bool> reloadRequested;
+    std::atomic<int> tickRate;
+    void applyReloadable(const ServerSettings& next);
+    
+    // Per-session memory budget in bytes, 0 for none; reloadable. Checked
+    // as frames arrive and on every housekeeping tick.
+    std::atomic<size_t> maxSessionMemory;
+    std::atomic<bool> memoryReportRequested;
+    bool withinMemoryBudget(const std::shared_ptr<Client>& client);
+    void enforceMemoryBudgets();
+    void logMemoryReport();
+    
+    // One pass of signal-driven housekeeping: trace dumps, config reloads,
+    // memory budgets and reports, and the exit after a hot-restart drain.
+    // Both run() and runDaemon() call it tickRate times a second.
+    void housekeepingTick();
+    
+    // CPUs from thread_placement; empty when threads aren't pinned. Slot 0
+    // is the I/O thread, game-logic workers follow.
+    std::vector<int> threadPlacement;
+    void placeThread(std::thread& thread, size_t slot);
+    void logCoreStats();
+    void reloadConfig();
+    
+    // Connection caps and the login queue
+    AdmissionControl admission;
+    bool admitConnection(const std::shared_ptr<Client>& client);
+    void applyAdmissionChanges(AdmissionControl::Changes changes);
+    void applyAdmissionLimits(const ServerSettings& source);
+    
+    // Reliable UDP for the game client on the same port number as TCP;
+    // null when disabled. Its thread feeds frames into the same dispatch.
+    std::unique_ptr<UdpTransport> udp;
+    std::thread udpThread;
+    bool openUdp();
+    void stopUdp();
+    
+    // GrowID logins; null when authentication is off and everyone is a guest
+    std::unique_ptr<AccountStore> accounts;
+    
+    // Game logic runs here; connection threads only read and decode frames.
+    // Declared last so it is joined before the state its tasks touch is destroyed.
+    WorkerPool workerPool;
+    
+    void startIO();
     void acceptClients();
     void handleClient(std::shared_ptr<Client> client);
+    std::shared_ptr<Client> createClient(socket_t clientSocket, const sockaddr_in& clientAddr,
+                                         size_t home = WorkerPool::ANY_WORKER);
+    void addClient(std::shared_ptr<Client> client);
     void removeClient(std::shared_ptr<Client> client);
     
-    // Packet handling methods
+    // Decodes a frame on the I/O side and posts it to the session executor
+    void dispatchFrame(std::shared_ptr<Client> client, std::span<const uint8_t> packetData);
+    
+    // Counts the caller as a member, opening the world if needed; null if
+    // that would pass max_worlds. Pair with leaveWorld().
+    std::shared_ptr<World> enterWorld(const std::string& name);
+    void leaveWorld(std::shared_ptr<Client> client);
+    
+    // Packet handling methods (run on the client's session executor)
+    void dispatchPacket(std::shared_ptr<Client> client, const GamePacket& packet);
     void handleStringPacket(std::shared_ptr<Client> client, const std::string& message);
     void handleUpdatePacket(std::shared_ptr<Client> client, const GamePacket& packet);
+    bool authenticate(std::shared_ptr<Client> client, const std::string& message);
+    
+    // Microbenchmarks drive the private handlers directly
+    friend class ServerBench;
     
 public:
-    Server(int port);
+    // A non-zero `coreShards` runs shard-per-core: that many pinned workers
+    // and, with the Linux event loop, as many event loops
+    Server(int port, size_t workerThreads = 0, size_t coreShards = 0);
     ~Server();
     
+    // Applies settings read from the config file at `path`; call before
+    // initialize(). The port and worker thread count are constructor
+    // arguments, since both are fixed for the life of the process.
+    void configure(const ServerSettings& newSettings, const std::string& path);
+    
+    // Async-signal-safe; the next housekeeping tick re-reads the config
+    // file and applies the reloadable settings
+    void requestReload() { reloadRequested = true; }
+    
+    // Async-signal-safe; the next housekeeping tick logs per-session and
+    // total memory use
+    void requestMemoryReport() { memoryReportRequested = true; }
+    
+    // Movement and effect updates only reach players this close (in world
+    // pixels, 32 per tile); 0 delivers them world-wide. Applies to new worlds.
+    void setProximityRadius(float radius) { proximityRadius.store(radius); }
+    
+    // Require a GrowID name and password, checked against (and registered
+    // in) the account store at this path; call before initialize()
+    bool enableAuthentication(const std::string& storePath);
+    
+    // Map the binary item database; call before initialize(). Without one,
+    // tile changes are relayed unchecked.
+    bool loadItems(const std::string& path);
+    
+    // Address, version and MOTD shown to clients; the port and item hash
+    // always come from the server itself
+    void setIdentity(const ServerIdentity& newIdentity);
+    
+    // Must be chosen before initialize(); only available on Linux
+    void setUseEventLoop(bool enabled);
+    
+    // Event-loop mode only: complete socket I/O through io_uring, falling
+    // back to epoll when the kernel can't; call before initialize()
+    void setUseIoUring(bool enabled);
+    
     bool initialize();
+    
+#ifdef __linux__
+    // Accept hot-restart requests on this Unix socket path
+    void enableHotRestart(const std::string& controlPath) { hotRestartPath = controlPath; }
+    
+    // Alternative to initialize(): take the listening socket and live
+    // sessions over from the server owning the hot-restart path
+    bool takeover();
+    
+    // Serve worlds for front-door routers on this Unix socket path instead
+    // of accepting game clients; call before initialize()
+    void enableShard(const std::string& path) { shardPath = path; }
+    bool isShard() const { return !shardPath.empty(); }
+    
+    // Front-door mode: terminate client connections here and hand sessions
+    // to the world shards listening on these paths; call before initialize()
+    void enableRouter(const std::vector<std::string>& shardPaths);
+#endif
     void run();
     void runDaemon();
     void stop();
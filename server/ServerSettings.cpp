@@ -0,0 +1,85 @@
+#include "ServerSettings.h"
+#include "../utils/Config.h"
+#include "../utils/CpuAffinity.h"
+
+namespace {
+    // Tiles are 32 pixels; the config counts in tiles
+    const float TILE_SIZE = 32.0f;
+
+    // Reads an integer key, keeping `value` when absent or outside [low, high]
+    template <typename T>
+    void readRange(const Config& config, const char* section, const char* key, T& value, long long low, long long high) {
+        if (!config.has(section, key)) return;
+
+        long long read = config.getInt(section, key, static_cast<int>(value));
+        if (read < low || read > high) {
+            Logger::warning(std::string("Config ") + section + "." + key + " must be between " +
+                            std::to_string(low) + " and " + std::to_string(high) + ", keeping " + std::to_string(value));
+            return;
+        }
+        value = static_cast<T>(read);
+    }
+}
+
+bool ServerSettings::load(const std::string& path) {
+    Config config;
+    if (!config.load(path)) {
+        return false;
+    }
+
+    readRange(config, "Server", "port", port, 0, 65535);
+    readRange(config, "Server", "max_clients", maxClients, 0, 1000000);
+    readRange(config, "Server", "max_connections_per_ip", maxConnectionsPerIP, 0, 1000000);
+    readRange(config, "Server", "login_queue_size", loginQueueSize, 0, 1000000);
+    fileLogging = config.getBool("Server", "enable_file_logging", fileLogging);
+    logFile = config.getString("Server", "log_file", logFile);
+    if (config.has("Server", "log_level")) {
+        std::string level = config.getString("Server", "log_level", "");
+        if (!Logger::parseLevel(level, logLevel)) {
+            Logger::warning("Config Server.log_level must be debug, info, warning or error: " + level);
+        }
+    }
+    readRange(config, "Server", "tick_rate", tickRate, 1, 1000);
+    identity.address = config.getString("Server", "public_address", identity.address);
+    identity.motd = config.getString("Game", "motd", identity.motd);
+
+    readRange(config, "Network", "worker_threads", workerThreads, 0, 1024);
+    readRange(config, "Network", "core_shards", coreShards, 0, 1024);
+    if (config.has("Network", "thread_placement")) {
+        std::string spec = config.getString("Network", "thread_placement", "");
+        std::vector<int> cpus;
+        if (CpuAffinity::parse(spec, cpus)) {
+            threadPlacement = spec;
+        } else {
+            Logger::warning("Config Network.thread_placement must be none, auto or a CPU list like 0-3,8: " + spec);
+        }
+    }
+    tcpNoDelay = config.getBool("Network", "tcp_nodelay", tcpNoDelay);
+    readRange(config, "Network", "send_buffer_size", sendBufferSize, 0, 64 * 1024 * 1024);
+    readRange(config, "Network", "receive_buffer_size", receiveBufferSize, 0, 64 * 1024 * 1024);
+    readRange(config, "Network", "max_packet_size", limits.maxPacketSize, 64, 64 * 1024 * 1024);
+    readRange(config, "Network", "max_outbound_bytes", limits.maxOutboundBytes, 64 * 1024, 1024 * 1024 * 1024);
+    readRange(config, "Network", "receive_chunk_size", limits.receiveChunkSize, 512, 16 * 1024 * 1024);
+    readRange(config, "Network", "max_session_memory", maxSessionMemory, 0, 1024 * 1024 * 1024);
+
+    unsigned bufferCount = ringBufferCount;
+    readRange(config, "Network", "ring_buffer_count", bufferCount, 1, 32768);
+    if ((bufferCount & (bufferCount - 1)) != 0) {
+        Logger::warning("Config Network.ring_buffer_count must be a power of two, keeping " + std::to_string(ringBufferCount));
+    } else {
+        ringBufferCount = bufferCount;
+    }
+    readRange(config, "Network", "ring_buffer_size", ringBufferSize, 512, 1024 * 1024);
+    enableUdp = config.getBool("Network", "enable_udp", enableUdp);
+    udpChecksum = config.getBool("Network", "udp_checksum", udpChecksum);
+
+    readRange(config, "Game", "max_worlds", maxWorlds, 0, 1000000);
+    int radiusTiles = static_cast<int>(proximityRadius / TILE_SIZE);
+    readRange(config, "Game", "proximity_radius", radiusTiles, 0, 100000);
+    proximityRadius = radiusTiles * TILE_SIZE;
+    itemsFile = config.getString("Game", "items_file", itemsFile);
+
+    enableAuthentication = config.getBool("Security", "enable_authentication", enableAuthentication);
+    accountsFile = config.getString("Security", "accounts_file", accountsFile);
+    return true;
+}
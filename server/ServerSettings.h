@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Client.h"
+#include "ResponseCache.h"
+#include "../utils/Logger.h"
+#include <string>
+#include <cstddef>
+
+// Everything config.ini controls. A missing file or key keeps the default
+// below. Fields marked reloadable are re-applied on SIGHUP; the rest only
+// take effect on restart.
+struct ServerSettings {
+    // [Server]
+    int port = 17091;
+    size_t maxClients = 100;              // Players; later logins queue. 0 = unlimited; reloadable
+    size_t maxConnectionsPerIP = 10;      // 0 = unlimited; reloadable
+    size_t loginQueueSize = 200;          // Logins that may wait for a slot; reloadable
+    bool fileLogging = true;              // Reloadable (reopens the file, e.g. after rotation)
+    std::string logFile = "server.log";   // Reloadable
+    LogLevel logLevel = LogLevel::DEBUG;  // Reloadable
+    int tickRate = 1;                     // Housekeeping passes per second; reloadable
+    ServerIdentity identity;              // public_address, plus [Game] motd; reloadable
+
+    // [Network]
+    size_t workerThreads = 0;             // Game-logic threads; 0 = one per core
+    size_t coreShards = 0;                // Shard-per-core mode with this many cores; 0 = off
+    std::string threadPlacement = "none"; // CPUs to pin threads to: none, auto or a list like 0-3,8
+    bool tcpNoDelay = true;               // Reloadable, for new connections
+    int sendBufferSize = 0;               // SO_SNDBUF bytes, 0 = OS default; reloadable, for new connections
+    int receiveBufferSize = 0;            // SO_RCVBUF bytes, 0 = OS default; reloadable, for new connections
+    ConnectionLimits limits;
+    size_t maxSessionMemory = 0;          // Bytes one session may hold before it is dropped, 0 = no cap; reloadable
+    unsigned ringBufferCount = 256;       // io_uring provided receive buffers (power of two)
+    size_t ringBufferSize = 16 * 1024;
+    bool enableUdp = true;                // ENet-compatible UDP on the same port number
+    bool udpChecksum = true;              // CRC32 on every datagram, as the game client expects
+
+    // [Game]
+    size_t maxWorlds = 1000;              // Worlds open at once (empty ones close); 0 = unlimited; reloadable
+    float proximityRadius = 32.0f * 32.0f; // Pixels; reloadable, for worlds created afterwards
+    std::string itemsFile = "items.dat";
+
+    // [Security]
+    bool enableAuthentication = false;
+    std::string accountsFile = "accounts.db";
+
+    // False if the file can't be read; invalid values are logged and skipped
+    bool load(const std::string& path);
+};
@@ -0,0 +1,76 @@
+#include "SessionArena.h"
+#include <algorithm>
+#include <memory>
+#include <new>
+
+namespace {
+    // Most sessions never need more than the first chunk
+    const size_t FIRST_CHUNK_SIZE = 1024;
+    const size_t MAX_CHUNK_SIZE = 8 * 1024;
+}
+
+std::atomic<size_t> SessionArena::liveArenas(0);
+std::atomic<size_t> SessionArena::totalBytes(0);
+
+SessionArena::SessionArena()
+    : chunks(nullptr), cursor(nullptr), remaining(0), nextChunkSize(FIRST_CHUNK_SIZE), bytesInUse(0) {
+    liveArenas.fetch_add(1, std::memory_order_relaxed);
+}
+
+SessionArena::~SessionArena() {
+    // Containers using the arena are gone by now; their large blocks have
+    // been returned, so only the chunks are left to free
+    while (chunks) {
+        Chunk* next = chunks->next;
+        refund(sizeof(Chunk) + chunks->size);
+        ::operator delete(chunks);
+        chunks = next;
+    }
+    totalBytes.fetch_sub(bytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    liveArenas.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SessionArena::charge(size_t bytes) {
+    bytesInUse.fetch_add(bytes, std::memory_order_relaxed);
+    totalBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void SessionArena::refund(size_t bytes) {
+    bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    totalBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void* SessionArena::do_allocate(size_t bytes, size_t alignment) {
+    if (bytes > SMALL_BLOCK_LIMIT || alignment > alignof(std::max_align_t)) {
+        void* block = ::operator new(bytes, std::align_val_t(alignment));
+        charge(bytes);
+        return block;
+    }
+
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    void* block = cursor;
+    if (!cursor || !std::align(alignment, bytes, block, remaining)) {
+        size_t size = nextChunkSize;
+        nextChunkSize = std::min(nextChunkSize * 2, MAX_CHUNK_SIZE);
+
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+        chunk->next = chunks;
+        chunk->size = size;
+        chunks = chunk;
+        charge(sizeof(Chunk) + size);
+
+        block = chunk + 1;
+        remaining = size;
+    }
+    cursor = static_cast<unsigned char*>(block) + bytes;
+    remaining -= bytes;
+    return block;
+}
+
+void SessionArena::do_deallocate(void* block, size_t bytes, size_t alignment) {
+    // Small blocks stay until the arena goes
+    if (bytes > SMALL_BLOCK_LIMIT || alignment > alignof(std::max_align_t)) {
+        ::operator delete(block, std::align_val_t(alignment));
+        refund(bytes);
+    }
+}
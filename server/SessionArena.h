@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+// Allocator for the data one session owns for its whole life. Small blocks
+// (names, the first bytes of each buffer) are carved from chunks that are
+// only freed, all at once, when the arena is destroyed; larger ones come
+// from the heap one by one, so a buffer that grows doesn't leave its old
+// copies behind. Both count toward the session and a process-wide total.
+// Thread-safe, since a session's buffers are touched from several threads.
+class SessionArena : public std::pmr::memory_resource {
+public:
+    // Blocks up to this size come from chunks
+    static const size_t SMALL_BLOCK_LIMIT = 256;
+
+    SessionArena();
+    ~SessionArena();
+
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    // Chunks plus live large blocks
+    size_t getBytesInUse() const { return bytesInUse.load(std::memory_order_relaxed); }
+
+    // Every arena in the process
+    static size_t getLiveArenas() { return liveArenas.load(std::memory_order_relaxed); }
+    static size_t getTotalBytes() { return totalBytes.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* next;
+        size_t size;     // Usable bytes after the header
+    };
+
+    std::mutex chunkMutex;
+    Chunk* chunks;
+    unsigned char* cursor;
+    size_t remaining;
+    size_t nextChunkSize;
+    std::atomic<size_t> bytesInUse;
+
+    static std::atomic<size_t> liveArenas;
+    static std::atomic<size_t> totalBytes;
+
+    void charge(size_t bytes);
+    void refund(size_t bytes);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* block, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
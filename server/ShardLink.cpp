@@ -0,0 +1,368 @@
+#include "ShardLink.h"
+#include "WireFormat.h"
+#include "../utils/Logger.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+namespace {
+    // Type and session ID follow the length prefix of every message; ring
+    // records carry the same bytes without the prefix
+    const size_t HEADER_SIZE = sizeof(uint32_t) + 1 + sizeof(uint32_t);
+    const size_t RECORD_HEADER_SIZE = HEADER_SIZE - sizeof(uint32_t);
+    
+    // A maximum-size client frame plus room for the message fields
+    const uint32_t MAX_MESSAGE_SIZE = 1024 * 1024 + 4096;
+    
+    // Memory, data and space descriptors for each of the two rings
+    const size_t RING_FD_COUNT = 6;
+    
+    // Senders blocked on a full ring re-check the peer this often
+    const int RING_WAIT_MS = 100;
+    
+    bool fillAddress(const std::string& path, sockaddr_un& address) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            Logger::error("Shard socket path too long: " + path);
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+    }
+    
+    // Decodes a message without its length prefix
+    bool parseMessage(const uint8_t* data, size_t length, ShardMessage& message) {
+        if (length < RECORD_HEADER_SIZE) {
+            return false;
+        }
+        message.type = static_cast<ShardMessageType>(data[0]);
+        std::memcpy(&message.sessionID, data + 1, sizeof(message.sessionID));
+        data += RECORD_HEADER_SIZE;
+        length -= RECORD_HEADER_SIZE;
+        
+        if (message.type == ShardMessageType::FRAME) {
+            message.payload = std::span<const uint8_t>(data, length);
+            return true;
+        }
+        
+        message.payload = {};
+        if (message.type == ShardMessageType::OPEN) {
+            WireReader reader(data, length);
+            message.ipAddress = reader.str();
+            message.playerName = reader.str();
+            message.playerID = reader.i32();
+            if (!reader.ok) {
+                Logger::error("Shard link: malformed OPEN message");
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+ShardLink::ShardLink(int fd) : fd(fd), open(fd >= 0), activeSendRing(nullptr), holdingRecord(false) {
+}
+
+ShardLink::~ShardLink() {
+    for (int received : receivedFds) {
+        close(received);
+    }
+    if (fd >= 0) close(fd);
+}
+
+std::shared_ptr<ShardLink> ShardLink::connect(const std::string& path) {
+    sockaddr_un address;
+    if (!fillAddress(path, address)) return nullptr;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return nullptr;
+    
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        Logger::error("No world shard listening on " + path + ". Error: " + std::to_string(errno));
+        close(fd);
+        return nullptr;
+    }
+    return std::make_shared<ShardLink>(fd);
+}
+
+int ShardLink::listen(const std::string& path) {
+    sockaddr_un address;
+    if (!fillAddress(path, address)) return -1;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        Logger::error("Failed to create shard socket. Error: " + std::to_string(errno));
+        return -1;
+    }
+    
+    // A previous shard process may have left the file behind
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        Logger::error("Failed to bind shard socket " + path + ". Error: " + std::to_string(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool ShardLink::offerSharedMemory(size_t capacity) {
+    // Both directions may have several writers (session executors, workers)
+    auto outbound = ShmRing::create(capacity, ShmRing::Producers::MULTIPLE);
+    auto inbound = ShmRing::create(capacity, ShmRing::Producers::MULTIPLE);
+    if (!outbound || !inbound || outbound->getMaxRecordSize() < MAX_MESSAGE_SIZE) {
+        return false;
+    }
+    
+    // The shard's receive ring is our send ring and vice versa
+    int fds[RING_FD_COUNT] = {
+        outbound->getMemoryFd(), outbound->getDataFd(), outbound->getSpaceFd(),
+        inbound->getMemoryFd(), inbound->getDataFd(), inbound->getSpaceFd()
+    };
+    
+    uint8_t message[HEADER_SIZE] = {};
+    uint32_t length = static_cast<uint32_t>(RECORD_HEADER_SIZE);
+    std::memcpy(message, &length, sizeof(length));
+    message[sizeof(length)] = static_cast<uint8_t>(ShardMessageType::RINGS);
+    
+    iovec io{message, sizeof(message)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(fds))];
+    std::memset(control, 0, sizeof(control));
+    msghdr header{};
+    header.msg_iov = &io;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    
+    std::lock_guard<std::mutex> lock(sendMutex);
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &header, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != static_cast<ssize_t>(sizeof(message))) {
+        Logger::warning("Shard link: could not offer shared memory. Error: " + std::to_string(errno));
+        return false;
+    }
+    
+    sendRing = std::move(outbound);
+    receiveRing = std::move(inbound);
+    activeSendRing = sendRing.get();
+    return true;
+}
+
+bool ShardLink::attachRings() {
+    if (receivedFds.size() != RING_FD_COUNT) {
+        Logger::error("Shard link: RINGS message without descriptors");
+        return false;
+    }
+    
+    // Ownership of the descriptors moves into the rings
+    std::vector<int> fds;
+    fds.swap(receivedFds);
+    receiveRing = ShmRing::attach(fds[0], fds[1], fds[2]);
+    sendRing = ShmRing::attach(fds[3], fds[4], fds[5]);
+    if (!receiveRing || !sendRing) {
+        Logger::error("Shard link: failed to map shared-memory rings");
+        return false;
+    }
+    
+    activeSendRing = sendRing.get();
+    Logger::info("Shard link using shared-memory rings");
+    return true;
+}
+
+bool ShardLink::peerGone() const {
+    // After the switch to rings nothing else arrives on the socket, so
+    // readability means EOF
+    pollfd waiter{fd, POLLIN | POLLRDHUP, 0};
+    return poll(&waiter, 1, 0) != 0;
+}
+
+bool ShardLink::sendRaw(ShardMessageType type, uint32_t sessionID, std::span<const uint8_t> body) {
+    if (!open) return false;
+    
+    uint32_t length = static_cast<uint32_t>(RECORD_HEADER_SIZE + body.size());
+    uint8_t header[HEADER_SIZE];
+    std::memcpy(header, &length, sizeof(length));
+    header[sizeof(length)] = static_cast<uint8_t>(type);
+    std::memcpy(header + sizeof(length) + 1, &sessionID, sizeof(sessionID));
+    
+    if (ShmRing* ring = activeSendRing.load(std::memory_order_acquire)) {
+        return sendToRing(*ring, header + sizeof(length), RECORD_HEADER_SIZE, body);
+    }
+    
+    iovec parts[2] = {
+        {header, sizeof(header)},
+        {const_cast<uint8_t*>(body.data()), body.size()}
+    };
+    
+    // Messages from different threads must not interleave on the stream
+    std::lock_guard<std::mutex> lock(sendMutex);
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = body.empty() ? 1 : 2;
+    size_t remaining = sizeof(header) + body.size();
+    
+    while (remaining > 0) {
+        ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) {
+            if (open.exchange(false)) {
+                Logger::error("Shard link send failed. Error: " + std::to_string(errno));
+            }
+            return false;
+        }
+        
+        remaining -= static_cast<size_t>(sent);
+        size_t skip = static_cast<size_t>(sent);
+        while (message.msg_iovlen > 0 && skip >= message.msg_iov->iov_len) {
+            skip -= message.msg_iov->iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base = static_cast<uint8_t*>(message.msg_iov->iov_base) + skip;
+            message.msg_iov->iov_len -= skip;
+        }
+    }
+    return true;
+}
+
+bool ShardLink::sendToRing(ShmRing& ring, const uint8_t* header, size_t headerSize, std::span<const uint8_t> body) {
+    iovec parts[2] = {
+        {const_cast<uint8_t*>(header), headerSize},
+        {const_cast<uint8_t*>(body.data()), body.size()}
+    };
+    
+    // A full ring means the peer is behind; wait for it like a blocking send
+    while (!ring.tryWrite(parts, 2)) {
+        if (headerSize + body.size() > ring.getMaxRecordSize()) {
+            Logger::error("Shard link: message too large for ring");
+            return false;
+        }
+        ring.waitWritable(headerSize + body.size(), RING_WAIT_MS, fd);
+        if (!open || peerGone()) {
+            open = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShardLink::sendOpen(uint32_t sessionID, std::string_view ipAddress, std::string_view playerName, int32_t playerID) {
+    WireWriter writer;
+    writer.str(ipAddress);
+    writer.str(playerName);
+    writer.i32(playerID);
+    return sendRaw(ShardMessageType::OPEN, sessionID, writer.bytes);
+}
+
+bool ShardLink::sendFrame(uint32_t sessionID, std::span<const uint8_t> payload) {
+    // The frame is the whole body; no copy through a writer
+    return sendRaw(ShardMessageType::FRAME, sessionID, payload);
+}
+
+bool ShardLink::sendClose(uint32_t sessionID) {
+    return sendRaw(ShardMessageType::CLOSE, sessionID, {});
+}
+
+bool ShardLink::receiveAll(uint8_t* data, size_t length) {
+    while (length > 0) {
+        iovec io{data, length};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * RING_FD_COUNT)];
+        msghdr header{};
+        header.msg_iov = &io;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        
+        ssize_t received = recvmsg(fd, &header, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (size_t i = 0; i < count; ++i) {
+                    int passed;
+                    std::memcpy(&passed, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                    receivedFds.push_back(passed);
+                }
+            }
+        }
+        
+        data += received;
+        length -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool ShardLink::receiveFromSocket(ShardMessage& message) {
+    uint32_t length = 0;
+    if (!receiveAll(reinterpret_cast<uint8_t*>(&length), sizeof(length))) {
+        return false;
+    }
+    if (length < RECORD_HEADER_SIZE || length > MAX_MESSAGE_SIZE) {
+        Logger::error("Shard link: invalid message length " + std::to_string(length));
+        return false;
+    }
+    
+    receiveBuffer.resize(length);
+    if (!receiveAll(receiveBuffer.data(), receiveBuffer.size())) {
+        return false;
+    }
+    return parseMessage(receiveBuffer.data(), receiveBuffer.size(), message);
+}
+
+bool ShardLink::receiveFromRing(ShardMessage& message) {
+    for (;;) {
+        uint32_t length = 0;
+        if (const uint8_t* data = receiveRing->peek(length)) {
+            // Released on the next receive(), once the caller is done with it
+            holdingRecord = true;
+            return parseMessage(data, length, message);
+        }
+        
+        // Drain what the peer wrote before it went away
+        if (receiveRing->isCorrupt() || !open || peerGone()) {
+            return false;
+        }
+        receiveRing->waitReadable(-1, fd);
+    }
+}
+
+bool ShardLink::receive(ShardMessage& message) {
+    if (holdingRecord) {
+        receiveRing->release();
+        holdingRecord = false;
+    }
+    
+    for (;;) {
+        bool received = receiveRing ? receiveFromRing(message) : receiveFromSocket(message);
+        if (!received) {
+            open = false;
+            return false;
+        }
+        if (message.type != ShardMessageType::RINGS) {
+            return true;
+        }
+        // Only ever offered over the socket
+        if (holdingRecord || !attachRings()) {
+            open = false;
+            return false;
+        }
+    }
+}
+
+void ShardLink::shutdown() {
+    open = false;
+    ::shutdown(fd, SHUT_RDWR);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "ShmRing.h"
+
+// World sharding: a front-door router terminates client connections and
+// multiplexes every session that is inside a world over one Unix stream
+// socket per world shard. Each message is length-prefixed:
+//
+//   router -> shard   OPEN  (session, ip, player)  session enters this shard
+//                     FRAME (session, payload)     client frame to handle
+//                     CLOSE (session)              session left or migrated
+//   shard -> router   FRAME (session, payload)     frame for the client
+//                     CLOSE (session)              shard ended the session;
+//                                                  the router answers CLOSE
+//
+// Payloads are whole frames as returned by Client::receivePacket.
+//
+// Right after connecting, the router offers a pair of shared-memory rings
+// (RINGS, descriptors passed with SCM_RIGHTS). From then on every message
+// goes through the rings and the socket only signals that the peer is gone.
+
+enum class ShardMessageType : uint8_t {
+    OPEN = 1,
+    FRAME = 2,
+    CLOSE = 3,
+    RINGS = 4   // Link-internal, never returned by receive()
+};
+
+struct ShardMessage {
+    ShardMessageType type;
+    uint32_t sessionID = 0;
+    std::string ipAddress;          // OPEN
+    std::string playerName;         // OPEN
+    int32_t playerID = -1;          // OPEN
+    
+    // FRAME: a view into the ring record or the link's receive buffer,
+    // valid until the next receive()
+    std::span<const uint8_t> payload;
+};
+
+// One router <-> shard connection. Sends may come from any thread;
+// receive() belongs to a single reader thread.
+class ShardLink {
+private:
+    int fd;
+    std::atomic<bool> open;
+    std::mutex sendMutex;
+    
+    // Shared-memory transport once RINGS has been exchanged. Published
+    // before any session traffic, so senders never race the switch.
+    std::unique_ptr<ShmRing> sendRing;
+    std::unique_ptr<ShmRing> receiveRing;
+    std::atomic<ShmRing*> activeSendRing;
+    
+    // Descriptors that arrived with the last socket read
+    std::vector<int> receivedFds;
+    
+    // Reader thread: the socket message last returned, and whether the
+    // ring record last returned still has to be freed
+    std::vector<uint8_t> receiveBuffer;
+    bool holdingRecord;
+    
+    bool sendRaw(ShardMessageType type, uint32_t sessionID, std::span<const uint8_t> body);
+    bool sendToRing(ShmRing& ring, const uint8_t* header, size_t headerSize, std::span<const uint8_t> body);
+    bool receiveAll(uint8_t* data, size_t length);
+    bool receiveFromSocket(ShardMessage& message);
+    bool receiveFromRing(ShardMessage& message);
+    bool attachRings();
+    bool peerGone() const;
+    
+public:
+    explicit ShardLink(int fd);
+    ~ShardLink();
+    
+    ShardLink(const ShardLink&) = delete;
+    ShardLink& operator=(const ShardLink&) = delete;
+    
+    // Connects to a shard's socket; nullptr on failure
+    static std::shared_ptr<ShardLink> connect(const std::string& path);
+    
+    // Binds a shard's listening socket (replacing a stale socket file); -1 on failure
+    static int listen(const std::string& path);
+    
+    bool isOpen() const { return open; }
+    bool usesSharedMemory() const { return activeSendRing.load() != nullptr; }
+    
+    // Router side, before anything else is sent: moves the link onto two
+    // rings of `capacity` bytes each. False (link unchanged) if unavailable.
+    bool offerSharedMemory(size_t capacity);
+    
+    bool sendOpen(uint32_t sessionID, std::string_view ipAddress, std::string_view playerName, int32_t playerID);
+    bool sendFrame(uint32_t sessionID, std::span<const uint8_t> payload);
+    bool sendClose(uint32_t sessionID);
+    
+    // Blocks for the next message; false on EOF, error or malformed data.
+    // Frames are not copied out of the ring: the previous message's payload
+    // is released here, so handle it before calling again.
+    bool receive(ShardMessage& message);
+    
+    // Wakes a blocked receive; the descriptor is closed on destruction
+    void shutdown();
+};
@@ -0,0 +1,194 @@
+#include "ShardRouter.h"
+#include "../utils/Logger.h"
+#include "../utils/Trace.h"
+#include <optional>
+
+// Per direction, per shard: room for a few maximum-size frames
+static const size_t SHARD_RING_CAPACITY = 8 * 1024 * 1024;
+
+ShardRouter::ShardRouter(const std::vector<std::string>& shardPaths) : stopping(false) {
+    for (const auto& path : shardPaths) {
+        auto shard = std::make_unique<Shard>();
+        shard->path = path;
+        shards.push_back(std::move(shard));
+    }
+}
+
+ShardRouter::~ShardRouter() {
+    stop();
+}
+
+bool ShardRouter::connect() {
+    if (shards.empty()) {
+        Logger::error("Router mode needs at least one world shard");
+        return false;
+    }
+    
+    for (auto& shard : shards) {
+        shard->link = ShardLink::connect(shard->path);
+        if (!shard->link) {
+            stop();
+            return false;
+        }
+        if (!shard->link->offerSharedMemory(SHARD_RING_CAPACITY)) {
+            Logger::warning("Shared memory unavailable for " + shard->path + ", using the socket");
+        }
+    }
+    
+    for (size_t i = 0; i < shards.size(); ++i) {
+        shards[i]->reader = std::thread(&ShardRouter::readShard, this, i);
+        Logger::info("Connected to world shard " + std::to_string(i) + ": " + shards[i]->path);
+    }
+    return true;
+}
+
+void ShardRouter::stop() {
+    stopping = true;
+    for (auto& shard : shards) {
+        if (shard->link) {
+            shard->link->shutdown();
+        }
+    }
+    for (auto& shard : shards) {
+        if (shard->reader.joinable()) {
+            shard->reader.join();
+        }
+    }
+}
+
+size_t ShardRouter::shardFor(const std::string& worldName) const {
+    // FNV-1a: the same world lands on the same shard across restarts
+    uint32_t hash = 2166136261u;
+    for (char c : worldName) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    // FNV's low bits mix poorly; fold the high bits in before the modulo
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3bu;
+    hash ^= hash >> 16;
+    return hash % shards.size();
+}
+
+bool ShardRouter::join(const std::shared_ptr<Client>& client, const std::string& worldName, const std::vector<uint8_t>& frame) {
+    TRACE_SCOPE_ID("routeJoin", client->getConnectionID());
+    uint32_t sessionID = client->getConnectionID();
+    size_t target = shardFor(worldName);
+    ShardLink& link = *shards[target]->link;
+    if (!link.isOpen()) {
+        Logger::warning("World shard " + std::to_string(target) + " is down, cannot join " + worldName);
+        return false;
+    }
+    
+    std::optional<size_t> previous;
+    {
+        std::lock_guard<std::mutex> lock(routesMutex);
+        auto it = routes.find(sessionID);
+        if (it != routes.end()) {
+            previous = it->second.shard;
+        }
+        routes[sessionID] = Route{client, target};
+    }
+    
+    if (previous != target) {
+        if (previous) {
+            // Migrating: the old shard removes the player from its world
+            Logger::info(Logger::concat({"Moving ", client->getIP(), " from world shard ", std::to_string(*previous),
+                                         " to ", std::to_string(target)}));
+            shards[*previous]->link->sendClose(sessionID);
+        }
+        link.sendOpen(sessionID, client->getIP(), client->getPlayerName(), client->getPlayerID());
+    }
+    return link.sendFrame(sessionID, frame);
+}
+
+bool ShardRouter::forward(const std::shared_ptr<Client>& client, const std::vector<uint8_t>& frame) {
+    size_t shard;
+    {
+        std::lock_guard<std::mutex> lock(routesMutex);
+        auto it = routes.find(client->getConnectionID());
+        if (it == routes.end()) {
+            return false;
+        }
+        shard = it->second.shard;
+    }
+    
+    TRACE_SCOPE_ID("routeFrame", client->getConnectionID());
+    shards[shard]->link->sendFrame(client->getConnectionID(), frame);
+    return true;
+}
+
+void ShardRouter::leave(const std::shared_ptr<Client>& client) {
+    size_t shard;
+    {
+        std::lock_guard<std::mutex> lock(routesMutex);
+        auto it = routes.find(client->getConnectionID());
+        if (it == routes.end()) {
+            return;
+        }
+        shard = it->second.shard;
+        routes.erase(it);
+    }
+    
+    shards[shard]->link->sendClose(client->getConnectionID());
+}
+
+void ShardRouter::readShard(size_t index) {
+    ShardLink& link = *shards[index]->link;
+    ShardMessage message;
+    
+    while (link.receive(message)) {
+        // Output for a session that has since moved on is stale
+        std::shared_ptr<Client> client;
+        bool routed = false;
+        {
+            std::lock_guard<std::mutex> lock(routesMutex);
+            auto it = routes.find(message.sessionID);
+            if (it != routes.end() && it->second.shard == index) {
+                routed = true;
+                client = it->second.client.lock();
+                if (message.type == ShardMessageType::CLOSE) {
+                    routes.erase(it);
+                }
+            }
+        }
+        
+        if (message.type == ShardMessageType::FRAME) {
+            if (client) {
+                client->sendPacket(message.payload);
+            }
+        } else if (message.type == ShardMessageType::CLOSE) {
+            // Every route removal sends CLOSE; an unrouted session already got one
+            if (routed) {
+                link.sendClose(message.sessionID);
+            }
+            if (client) {
+                client->disconnect();
+            }
+        }
+    }
+    
+    // Sessions on a lost shard have no world left to play in
+    std::vector<std::shared_ptr<Client>> stranded;
+    {
+        std::lock_guard<std::mutex> lock(routesMutex);
+        for (auto it = routes.begin(); it != routes.end();) {
+            if (it->second.shard == index) {
+                if (auto client = it->second.client.lock()) {
+                    stranded.push_back(client);
+                }
+                it = routes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    if (!stopping) {
+        Logger::error("Lost connection to world shard " + std::to_string(index) + ", dropping " +
+                      std::to_string(stranded.size()) + " sessions");
+    }
+    for (auto& client : stranded) {
+        client->disconnect();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+#include "Client.h"
+#include "ShardLink.h"
+
+// Front-door side of world sharding. Sessions stay in the lobby locally;
+// once they join a world every frame is forwarded to the shard that owns
+// it, and joining a world owned by another shard migrates the session.
+//
+// join/forward/leave for a session must run on its session executor, so a
+// session's messages reach each shard in order.
+class ShardRouter {
+private:
+    struct Shard {
+        std::string path;
+        std::shared_ptr<ShardLink> link;
+        std::thread reader;
+    };
+    
+    struct Route {
+        std::weak_ptr<Client> client;
+        size_t shard;
+    };
+    
+    std::vector<std::unique_ptr<Shard>> shards;
+    
+    // Keyed by connection ID; never held while sending on a link
+    std::unordered_map<uint32_t, Route> routes;
+    std::mutex routesMutex;
+    std::atomic<bool> stopping;
+    
+    // Delivers shard output to clients (one thread per shard)
+    void readShard(size_t index);
+    
+public:
+    explicit ShardRouter(const std::vector<std::string>& shardPaths);
+    ~ShardRouter();
+    
+    // Connects to every shard; all must be running
+    bool connect();
+    void stop();
+    
+    size_t getShardCount() const { return shards.size(); }
+    
+    // Stable world -> shard assignment
+    size_t shardFor(const std::string& worldName) const;
+    
+    // Sends `frame` (a join_request) to the world's shard, opening the
+    // session there first and closing it on its previous shard if needed.
+    // False if that shard is unreachable; the session stays where it was.
+    bool join(const std::shared_ptr<Client>& client, const std::string& worldName, const std::vector<uint8_t>& frame);
+    
+    // False if the session is not in a world (handle it locally)
+    bool forward(const std::shared_ptr<Client>& client, const std::vector<uint8_t>& frame);
+    
+    // The session ended or returned to the lobby
+    void leave(const std::shared_ptr<Client>& client);
+};
@@ -0,0 +1,330 @@
+#include "ShmRing.h"
+#include "../utils/Logger.h"
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+namespace {
+    const uint32_t RING_MAGIC = 0x474e5252; // "RRNG"
+    const uint32_t RING_VERSION = 1;
+
+    // Record states; the consumer zeroes everything it frees, so a state it
+    // reads is either 0 or was committed by a producer on this lap
+    const uint32_t STATE_EMPTY = 0;
+    const uint32_t STATE_DATA = 1;
+    const uint32_t STATE_PADDING = 2;
+
+    // Every record starts with {state, length} and is padded to 8 bytes
+    const size_t RECORD_HEADER_SIZE = 8;
+    const size_t RECORD_ALIGNMENT = 8;
+
+    const size_t MIN_CAPACITY = 4096;
+
+    size_t recordSize(size_t length) {
+        return (RECORD_HEADER_SIZE + length + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+
+    std::atomic_ref<uint32_t> stateOf(uint8_t* record) {
+        return std::atomic_ref<uint32_t>(*reinterpret_cast<uint32_t*>(record));
+    }
+
+    uint32_t& lengthOf(uint8_t* record) {
+        return *reinterpret_cast<uint32_t*>(record + sizeof(uint32_t));
+    }
+
+    void signal(int fd) {
+        uint64_t one = 1;
+        ssize_t written = ::write(fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+// Shared between the processes at the start of the mapping. The producer
+// and consumer positions are on separate cache lines.
+struct ShmRing::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint32_t producers;
+
+    // Next byte producers will reserve (monotonic; offset = position & mask)
+    alignas(64) std::atomic<uint64_t> head;
+
+    // Next byte the consumer will read; everything before it is zeroed
+    alignas(64) std::atomic<uint64_t> tail;
+
+    alignas(64) std::atomic<uint32_t> consumerWaiting;
+    std::atomic<uint32_t> producersWaiting;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring positions must be lock-free to share across processes");
+
+ShmRing::ShmRing(int memoryFd, int dataFd, int spaceFd)
+    : header(nullptr), records(nullptr), mappedSize(0), mask(0),
+      memoryFd(memoryFd), dataFd(dataFd), spaceFd(spaceFd), peekedSize(0), corrupt(false) {
+}
+
+ShmRing::~ShmRing() {
+    if (header) munmap(header, mappedSize);
+    if (memoryFd >= 0) close(memoryFd);
+    if (dataFd >= 0) close(dataFd);
+    if (spaceFd >= 0) close(spaceFd);
+}
+
+std::unique_ptr<ShmRing> ShmRing::create(size_t capacity, Producers producers) {
+    uint64_t rounded = MIN_CAPACITY;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    int memoryFd = memfd_create("growtopia-ring", MFD_CLOEXEC);
+    int dataFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int spaceFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    std::unique_ptr<ShmRing> ring(new ShmRing(memoryFd, dataFd, spaceFd));
+
+    if (memoryFd < 0 || dataFd < 0 || spaceFd < 0) {
+        Logger::error("Failed to create shared-memory ring. Error: " + std::to_string(errno));
+        return nullptr;
+    }
+    if (ftruncate(memoryFd, static_cast<off_t>(sizeof(Header) + rounded)) != 0) {
+        Logger::error("Failed to size shared-memory ring. Error: " + std::to_string(errno));
+        return nullptr;
+    }
+    if (!ring->map(true, rounded, producers)) {
+        return nullptr;
+    }
+    return ring;
+}
+
+std::unique_ptr<ShmRing> ShmRing::attach(int memoryFd, int dataFd, int spaceFd) {
+    std::unique_ptr<ShmRing> ring(new ShmRing(memoryFd, dataFd, spaceFd));
+    if (memoryFd < 0 || dataFd < 0 || spaceFd < 0) {
+        return nullptr;
+    }
+
+    off_t size = lseek(memoryFd, 0, SEEK_END);
+    if (size <= static_cast<off_t>(sizeof(Header))) {
+        Logger::error("Shared-memory ring has invalid size");
+        return nullptr;
+    }
+
+    uint64_t capacity = static_cast<uint64_t>(size) - sizeof(Header);
+    if (!ring->map(false, capacity, Producers::SINGLE)) {
+        return nullptr;
+    }
+    return ring;
+}
+
+bool ShmRing::map(bool initialize, uint64_t capacity, Producers producers) {
+    if (capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0) {
+        Logger::error("Shared-memory ring capacity must be a power of two");
+        return false;
+    }
+
+    mappedSize = sizeof(Header) + capacity;
+    void* region = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    if (region == MAP_FAILED) {
+        Logger::error("Failed to map shared-memory ring. Error: " + std::to_string(errno));
+        mappedSize = 0;
+        return false;
+    }
+
+    header = static_cast<Header*>(region);
+    records = static_cast<uint8_t*>(region) + sizeof(Header);
+    mask = capacity - 1;
+
+    if (initialize) {
+        // A fresh memfd is zero-filled, which is also the empty record state
+        new (header) Header();
+        header->magic = RING_MAGIC;
+        header->version = RING_VERSION;
+        header->capacity = capacity;
+        header->producers = static_cast<uint32_t>(producers);
+    } else if (header->magic != RING_MAGIC || header->version != RING_VERSION || header->capacity != capacity) {
+        Logger::error("Shared-memory ring header mismatch");
+        return false;
+    }
+    return true;
+}
+
+size_t ShmRing::getMaxRecordSize() const {
+    return static_cast<size_t>(mask + 1) / 2 - RECORD_HEADER_SIZE;
+}
+
+bool ShmRing::tryWrite(const uint8_t* data, size_t length) {
+    iovec part{const_cast<uint8_t*>(data), length};
+    return tryWrite(&part, 1);
+}
+
+bool ShmRing::tryWrite(const iovec* parts, size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; ++i) {
+        length += parts[i].iov_len;
+    }
+    // Half the ring bounds the padding a wrapping record can waste
+    if (length > getMaxRecordSize()) {
+        return false;
+    }
+
+    uint64_t capacity = mask + 1;
+    uint64_t size = recordSize(length);
+    bool multiple = header->producers == static_cast<uint32_t>(Producers::MULTIPLE);
+
+    // Reserve [position, next); a record never wraps, the tail end of the
+    // ring becomes a padding record instead
+    uint64_t position = header->head.load(std::memory_order_relaxed);
+    uint64_t padding;
+    uint64_t next;
+    for (;;) {
+        uint64_t contiguous = capacity - (position & mask);
+        padding = size > contiguous ? contiguous : 0;
+        next = position + padding + size;
+        if (next - header->tail.load(std::memory_order_acquire) > capacity) {
+            return false;
+        }
+        if (!multiple) {
+            header->head.store(next, std::memory_order_relaxed);
+            break;
+        }
+        if (header->head.compare_exchange_weak(position, next, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (padding) {
+        uint8_t* pad = records + (position & mask);
+        lengthOf(pad) = static_cast<uint32_t>(padding);
+        stateOf(pad).store(STATE_PADDING, std::memory_order_release);
+        position += padding;
+    }
+
+    uint8_t* record = records + (position & mask);
+    uint8_t* out = record + RECORD_HEADER_SIZE;
+    for (size_t i = 0; i < count; ++i) {
+        std::memcpy(out, parts[i].iov_base, parts[i].iov_len);
+        out += parts[i].iov_len;
+    }
+    lengthOf(record) = static_cast<uint32_t>(length);
+    stateOf(record).store(STATE_DATA, std::memory_order_release);
+
+    // Pairs with the fence in waitReadable: either the consumer sees the
+    // record before sleeping or we see that it is waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->consumerWaiting.load(std::memory_order_relaxed)) {
+        signal(dataFd);
+    }
+    return true;
+}
+
+const uint8_t* ShmRing::peek(uint32_t& length) {
+    uint64_t capacity = mask + 1;
+    while (!corrupt) {
+        uint64_t position = header->tail.load(std::memory_order_relaxed);
+        uint8_t* record = records + (position & mask);
+        uint64_t contiguous = capacity - (position & mask);
+        uint32_t state = stateOf(record).load(std::memory_order_acquire);
+
+        if (state == STATE_EMPTY) {
+            return nullptr;
+        }
+
+        // The other process wrote these; never trust them to stay inside
+        // the ring
+        uint32_t recordLength = lengthOf(record);
+        if (state == STATE_DATA && recordLength <= getMaxRecordSize() && recordSize(recordLength) <= contiguous) {
+            length = recordLength;
+            peekedSize = recordSize(recordLength);
+            return record + RECORD_HEADER_SIZE;
+        }
+        if (state != STATE_PADDING || recordLength != contiguous) {
+            Logger::error("Shared-memory ring: corrupt record header, abandoning the ring");
+            corrupt = true;
+            break;
+        }
+
+        std::memset(record, 0, contiguous);
+        header->tail.store(position + contiguous, std::memory_order_release);
+    }
+    return nullptr;
+}
+
+void ShmRing::release() {
+    uint64_t position = header->tail.load(std::memory_order_relaxed);
+    uint8_t* record = records + (position & mask);
+
+    // Producers reuse this space only after the new tail is visible
+    std::memset(record, 0, peekedSize);
+    header->tail.store(position + peekedSize, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header->producersWaiting.load(std::memory_order_relaxed)) {
+        signal(spaceFd);
+    }
+}
+
+bool ShmRing::tryRead(std::vector<uint8_t>& record) {
+    return tryRead([&record](const uint8_t* data, uint32_t length) {
+        record.assign(data, data + length);
+    });
+}
+
+bool ShmRing::waitFor(int fd, int timeoutMs, int watchFd) {
+    pollfd waiters[2] = {{fd, POLLIN, 0}, {watchFd, POLLIN | POLLRDHUP, 0}};
+    int ready;
+    do {
+        ready = poll(waiters, watchFd >= 0 ? 2 : 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+
+    if (waiters[0].revents & POLLIN) {
+        uint64_t count;
+        ssize_t drained = ::read(fd, &count, sizeof(count));
+        (void)drained;
+    }
+    return ready > 0 && !(watchFd >= 0 && waiters[1].revents);
+}
+
+bool ShmRing::waitReadable(int timeoutMs, int watchFd) {
+    uint32_t length;
+    if (peek(length)) {
+        return true;
+    }
+    if (corrupt) {
+        return false;
+    }
+
+    header->consumerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ready = peek(length) != nullptr;
+    if (!ready && waitFor(dataFd, timeoutMs, watchFd)) {
+        ready = peek(length) != nullptr;
+    }
+    header->consumerWaiting.store(0, std::memory_order_relaxed);
+    return ready;
+}
+
+bool ShmRing::waitWritable(size_t length, int timeoutMs, int watchFd) {
+    uint64_t capacity = mask + 1;
+    // Worst case includes padding up to the end of the ring
+    uint64_t needed = recordSize(length) * 2;
+    auto hasRoom = [&] {
+        return header->head.load(std::memory_order_relaxed) - header->tail.load(std::memory_order_acquire) + needed <= capacity;
+    };
+
+    if (hasRoom()) {
+        return true;
+    }
+
+    header->producersWaiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ready = hasRoom();
+    if (!ready && waitFor(spaceFd, timeoutMs, watchFd)) {
+        ready = hasRoom();
+    }
+    header->producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+    return ready;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
+
+// Shared-memory ring of length-prefixed records for processes on the same
+// host. The region lives in a memfd, so it can be handed to another process
+// with SCM_RIGHTS together with the two eventfds used for wakeups:
+//
+//   dataFd   signalled by producers when the consumer is waiting for records
+//   spaceFd  signalled by the consumer when producers are waiting for room
+//
+// Records are written in place (reserve, copy, commit) and read through a
+// view of the shared pages, so a frame crosses processes with one memcpy
+// and no syscalls while both sides are busy. There is exactly one consumer;
+// producers may be many when the ring is created with Producers::MULTIPLE.
+// The consumer checks every record header against the ring's bounds, since
+// the process that wrote it may be faulty.
+class ShmRing {
+public:
+    enum class Producers : uint32_t {
+        SINGLE = 0,
+        MULTIPLE = 1
+    };
+
+private:
+    struct Header;
+
+    Header* header;
+    uint8_t* records;
+    size_t mappedSize;
+    uint64_t mask;
+    int memoryFd;
+    int dataFd;
+    int spaceFd;
+
+    // Consumer only: size of the record peek() returned, as validated then,
+    // and whether the peer ever wrote a record header that doesn't fit
+    uint64_t peekedSize;
+    bool corrupt;
+
+    ShmRing(int memoryFd, int dataFd, int spaceFd);
+    bool map(bool initialize, uint64_t capacity, Producers producers);
+
+    bool waitFor(int fd, int timeoutMs, int watchFd);
+
+public:
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // `capacity` is rounded up to a power of two; nullptr on failure
+    static std::unique_ptr<ShmRing> create(size_t capacity, Producers producers);
+
+    // Maps a ring created by another process from its three descriptors
+    // (takes ownership of them); nullptr if they don't describe a ring
+    static std::unique_ptr<ShmRing> attach(int memoryFd, int dataFd, int spaceFd);
+
+    int getMemoryFd() const { return memoryFd; }
+    int getDataFd() const { return dataFd; }
+    int getSpaceFd() const { return spaceFd; }
+
+    size_t getCapacity() const { return static_cast<size_t>(mask + 1); }
+
+    // Largest record the ring can ever hold
+    size_t getMaxRecordSize() const;
+
+    // Producer side: copies `parts` back to back into one record.
+    // False if there is no room right now (or the record can never fit).
+    bool tryWrite(const iovec* parts, size_t count);
+    bool tryWrite(const uint8_t* data, size_t length);
+
+    // Consumer side, in two steps: a view of the next record (null if the
+    // ring is empty or corrupt), valid until release() frees it
+    const uint8_t* peek(uint32_t& length);
+    void release();
+
+    // The peer wrote a record length or padding outside the ring; nothing
+    // more will be read from it
+    bool isCorrupt() const { return corrupt; }
+
+    // Consumer side: calls handler(const uint8_t* data, uint32_t length)
+    // with a view of the next record, then frees it. The view is only
+    // valid during the call. False if the ring is empty.
+    template<typename Handler>
+    bool tryRead(Handler&& handler) {
+        uint32_t length = 0;
+        const uint8_t* data = peek(length);
+        if (!data) {
+            return false;
+        }
+        handler(data, length);
+        release();
+        return true;
+    }
+
+    bool tryRead(std::vector<uint8_t>& record);
+
+    // Block until a record is available / a record of `length` bytes could
+    // fit, for at most timeoutMs (-1 waits forever). They also return when
+    // `watchFd` becomes readable or hangs up, e.g. the control socket to the
+    // peer process; false when the wait ended without the condition.
+    bool waitReadable(int timeoutMs, int watchFd = -1);
+    bool waitWritable(size_t length, int timeoutMs, int watchFd = -1);
+};
@@ -0,0 +1,57 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(float cellSize) : cellSize(cellSize > 1.0f ? cellSize : 1.0f) {
+}
+
+void SpatialGrid::detach(Client* client, int64_t cell) {
+    auto it = cells.find(cell);
+    if (it == cells.end()) return;
+    
+    auto& members = it->second;
+    auto member = std::find(members.begin(), members.end(), client);
+    if (member != members.end()) {
+        *member = members.back();
+        members.pop_back();
+    }
+    if (members.empty()) {
+        cells.erase(it);
+    }
+}
+
+void SpatialGrid::update(Client* client, float x, float y) {
+    int64_t cell = cellKey(cellCoord(x), cellCoord(y));
+    
+    auto it = entries.find(client);
+    if (it == entries.end()) {
+        entries[client] = {x, y, cell};
+        cells[cell].push_back(client);
+        return;
+    }
+    
+    // Most movement stays inside the current cell
+    if (it->second.cell != cell) {
+        detach(client, it->second.cell);
+        cells[cell].push_back(client);
+        it->second.cell = cell;
+    }
+    it->second.x = x;
+    it->second.y = y;
+}
+
+void SpatialGrid::remove(Client* client) {
+    auto it = entries.find(client);
+    if (it == entries.end()) return;
+    
+    detach(client, it->second.cell);
+    entries.erase(it);
+}
+
+bool SpatialGrid::getPosition(Client* client, float& x, float& y) const {
+    auto it = entries.find(client);
+    if (it == entries.end()) return false;
+    
+    x = it->second.x;
+    y = it->second.y;
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+class Client;
+
+// Uniform grid of player positions inside one world, used to limit
+// proximity events to nearby players. With the cell size equal to the
+// query radius a lookup only ever visits the 3x3 cells around the origin.
+// Not thread-safe: owned by the world and touched only on its executor.
+class SpatialGrid {
+private:
+    struct Entry {
+        float x;
+        float y;
+        int64_t cell;
+    };
+    
+    float cellSize;
+    std::unordered_map<int64_t, std::vector<Client*>> cells;
+    std::unordered_map<Client*, Entry> entries;
+    
+    int32_t cellCoord(float value) const { return static_cast<int32_t>(std::floor(value / cellSize)); }
+    static int64_t cellKey(int32_t cx, int32_t cy) {
+        return (static_cast<int64_t>(cx) << 32) | static_cast<uint32_t>(cy);
+    }
+    
+    void detach(Client* client, int64_t cell);
+    
+public:
+    explicit SpatialGrid(float cellSize);
+    
+    // Inserts the client or moves it if already present
+    void update(Client* client, float x, float y);
+    void remove(Client* client);
+    
+    bool getPosition(Client* client, float& x, float& y) const;
+    size_t size() const { return entries.size(); }
+    
+    // Calls fn(Client*) for every client within `radius` of (x, y)
+    template <typename Fn>
+    void forEachWithin(float x, float y, float radius, Fn&& fn) const {
+        int32_t minX = cellCoord(x - radius), maxX = cellCoord(x + radius);
+        int32_t minY = cellCoord(y - radius), maxY = cellCoord(y + radius);
+        float radiusSquared = radius * radius;
+        
+        for (int32_t cx = minX; cx <= maxX; ++cx) {
+            for (int32_t cy = minY; cy <= maxY; ++cy) {
+                auto it = cells.find(cellKey(cx, cy));
+                if (it == cells.end()) continue;
+                
+                for (Client* client : it->second) {
+                    const Entry& entry = entries.at(client);
+                    float dx = entry.x - x;
+                    float dy = entry.y - y;
+                    if (dx * dx + dy * dy <= radiusSquared) {
+                        fn(client);
+                    }
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// Lazily started coroutine returning T. Awaiting a Task starts it and resumes
+// the awaiter when it finishes (symmetric transfer, so chains don't grow the stack).
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        
+        void await_resume() const noexcept {}
+    };
+    
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+    
+    Task<T> get_return_object();
+    void return_value(T result) { value.emplace(std::move(result)); }
+    
+    T takeResult() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    
+    void takeResult() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    
+private:
+    std::coroutine_handle<promise_type> handle;
+    
+public:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+    
+    bool await_ready() const noexcept { return false; }
+    
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    
+    T await_resume() { return handle.promise().takeResult(); }
+};
+
+namespace detail {
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Fire-and-forget frame that owns a Task until it completes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept {}
+    };
+};
+
+inline DetachedTask runDetached(Task<void> task) {
+    try {
+        co_await task;
+    } catch (...) {
+        // Detached work has nobody to report to; callers log inside the task
+    }
+}
+
+} // namespace detail
+
+// Starts a task immediately on the current thread without awaiting it
+inline void spawn(Task<void> task) {
+    detail::runDetached(std::move(task));
+}
@@ -0,0 +1,166 @@
+#include "TrafficCapture.h"
+#include "../utils/Logger.h"
+#include <cstring>
+
+std::mutex TrafficCapture::captureMutex;
+std::ofstream TrafficCapture::captureFile;
+std::atomic<bool> TrafficCapture::enabled(false);
+std::chrono::steady_clock::time_point TrafficCapture::startTime;
+uint64_t TrafficCapture::lastTimestampUs = 0;
+uint64_t TrafficCapture::recordCount = 0;
+
+static const char CAPTURE_MAGIC[5] = {'G', 'T', 'C', 'A', 'P'};
+
+static void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool TrafficCapture::start(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (captureFile.is_open()) {
+        captureFile.close();
+    }
+    
+    captureFile.open(filename, std::ios::binary | std::ios::trunc);
+    if (!captureFile.is_open()) {
+        Logger::error("Failed to open capture file: " + filename);
+        return false;
+    }
+    
+    uint64_t startUnixUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    
+    uint8_t header[16] = {};
+    std::memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header[5] = FORMAT_VERSION;
+    std::memcpy(&header[8], &startUnixUs, sizeof(startUnixUs));
+    captureFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+    
+    startTime = std::chrono::steady_clock::now();
+    lastTimestampUs = 0;
+    recordCount = 0;
+    enabled = true;
+    
+    Logger::info("Traffic capture started: " + filename);
+    return true;
+}
+
+void TrafficCapture::stop() {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (!enabled) return;
+    
+    enabled = false;
+    captureFile.flush();
+    captureFile.close();
+    
+    Logger::info("Traffic capture stopped after " + std::to_string(recordCount) + " records");
+}
+
+void TrafficCapture::writeRecord(CaptureRecordKind kind, uint32_t connectionID, const uint8_t* data, size_t length) {
+    auto now = std::chrono::steady_clock::now();
+    
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (!enabled) return;
+    
+    // Timestamps are taken under the lock so deltas are never negative
+    uint64_t timestampUs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - startTime).count());
+    if (timestampUs < lastTimestampUs) {
+        timestampUs = lastTimestampUs;
+    }
+    
+    std::vector<uint8_t> header;
+    header.reserve(24);
+    header.push_back(static_cast<uint8_t>(kind));
+    appendVarint(header, connectionID);
+    appendVarint(header, timestampUs - lastTimestampUs);
+    if (kind == CaptureRecordKind::FRAME) {
+        appendVarint(header, length);
+    }
+    
+    captureFile.write(reinterpret_cast<const char*>(header.data()), header.size());
+    if (length > 0) {
+        captureFile.write(reinterpret_cast<const char*>(data), length);
+    }
+    
+    lastTimestampUs = timestampUs;
+    ++recordCount;
+}
+
+void TrafficCapture::recordConnect(uint32_t connectionID) {
+    if (!isEnabled()) return;
+    writeRecord(CaptureRecordKind::CONNECT, connectionID, nullptr, 0);
+}
+
+void TrafficCapture::recordFrame(uint32_t connectionID, const std::vector<uint8_t>& frame) {
+    if (!isEnabled()) return;
+    writeRecord(CaptureRecordKind::FRAME, connectionID, frame.data(), frame.size());
+}
+
+void TrafficCapture::recordDisconnect(uint32_t connectionID) {
+    if (!isEnabled()) return;
+    writeRecord(CaptureRecordKind::DISCONNECT, connectionID, nullptr, 0);
+}
+
+CaptureReader::CaptureReader(const std::string& filename)
+    : file(filename, std::ios::binary), startTimeUnixUs(0), currentTimestampUs(0), valid(false) {
+    uint8_t header[16];
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        return;
+    }
+    if (std::memcmp(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0 ||
+        header[5] != TrafficCapture::FORMAT_VERSION) {
+        return;
+    }
+    std::memcpy(&startTimeUnixUs, &header[8], sizeof(startTimeUnixUs));
+    valid = true;
+}
+
+bool CaptureReader::readVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = file.get();
+        if (byte == EOF) return false;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    if (!valid) return false;
+    
+    int kind = file.get();
+    if (kind == EOF || kind > static_cast<int>(CaptureRecordKind::DISCONNECT)) {
+        return false;
+    }
+    
+    uint64_t connectionID = 0;
+    uint64_t deltaUs = 0;
+    if (!readVarint(connectionID) || !readVarint(deltaUs)) {
+        return false;
+    }
+    
+    record.kind = static_cast<CaptureRecordKind>(kind);
+    record.connectionID = static_cast<uint32_t>(connectionID);
+    currentTimestampUs += deltaUs;
+    record.timestampUs = currentTimestampUs;
+    record.payload.clear();
+    
+    if (record.kind == CaptureRecordKind::FRAME) {
+        uint64_t length = 0;
+        if (!readVarint(length) || length > 1024 * 1024) {
+            return false;
+        }
+        record.payload.resize(static_cast<size_t>(length));
+        if (length > 0 && !file.read(reinterpret_cast<char*>(record.payload.data()), length)) {
+            return false;
+        }
+    }
+    
+    return true;
+}
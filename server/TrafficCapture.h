@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Capture file layout (all integers little-endian):
+//   header:  "GTCAP" + uint8 version + 2 bytes reserved, uint64 start time (unix microseconds)
+//   records: uint8 kind, varint connection ID, varint microseconds since previous record,
+//            and for FRAME records a varint payload length followed by the payload.
+enum class CaptureRecordKind : uint8_t {
+    CONNECT = 0,
+    FRAME = 1,
+    DISCONNECT = 2
+};
+
+struct CaptureRecord {
+    CaptureRecordKind kind;
+    uint32_t connectionID;
+    uint64_t timestampUs; // Microseconds since capture start
+    std::vector<uint8_t> payload;
+};
+
+// Records inbound traffic exactly as Client::receivePacket sees it
+class TrafficCapture {
+private:
+    static std::mutex captureMutex;
+    static std::ofstream captureFile;
+    static std::atomic<bool> enabled;
+    static std::chrono::steady_clock::time_point startTime;
+    static uint64_t lastTimestampUs;
+    static uint64_t recordCount;
+    
+    static void writeRecord(CaptureRecordKind kind, uint32_t connectionID, const uint8_t* data, size_t length);
+    
+public:
+    static const uint8_t FORMAT_VERSION = 1;
+    
+    static bool start(const std::string& filename);
+    static void stop();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    
+    static void recordConnect(uint32_t connectionID);
+    static void recordFrame(uint32_t connectionID, const std::vector<uint8_t>& frame);
+    static void recordDisconnect(uint32_t connectionID);
+};
+
+// Sequential reader for capture files, used by the replay tool
+class CaptureReader {
+private:
+    std::ifstream file;
+    uint64_t startTimeUnixUs;
+    uint64_t currentTimestampUs;
+    bool valid;
+    
+    bool readVarint(uint64_t& value);
+    
+public:
+    explicit CaptureReader(const std::string& filename);
+    
+    bool isValid() const { return valid; }
+    uint64_t getStartTimeUnixUs() const { return startTimeUnixUs; }
+    
+    // Returns false at end of file or on a truncated record
+    bool next(CaptureRecord& record);
+};
@@ -0,0 +1,1090 @@
+#include "UdpTransport.h"
+#include "TrafficCapture.h"
+#include "../utils/Logger.h"
+#include "../utils/Trace.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+#else
+    #include <arpa/inet.h>
+    #include <sys/select.h>
+    #include <fcntl.h>
+#endif
+
+namespace {
+    // ENet protocol commands, with their fixed sizes (payload excluded)
+    enum CommandNumber : uint8_t {
+        ACKNOWLEDGE = 1,
+        CONNECT = 2,
+        VERIFY_CONNECT = 3,
+        DISCONNECT = 4,
+        PING = 5,
+        SEND_RELIABLE = 6,
+        SEND_UNRELIABLE = 7,
+        SEND_FRAGMENT = 8,
+        SEND_UNSEQUENCED = 9,
+        BANDWIDTH_LIMIT = 10,
+        THROTTLE_CONFIGURE = 11,
+        SEND_UNRELIABLE_FRAGMENT = 12,
+        COMMAND_COUNT = 13
+    };
+    const size_t COMMAND_SIZES[COMMAND_COUNT] = {0, 8, 48, 44, 8, 4, 6, 8, 24, 8, 12, 16, 24};
+    const size_t COMMAND_HEADER_SIZE = 4;
+
+    const uint8_t COMMAND_MASK = 0x0F;
+    const uint8_t FLAG_ACKNOWLEDGE = 0x80;
+    const uint8_t FLAG_UNSEQUENCED = 0x40;
+
+    const uint16_t HEADER_FLAG_SENT_TIME = 0x8000;
+    const uint16_t HEADER_FLAG_COMPRESSED = 0x4000;
+    const uint16_t HEADER_SESSION_MASK = 0x3000;
+    const int HEADER_SESSION_SHIFT = 12;
+    const uint16_t MAXIMUM_PEER_ID = 0x0FFF;
+
+    // Channel of handshake, ping and disconnect commands
+    const uint8_t CONTROL_CHANNEL = 0xFF;
+
+    // Negotiation limits, as in ENet
+    const uint32_t MINIMUM_MTU = 576;
+    const uint32_t MAXIMUM_MTU = 4096;
+    const uint32_t HOST_MTU = 1400;
+    const uint32_t MINIMUM_WINDOW_SIZE = 4096;
+    const uint32_t MAXIMUM_WINDOW_SIZE = 65536;
+    const uint32_t WINDOW_SIZE_SCALE = 64 * 1024;
+    const uint32_t MAXIMUM_CHANNELS = 32;
+    const size_t MAXIMUM_PACKET_COMMANDS = 32;
+    const uint32_t MAXIMUM_FRAGMENT_COUNT = 1024 * 1024;
+
+    // Handshakes under way at once; a real client needs one round trip
+    const size_t MAXIMUM_CONNECTING_PEERS = 256;
+    const uint32_t MAXIMUM_CONNECTING_PER_ADDRESS = 8;
+
+    // Reliable commands buffered ahead of a gap, and sent but unacknowledged
+    const uint16_t RELIABLE_WINDOW = 4096;
+    const size_t MAXIMUM_IN_FLIGHT = 4096;
+
+    const uint32_t UNSEQUENCED_WINDOW_SIZE = 1024;
+    const uint32_t UNSEQUENCED_WINDOWS = 64;
+
+    // Timing, in milliseconds
+    const uint32_t DEFAULT_ROUND_TRIP_TIME = 500;
+    const uint32_t PING_INTERVAL = 500;
+    const uint32_t TIMEOUT_LIMIT = 32;
+    const uint32_t TIMEOUT_MINIMUM = 5000;
+    const uint32_t TIMEOUT_MAXIMUM = 30000;
+    const uint32_t CLOSE_LINGER = 3000;          // Longest wait for queued data before DISCONNECT
+    const uint32_t HANDSHAKE_TIMEOUT = 30000;    // First frame after connecting, as for TCP
+    const uint32_t VERIFY_TIMEOUT = 5000;        // VERIFY_CONNECT acknowledged after a CONNECT
+    const uint32_t SERVICE_INTERVAL = 10;        // Retransmit and ping checks
+    const long RECEIVE_WAIT_US = 5000;
+
+    // Packet throttle: the share of unreliable sends let through, out of 32
+    const uint32_t THROTTLE_SCALE = 32;
+    const uint32_t THROTTLE_COUNTER = 7;
+    const uint32_t DEFAULT_THROTTLE_INTERVAL = 5000;
+    const uint32_t DEFAULT_THROTTLE_ACCELERATION = 2;
+    const uint32_t DEFAULT_THROTTLE_DECELERATION = 2;
+
+    // Datagrams read per wakeup before acknowledgements go out
+    const int RECEIVE_BATCH = 64;
+    const size_t SOCKET_BUFFER_SIZE = 256 * 1024;
+
+    uint16_t get16(const uint8_t* data) {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    uint32_t get32(const uint8_t* data) {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+               (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    }
+
+    void put16(std::vector<uint8_t>& out, uint16_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void put32(std::vector<uint8_t>& out, uint32_t value) {
+        put16(out, static_cast<uint16_t>(value >> 16));
+        put16(out, static_cast<uint16_t>(value));
+    }
+
+    void write32(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+    }
+
+    // Command header: command number and flags, channel, reliable sequence
+    std::vector<uint8_t> beginCommand(uint8_t command, uint8_t channelID, uint16_t reliableSequence, size_t payload) {
+        std::vector<uint8_t> bytes;
+        bytes.reserve(COMMAND_SIZES[command & COMMAND_MASK] + payload);
+        bytes.push_back(command);
+        bytes.push_back(channelID);
+        put16(bytes, reliableSequence);
+        return bytes;
+    }
+
+    std::string addressString(const sockaddr_in& address) {
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &address.sin_addr, ip, INET_ADDRSTRLEN);
+        return ip;
+    }
+
+    // CRC-32 (IEEE, reflected), as enet_crc32
+    struct Crc32Table {
+        uint32_t entries[256];
+        Crc32Table() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                entries[i] = crc;
+            }
+        }
+    };
+    const Crc32Table crcTable;
+
+    uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            crc = (crc >> 8) ^ crcTable.entries[(crc ^ data[i]) & 0xFF];
+        }
+        return crc;
+    }
+
+    // Checksum of a datagram whose checksum field (at `field`) holds `seed`
+    uint32_t datagramChecksum(const uint8_t* data, size_t length, size_t field, const uint8_t* seed) {
+        uint32_t crc = 0xFFFFFFFFu;
+        crc = crc32Update(crc, data, field);
+        crc = crc32Update(crc, seed, 4);
+        crc = crc32Update(crc, data + field + 4, length - field - 4);
+        return ~crc;
+    }
+}
+
+UdpClient::UdpClient(UdpTransport& transport, const sockaddr_in& address, const std::string& ip, uint16_t incomingPeerID)
+    : Client(INVALID_SOCKET, ip), transport(transport), address(address), state(State::CONNECTING),
+      incomingPeerID(incomingPeerID), outgoingPeerID(MAXIMUM_PEER_ID), incomingSessionID(0xFF), outgoingSessionID(0xFF),
+      connectID{0, 0, 0, 0}, mtu(HOST_MTU), windowSize(MAXIMUM_WINDOW_SIZE), channels(getArena()),
+      outgoingControlReliable(0),
+      reliableInTransit(0), queuedBytes(0),
+      roundTripTime(DEFAULT_ROUND_TRIP_TIME), roundTripTimeVariance(0),
+      lastRoundTripTime(DEFAULT_ROUND_TRIP_TIME), lastRoundTripTimeVariance(0),
+      lowestRoundTripTime(DEFAULT_ROUND_TRIP_TIME), highestRoundTripTimeVariance(0), throttleEpoch(0),
+      packetThrottle(THROTTLE_SCALE), packetThrottleCounter(0), throttleInterval(DEFAULT_THROTTLE_INTERVAL),
+      throttleAcceleration(DEFAULT_THROTTLE_ACCELERATION), throttleDeceleration(DEFAULT_THROTTLE_DECELERATION),
+      incomingUnsequencedGroup(0), connectTime(0), lastReceiveTime(0), closeTime(0), heldBytes(0),
+      announced(false), receivedFrame(false), flushPending(false), handshaking(false) {
+}
+
+size_t UdpClient::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(peerMutex);
+    size_t fragments = 0;
+    for (const Channel& channel : channels) {
+        fragments += channel.fragments.capacity();
+    }
+    return Client::getMemoryUsage() + sizeof(UdpClient) - sizeof(Client) + queuedBytes + heldBytes + fragments;
+}
+
+uint32_t UdpClient::getRoundTripTime() const {
+    std::lock_guard<std::mutex> lock(peerMutex);
+    return roundTripTime;
+}
+
+void UdpClient::acceptConnect(const uint8_t* command, uint32_t now) {
+    outgoingPeerID = get16(command + 4);
+    uint8_t requestedIncomingSession = command[6];
+    uint8_t requestedOutgoingSession = command[7];
+    uint32_t requestedMtu = get32(command + 8);
+    uint32_t requestedWindow = get32(command + 12);
+    uint32_t channelCount = get32(command + 16);
+    uint32_t incomingBandwidth = get32(command + 20);
+    std::memcpy(connectID, command + 40, sizeof(connectID));
+
+    // Session IDs tell a reused slot's traffic from its previous occupant's
+    uint8_t sessionMask = HEADER_SESSION_MASK >> HEADER_SESSION_SHIFT;
+    uint8_t incoming = requestedIncomingSession == 0xFF ? outgoingSessionID : requestedIncomingSession;
+    incoming = (incoming + 1) & sessionMask;
+    if (incoming == outgoingSessionID) incoming = (incoming + 1) & sessionMask;
+    outgoingSessionID = incoming;
+
+    uint8_t outgoing = requestedOutgoingSession == 0xFF ? incomingSessionID : requestedOutgoingSession;
+    outgoing = (outgoing + 1) & sessionMask;
+    if (outgoing == incomingSessionID) outgoing = (outgoing + 1) & sessionMask;
+    incomingSessionID = outgoing;
+
+    mtu = std::min(std::clamp(requestedMtu, MINIMUM_MTU, MAXIMUM_MTU), HOST_MTU);
+    channels.resize(std::min(channelCount, MAXIMUM_CHANNELS));
+
+    // We don't limit our own bandwidth, so only the client's downstream
+    // bandwidth bounds how much we keep in flight
+    windowSize = incomingBandwidth == 0 ? MAXIMUM_WINDOW_SIZE
+                                        : (incomingBandwidth / WINDOW_SIZE_SCALE) * MINIMUM_WINDOW_SIZE;
+    windowSize = std::clamp(windowSize, MINIMUM_WINDOW_SIZE, MAXIMUM_WINDOW_SIZE);
+    uint32_t receiveWindow = std::clamp(std::min(requestedWindow, MAXIMUM_WINDOW_SIZE), MINIMUM_WINDOW_SIZE, MAXIMUM_WINDOW_SIZE);
+
+    throttleInterval = get32(command + 28);
+    throttleAcceleration = get32(command + 32);
+    throttleDeceleration = get32(command + 36);
+    connectTime = lastReceiveTime = now;
+
+    auto verify = beginCommand(VERIFY_CONNECT | FLAG_ACKNOWLEDGE, CONTROL_CHANNEL, ++outgoingControlReliable, 0);
+    put16(verify, incomingPeerID);
+    // Wire order as ENet writes it: the session we send with, then the one
+    // we expect; the client takes the second for its own headers
+    verify.push_back(outgoingSessionID);
+    verify.push_back(incomingSessionID);
+    put32(verify, mtu);
+    put32(verify, receiveWindow);
+    put32(verify, static_cast<uint32_t>(channels.size()));
+    put32(verify, 0); // Incoming bandwidth: unlimited
+    put32(verify, 0); // Outgoing bandwidth: unlimited
+    put32(verify, throttleInterval);
+    put32(verify, throttleAcceleration);
+    put32(verify, throttleDeceleration);
+    verify.insert(verify.end(), connectID, connectID + sizeof(connectID));
+    queueReliable(std::move(verify));
+}
+
+void UdpClient::receiveCommands(const uint8_t* data, size_t length, uint16_t sentTime, uint32_t now, Events& events) {
+    lastReceiveTime = now;
+
+    size_t offset = 0;
+    while (offset + COMMAND_HEADER_SIZE <= length && state != State::CLOSED) {
+        const uint8_t* command = data + offset;
+        uint8_t number = command[0] & COMMAND_MASK;
+        if (number == 0 || number >= COMMAND_COUNT || offset + COMMAND_SIZES[number] > length) {
+            break; // Malformed: ignore the rest of the datagram
+        }
+
+        size_t size = COMMAND_SIZES[number];
+        bool isData = number == SEND_RELIABLE || number == SEND_UNRELIABLE || number == SEND_FRAGMENT ||
+                      number == SEND_UNSEQUENCED || number == SEND_UNRELIABLE_FRAGMENT;
+        if (isData) {
+            // The payload length is the last field before the payload
+            size += get16(command + (number == SEND_RELIABLE ? 4 : 6));
+            if (offset + size > length) break;
+        }
+
+        bool acknowledge = true;
+        switch (number) {
+            case ACKNOWLEDGE:
+                handleAcknowledgement(command, now, events);
+                break;
+            case DISCONNECT:
+                // Acknowledged below, then the session ends
+                state = State::CLOSED;
+                events.closed = true;
+                break;
+            case THROTTLE_CONFIGURE:
+                throttleInterval = get32(command + 4);
+                throttleAcceleration = get32(command + 8);
+                throttleDeceleration = get32(command + 12);
+                break;
+            case PING:
+            case BANDWIDTH_LIMIT:
+            case CONNECT:           // Repeated handshake
+            case VERIFY_CONNECT:
+                break;
+            default:
+                // Data only counts once connected; while closing it is
+                // acknowledged so the client stops resending, then dropped
+                if (state != State::CONNECTED || command[1] >= channels.size()) {
+                    acknowledge = state == State::CLOSING && command[1] < channels.size();
+                    break;
+                }
+                if (number == SEND_RELIABLE || number == SEND_FRAGMENT) {
+                    acknowledge = handleReliable(command, size, events);
+                } else if (number == SEND_UNRELIABLE) {
+                    handleUnreliable(command, size, events);
+                } else if (number == SEND_UNSEQUENCED) {
+                    handleUnsequenced(command, size, events);
+                }
+                // Unreliable fragments are dropped; the client only
+                // fragments unreliable packets larger than the MTU
+                break;
+        }
+
+        if (acknowledge && (command[0] & FLAG_ACKNOWLEDGE)) {
+            acknowledgements.push_back({command[1], get16(command + 2), sentTime});
+        }
+        offset += size;
+    }
+}
+
+void UdpClient::handleAcknowledgement(const uint8_t* command, uint32_t now, Events& events) {
+    uint8_t channelID = command[1];
+    uint16_t sequence = get16(command + 4);
+    uint16_t echoedTime = get16(command + 6);
+
+    auto matches = [channelID, sequence](const Command& sent) {
+        return sent.channelID == channelID && sent.reliableSequence == sequence;
+    };
+
+    // A command queued for resending may still be acknowledged from its last send
+    uint8_t acknowledged;
+    auto sent = std::find_if(inFlight.begin(), inFlight.end(), matches);
+    if (sent != inFlight.end()) {
+        acknowledged = sent->bytes[0] & COMMAND_MASK;
+        reliableInTransit -= sent->bytes.size();
+        queuedBytes -= sent->bytes.size();
+        inFlight.erase(sent);
+    } else {
+        auto resend = std::find_if(queued.begin(), queued.end(),
+                                   [&](const Command& waiting) { return waiting.attempts > 0 && matches(waiting); });
+        if (resend == queued.end()) {
+            return; // Duplicate
+        }
+        acknowledged = resend->bytes[0] & COMMAND_MASK;
+        queuedBytes -= resend->bytes.size();
+        queued.erase(resend);
+    }
+
+    // The client echoes our 16-bit send time; anything "from the future" is stale
+    uint16_t sample = static_cast<uint16_t>(static_cast<uint16_t>(now) - echoedTime);
+    if (sample < 0x8000) {
+        updateRoundTrip(std::max<uint32_t>(sample, 1), now);
+    }
+
+    if (acknowledged == VERIFY_CONNECT && state == State::CONNECTING) {
+        state = State::CONNECTED;
+        connectTime = now;
+        events.connected = true;
+    }
+}
+
+void UdpClient::updateRoundTrip(uint32_t sample, uint32_t now) {
+    // Throttle first, against the previous interval's best round trip
+    if (lastRoundTripTime <= lastRoundTripTimeVariance) {
+        packetThrottle = THROTTLE_SCALE;
+    } else if (sample <= lastRoundTripTime) {
+        packetThrottle = std::min(packetThrottle + throttleAcceleration, THROTTLE_SCALE);
+    } else if (sample > lastRoundTripTime + 2 * lastRoundTripTimeVariance) {
+        slowDown();
+    }
+
+    roundTripTimeVariance -= roundTripTimeVariance / 4;
+    if (sample >= roundTripTime) {
+        uint32_t difference = sample - roundTripTime;
+        roundTripTimeVariance += difference / 4;
+        roundTripTime += difference / 8;
+    } else {
+        uint32_t difference = roundTripTime - sample;
+        roundTripTimeVariance += difference / 4;
+        roundTripTime -= difference / 8;
+    }
+    roundTripTime = std::max<uint32_t>(roundTripTime, 1);
+
+    lowestRoundTripTime = std::min(lowestRoundTripTime, roundTripTime);
+    highestRoundTripTimeVariance = std::max(highestRoundTripTimeVariance, roundTripTimeVariance);
+    if (throttleEpoch == 0 || now - throttleEpoch >= throttleInterval) {
+        lastRoundTripTime = lowestRoundTripTime;
+        lastRoundTripTimeVariance = std::max<uint32_t>(highestRoundTripTimeVariance, 1);
+        lowestRoundTripTime = roundTripTime;
+        highestRoundTripTimeVariance = roundTripTimeVariance;
+        throttleEpoch = now;
+    }
+}
+
+void UdpClient::slowDown() {
+    packetThrottle = packetThrottle > throttleDeceleration ? packetThrottle - throttleDeceleration : 0;
+}
+
+bool UdpClient::handleReliable(const uint8_t* command, size_t size, Events& events) {
+    Channel& channel = channels[command[1]];
+    uint16_t sequence = get16(command + 2);
+    uint16_t distance = static_cast<uint16_t>(sequence - channel.incomingReliable);
+
+    if (distance == 0 || distance >= 0x8000) {
+        return true; // Already delivered; our acknowledgement was lost
+    }
+    if (distance > RELIABLE_WINDOW) {
+        return false; // Too far ahead; it will be resent
+    }
+
+    if (distance > 1) {
+        // Hold it until the gap before it is filled
+        if (channel.held.count(sequence)) {
+            return true;
+        }
+        if (heldBytes + size > Client::getLimits().maxPacketSize) {
+            return false;
+        }
+        channel.held.emplace(sequence, std::vector<uint8_t>(command, command + size));
+        heldBytes += size;
+        return true;
+    }
+
+    channel.incomingReliable = sequence;
+    channel.incomingUnreliable = 0;
+    deliverReliable(channel, command, size, events);
+
+    auto next = channel.held.find(static_cast<uint16_t>(channel.incomingReliable + 1));
+    while (next != channel.held.end()) {
+        std::vector<uint8_t> held = std::move(next->second);
+        channel.held.erase(next);
+        heldBytes -= held.size();
+
+        channel.incomingReliable++;
+        channel.incomingUnreliable = 0;
+        deliverReliable(channel, held.data(), held.size(), events);
+        next = channel.held.find(static_cast<uint16_t>(channel.incomingReliable + 1));
+    }
+    return true;
+}
+
+void UdpClient::deliverReliable(Channel& channel, const uint8_t* command, size_t size, Events& events) {
+    if ((command[0] & COMMAND_MASK) == SEND_RELIABLE) {
+        events.frames.emplace_back(command + COMMAND_SIZES[SEND_RELIABLE], command + size);
+        receivedFrame = true;
+        return;
+    }
+
+    // Fragments carry consecutive reliable sequence numbers, so they arrive
+    // here in order
+    uint16_t sequence = get16(command + 2);
+    uint16_t startSequence = get16(command + 4);
+    uint32_t fragmentCount = get32(command + 8);
+    uint32_t fragmentNumber = get32(command + 12);
+    uint32_t totalLength = get32(command + 16);
+    uint32_t fragmentOffset = get32(command + 20);
+    const uint8_t* payload = command + COMMAND_SIZES[SEND_FRAGMENT];
+    size_t payloadLength = size - COMMAND_SIZES[SEND_FRAGMENT];
+
+    if (sequence == startSequence) {
+        if (fragmentNumber != 0 || fragmentCount == 0 || fragmentCount > MAXIMUM_FRAGMENT_COUNT ||
+            totalLength > Client::getLimits().maxPacketSize) {
+            Logger::warning(Logger::concat({"Dropping oversized or malformed fragmented packet from ", getIP()}));
+            channel.fragmentsLeft = 0;
+            channel.fragments.clear();
+            return;
+        }
+        channel.fragments.assign(totalLength, 0);
+        channel.fragmentStart = startSequence;
+        channel.fragmentsLeft = fragmentCount;
+    } else if (channel.fragmentsLeft == 0 || startSequence != channel.fragmentStart) {
+        return; // Rest of a packet that was dropped
+    }
+
+    if (fragmentNumber != static_cast<uint16_t>(sequence - startSequence) ||
+        fragmentOffset > channel.fragments.size() || payloadLength > channel.fragments.size() - fragmentOffset) {
+        Logger::warning(Logger::concat({"Dropping malformed fragment from ", getIP()}));
+        channel.fragmentsLeft = 0;
+        channel.fragments.clear();
+        return;
+    }
+
+    std::memcpy(channel.fragments.data() + fragmentOffset, payload, payloadLength);
+    if (--channel.fragmentsLeft == 0) {
+        events.frames.push_back(std::move(channel.fragments));
+        channel.fragments.clear();
+        receivedFrame = true;
+    }
+}
+
+void UdpClient::handleUnreliable(const uint8_t* command, size_t size, Events& events) {
+    Channel& channel = channels[command[1]];
+    uint16_t reliableSequence = get16(command + 2);
+    uint16_t sequence = get16(command + 4);
+
+    // Sequenced after the channel's reliable traffic: an older one is
+    // superseded and one waiting on a missing reliable command is dropped
+    // rather than held, so it never stalls what follows
+    if (reliableSequence != channel.incomingReliable ||
+        static_cast<int16_t>(sequence - channel.incomingUnreliable) <= 0) {
+        return;
+    }
+    channel.incomingUnreliable = sequence;
+    events.frames.emplace_back(command + COMMAND_SIZES[SEND_UNRELIABLE], command + size);
+    receivedFrame = true;
+}
+
+void UdpClient::handleUnsequenced(const uint8_t* command, size_t size, Events& events) {
+    uint32_t group = get16(command + 4);
+    uint32_t index = group % UNSEQUENCED_WINDOW_SIZE;
+
+    if (group < incomingUnsequencedGroup) {
+        group += 0x10000;
+    }
+    if (group >= static_cast<uint32_t>(incomingUnsequencedGroup) + UNSEQUENCED_WINDOWS * UNSEQUENCED_WINDOW_SIZE) {
+        return;
+    }
+    group &= 0xFFFF;
+
+    if (group - index != incomingUnsequencedGroup) {
+        incomingUnsequencedGroup = static_cast<uint16_t>(group - index);
+        unsequencedWindow.reset();
+    } else if (unsequencedWindow.test(index)) {
+        return; // Duplicate
+    }
+    unsequencedWindow.set(index);
+
+    events.frames.emplace_back(command + COMMAND_SIZES[SEND_UNSEQUENCED], command + size);
+    receivedFrame = true;
+}
+
+void UdpClient::queueReliable(std::vector<uint8_t> command) {
+    Command queuedCommand;
+    queuedCommand.channelID = command[1];
+    queuedCommand.reliableSequence = get16(command.data() + 2);
+    queuedCommand.bytes = std::move(command);
+    queuedBytes += queuedCommand.bytes.size();
+    queued.push_back(std::move(queuedCommand));
+}
+
+bool UdpClient::queueFrame(std::span<const uint8_t> packet, bool reliable) {
+    if (packet.size() > Client::getLimits().maxPacketSize) {
+        Logger::error(Logger::concat({"Frame too large for ", getIP(), ": ", std::to_string(packet.size())}));
+        return false;
+    }
+    size_t room = mtu - transport.headerSize();
+
+    // Unreliable frames that would need fragmenting go reliably instead;
+    // losing one fragment would lose the whole frame
+    if (!reliable && packet.size() + COMMAND_SIZES[SEND_UNRELIABLE] <= room && channels.size() > 0) {
+        // A channel without reliable traffic, so nothing ever waits in front
+        uint8_t channelID = channels.size() > 1 ? 1 : 0;
+        Channel& channel = channels[channelID];
+
+        auto command = beginCommand(SEND_UNRELIABLE, channelID, channel.outgoingReliable, packet.size());
+        put16(command, ++channel.outgoingUnreliable);
+        put16(command, static_cast<uint16_t>(packet.size()));
+        command.insert(command.end(), packet.begin(), packet.end());
+
+        Command queuedCommand;
+        queuedCommand.channelID = channelID;
+        queuedCommand.bytes = std::move(command);
+        queuedBytes += queuedCommand.bytes.size();
+        unreliable.push_back(std::move(queuedCommand));
+        return true;
+    }
+
+    Channel& channel = channels[0];
+    channel.outgoingUnreliable = 0;
+
+    if (packet.size() + COMMAND_SIZES[SEND_RELIABLE] <= room) {
+        auto command = beginCommand(SEND_RELIABLE | FLAG_ACKNOWLEDGE, 0, ++channel.outgoingReliable, packet.size());
+        put16(command, static_cast<uint16_t>(packet.size()));
+        command.insert(command.end(), packet.begin(), packet.end());
+        queueReliable(std::move(command));
+        return true;
+    }
+
+    size_t fragmentLength = room - COMMAND_SIZES[SEND_FRAGMENT];
+    uint32_t fragmentCount = static_cast<uint32_t>((packet.size() + fragmentLength - 1) / fragmentLength);
+    uint16_t startSequence = static_cast<uint16_t>(channel.outgoingReliable + 1);
+    for (uint32_t fragment = 0; fragment < fragmentCount; ++fragment) {
+        size_t offset = fragment * fragmentLength;
+        size_t length = std::min(fragmentLength, packet.size() - offset);
+
+        auto command = beginCommand(SEND_FRAGMENT | FLAG_ACKNOWLEDGE, 0, ++channel.outgoingReliable, length);
+        put16(command, startSequence);
+        put16(command, static_cast<uint16_t>(length));
+        put32(command, fragmentCount);
+        put32(command, fragment);
+        put32(command, static_cast<uint32_t>(packet.size()));
+        put32(command, static_cast<uint32_t>(offset));
+        command.insert(command.end(), packet.begin() + offset, packet.begin() + offset + length);
+        queueReliable(std::move(command));
+    }
+    return true;
+}
+
+void UdpClient::flushLocked(uint32_t now) {
+    size_t headerSize = transport.headerSize();
+    bool sendData = state != State::CLOSED;
+    size_t window = std::max<size_t>(static_cast<size_t>(windowSize) * packetThrottle / THROTTLE_SCALE, mtu);
+
+    // Acknowledgements ride along with whatever else is going out, and
+    // everything pending shares as few datagrams as the MTU allows
+    while (true) {
+        std::vector<uint8_t> datagram(headerSize);
+        size_t commands = 0;
+        auto fits = [&](size_t size) {
+            return commands < MAXIMUM_PACKET_COMMANDS && datagram.size() + size <= mtu;
+        };
+
+        size_t acknowledged = 0;
+        while (acknowledged < acknowledgements.size() && fits(COMMAND_SIZES[ACKNOWLEDGE])) {
+            const Acknowledgement& ack = acknowledgements[acknowledged++];
+            datagram.push_back(ACKNOWLEDGE);
+            datagram.push_back(ack.channelID);
+            put16(datagram, ack.reliableSequence);
+            put16(datagram, ack.reliableSequence);
+            put16(datagram, ack.sentTime);
+            ++commands;
+        }
+        acknowledgements.erase(acknowledgements.begin(), acknowledgements.begin() + acknowledged);
+
+        while (sendData && !queued.empty() && inFlight.size() < MAXIMUM_IN_FLIGHT) {
+            Command& command = queued.front();
+            if (!fits(command.bytes.size()) || reliableInTransit + command.bytes.size() > window) {
+                break;
+            }
+            if (command.attempts == 0) {
+                command.firstSentTime = now;
+                command.timeout = roundTripTime + 4 * roundTripTimeVariance;
+                command.timeoutLimit = TIMEOUT_LIMIT * command.timeout;
+            }
+            command.attempts++;
+            command.sentTime = now;
+
+            datagram.insert(datagram.end(), command.bytes.begin(), command.bytes.end());
+            reliableInTransit += command.bytes.size();
+            ++commands;
+            inFlight.push_back(std::move(command));
+            queued.pop_front();
+        }
+
+        while (sendData && !unreliable.empty()) {
+            Command& command = unreliable.front();
+            if (!fits(command.bytes.size())) {
+                break;
+            }
+            // The throttle lets this many out of every 32 through
+            packetThrottleCounter = (packetThrottleCounter + THROTTLE_COUNTER) % THROTTLE_SCALE;
+            if (packetThrottleCounter <= packetThrottle) {
+                datagram.insert(datagram.end(), command.bytes.begin(), command.bytes.end());
+                ++commands;
+            }
+            queuedBytes -= command.bytes.size();
+            unreliable.pop_front();
+        }
+
+        if (commands == 0) {
+            break;
+        }
+        transport.sendDatagram(*this, datagram, now);
+    }
+}
+
+void UdpClient::sendDisconnect(uint32_t now) {
+    // Not acknowledged: if it is lost, the client times out instead
+    std::vector<uint8_t> datagram(transport.headerSize());
+    auto command = beginCommand(DISCONNECT | FLAG_UNSEQUENCED, CONTROL_CHANNEL, 0, 0);
+    put32(command, 0);
+    datagram.insert(datagram.end(), command.begin(), command.end());
+    transport.sendDatagram(*this, datagram, now);
+}
+
+void UdpClient::serviceTimers(uint32_t now, Events& events) {
+    if (state == State::CLOSED) {
+        return;
+    }
+
+    if (state == State::CLOSING && ((queued.empty() && inFlight.empty()) || now - closeTime >= CLOSE_LINGER)) {
+        flushLocked(now);
+        sendDisconnect(now);
+        state = State::CLOSED;
+        events.closed = true;
+        return;
+    }
+
+    // Usually a spoofed CONNECT; nothing to say goodbye to
+    if (state == State::CONNECTING && now - connectTime >= VERIFY_TIMEOUT) {
+        state = State::CLOSED;
+        events.closed = true;
+        return;
+    }
+
+    if (state == State::CONNECTED && !receivedFrame && now - connectTime >= HANDSHAKE_TIMEOUT) {
+        Logger::info(Logger::concat({"Handshake timeout for ", getIP()}));
+        state = State::CLOSING;
+        closeTime = now;
+        Client::disconnect();
+    }
+
+    // Resend what the client hasn't acknowledged in time, oldest first;
+    // a peer that stays silent long enough has gone away
+    std::deque<Command> resend;
+    for (auto sent = inFlight.begin(); sent != inFlight.end();) {
+        if (now - sent->sentTime < sent->timeout) {
+            ++sent;
+            continue;
+        }
+        uint32_t waited = now - sent->firstSentTime;
+        if (waited >= TIMEOUT_MAXIMUM || (sent->timeout >= sent->timeoutLimit && waited >= TIMEOUT_MINIMUM)) {
+            Logger::info(Logger::concat({"UDP client ", getIP(), " timed out"}));
+            state = State::CLOSED;
+            events.closed = true;
+            return;
+        }
+        reliableInTransit -= sent->bytes.size();
+        sent->timeout *= 2;
+        resend.push_back(std::move(*sent));
+        sent = inFlight.erase(sent);
+    }
+    if (!resend.empty()) {
+        // Loss is the clearest congestion signal there is
+        slowDown();
+        queued.insert(queued.begin(), std::make_move_iterator(resend.begin()), std::make_move_iterator(resend.end()));
+    }
+
+    // Keep the round trip fresh and notice a silent client
+    if (state == State::CONNECTED && inFlight.empty() && queued.empty() && now - lastReceiveTime >= PING_INTERVAL) {
+        queueReliable(beginCommand(PING | FLAG_ACKNOWLEDGE, CONTROL_CHANNEL, ++outgoingControlReliable, 0));
+    }
+
+    flushLocked(now);
+}
+
+bool UdpClient::sendPacket(std::span<const uint8_t> packet) {
+    if (!isConnected() || packet.empty()) {
+        return false;
+    }
+
+    TRACE_SCOPE_ID("sendPacket", getConnectionID());
+    std::lock_guard<std::mutex> lock(peerMutex);
+    if (state != State::CONNECTED) {
+        return false;
+    }
+    if (queuedBytes + packet.size() > Client::getLimits().maxOutboundBytes) {
+        Logger::warning(Logger::concat({"Send queue overflow for ", getIP(), ", disconnecting"}));
+        state = State::CLOSING;
+        closeTime = transport.now();
+        Client::disconnect();
+        return false;
+    }
+    if (!queueFrame(packet, true)) {
+        return false;
+    }
+    flushLocked(transport.now());
+    return true;
+}
+
+bool UdpClient::sendUnreliable(std::span<const uint8_t> packet) {
+    if (!isConnected() || packet.empty()) {
+        return false;
+    }
+
+    TRACE_SCOPE_ID("sendPacket", getConnectionID());
+    std::lock_guard<std::mutex> lock(peerMutex);
+    if (state != State::CONNECTED || !queueFrame(packet, false)) {
+        return false;
+    }
+    flushLocked(transport.now());
+    return true;
+}
+
+void UdpClient::disconnect() {
+    {
+        std::lock_guard<std::mutex> lock(peerMutex);
+        if (state == State::CONNECTING || state == State::CONNECTED) {
+            state = State::CLOSING;
+            closeTime = transport.now();
+        }
+    }
+    Client::disconnect();
+}
+
+UdpTransport::UdpTransport(bool useChecksum, Handlers handlers)
+    : udpSocket(INVALID_SOCKET), running(false), useChecksum(useChecksum), handlers(std::move(handlers)),
+      startTime(std::chrono::steady_clock::now()), peers(MAXIMUM_PEER_ID), connectingPeers(0) {
+}
+
+UdpTransport::~UdpTransport() {
+    if (udpSocket != INVALID_SOCKET) {
+        CLOSE_SOCKET(udpSocket);
+    }
+}
+
+uint32_t UdpTransport::now() const {
+    // Never 0, which marks "not yet" in peer timers
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + 1;
+}
+
+bool UdpTransport::open(int port) {
+    udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udpSocket == INVALID_SOCKET) {
+        Logger::error("Failed to create UDP socket. Error: " + std::to_string(SOCKET_ERROR_CODE));
+        return false;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+    if (bind(udpSocket, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR) {
+        Logger::error("Failed to bind UDP socket. Error: " + std::to_string(SOCKET_ERROR_CODE));
+        CLOSE_SOCKET(udpSocket);
+        udpSocket = INVALID_SOCKET;
+        return false;
+    }
+
+    // Reads drain the socket after select() reports it ready
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(udpSocket, FIONBIO, &nonBlocking);
+#else
+    fcntl(udpSocket, F_SETFL, fcntl(udpSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    // Room for a burst from every peer between two service passes
+    int bufferSize = static_cast<int>(SOCKET_BUFFER_SIZE);
+    setsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+    setsockopt(udpSocket, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferSize, sizeof(bufferSize));
+
+    running = true;
+    return true;
+}
+
+int UdpTransport::getPort() const {
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    if (udpSocket == INVALID_SOCKET || getsockname(udpSocket, (sockaddr*)&address, &length) == SOCKET_ERROR) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+void UdpTransport::run() {
+    std::vector<uint8_t> buffer(MAXIMUM_MTU);
+    uint32_t lastService = now();
+
+    while (running) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(udpSocket, &readable);
+        timeval wait{0, RECEIVE_WAIT_US};
+        int ready = select(static_cast<int>(udpSocket) + 1, &readable, nullptr, nullptr, &wait);
+
+        if (ready > 0) {
+            for (int i = 0; i < RECEIVE_BATCH; ++i) {
+                sockaddr_in from{};
+                socklen_t fromLength = sizeof(from);
+                int received = recvfrom(udpSocket, (char*)buffer.data(), static_cast<int>(buffer.size()), 0,
+                                        (sockaddr*)&from, &fromLength);
+                if (received <= 0) {
+                    break;
+                }
+                handleDatagram(buffer.data(), static_cast<size_t>(received), from);
+            }
+
+            // One reply per peer acknowledges everything the batch brought
+            uint32_t time = now();
+            for (auto& peer : touched) {
+                std::lock_guard<std::mutex> lock(peer->peerMutex);
+                peer->flushPending = false;
+                peer->flushLocked(time);
+            }
+            touched.clear();
+        }
+
+        uint32_t time = now();
+        if (time - lastService >= SERVICE_INTERVAL) {
+            lastService = time;
+            for (size_t id = 0; id < peers.size(); ++id) {
+                std::shared_ptr<UdpClient> peer = peers[id];
+                if (!peer) continue;
+
+                UdpClient::Events events;
+                {
+                    std::lock_guard<std::mutex> lock(peer->peerMutex);
+                    peer->serviceTimers(time, events);
+                }
+                finishEvents(peer, events);
+            }
+        }
+    }
+
+    // Tell every client we're going, then free the port
+    uint32_t time = now();
+    for (size_t id = 0; id < peers.size(); ++id) {
+        std::shared_ptr<UdpClient> peer = peers[id];
+        if (!peer) continue;
+        {
+            std::lock_guard<std::mutex> lock(peer->peerMutex);
+            if (peer->state != UdpClient::State::CLOSED) {
+                peer->flushLocked(time);
+                peer->sendDisconnect(time);
+                peer->state = UdpClient::State::CLOSED;
+            }
+        }
+        retire(peer);
+    }
+    CLOSE_SOCKET(udpSocket);
+    udpSocket = INVALID_SOCKET;
+}
+
+void UdpTransport::handleDatagram(const uint8_t* data, size_t length, const sockaddr_in& from) {
+    if (length < 2) {
+        return;
+    }
+
+    uint16_t field = get16(data);
+    uint16_t peerID = field & MAXIMUM_PEER_ID;
+    uint8_t sessionID = static_cast<uint8_t>((field & HEADER_SESSION_MASK) >> HEADER_SESSION_SHIFT);
+    if (field & HEADER_FLAG_COMPRESSED) {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug("Dropping compressed datagram from " + addressString(from));
+        }
+        return;
+    }
+
+    size_t headerSize = (field & HEADER_FLAG_SENT_TIME) ? 4 : 2;
+    uint16_t sentTime = headerSize == 4 && length >= 4 ? get16(data + 2) : 0;
+    if (useChecksum) {
+        headerSize += 4;
+    }
+    if (length < headerSize) {
+        return;
+    }
+
+    // Anything but a new connection must come from the peer's address,
+    // carrying the session it was given
+    std::shared_ptr<UdpClient> peer;
+    if (peerID != MAXIMUM_PEER_ID) {
+        if (peerID >= peers.size() || !(peer = peers[peerID])) {
+            return;
+        }
+        if (peer->address.sin_addr.s_addr != from.sin_addr.s_addr || peer->address.sin_port != from.sin_port ||
+            sessionID != peer->incomingSessionID) {
+            return;
+        }
+    }
+
+    if (useChecksum) {
+        static const uint8_t noPeer[4] = {0, 0, 0, 0};
+        size_t field = headerSize - 4;
+        if (datagramChecksum(data, length, field, peer ? peer->connectID : noPeer) != get32(data + field)) {
+            return;
+        }
+    }
+
+    const uint8_t* commands = data + headerSize;
+    size_t commandsLength = length - headerSize;
+    if (!peer) {
+        if (commandsLength >= COMMAND_SIZES[CONNECT] && (commands[0] & COMMAND_MASK) == CONNECT) {
+            handleConnect(commands, sentTime, from);
+        }
+        return;
+    }
+
+    UdpClient::Events events;
+    {
+        std::lock_guard<std::mutex> lock(peer->peerMutex);
+        peer->receiveCommands(commands, commandsLength, sentTime, now(), events);
+        if (!peer->flushPending) {
+            peer->flushPending = true;
+            touched.push_back(peer);
+        }
+    }
+    finishEvents(peer, events);
+}
+
+void UdpTransport::handleConnect(const uint8_t* command, uint16_t sentTime, const sockaddr_in& from) {
+    uint32_t channelCount = get32(command + 16);
+    if (channelCount < 1 || channelCount > 255) {
+        return;
+    }
+
+    // A resent CONNECT for a handshake already under way
+    size_t freeSlot = peers.size();
+    for (size_t id = 0; id < peers.size(); ++id) {
+        const auto& existing = peers[id];
+        if (!existing) {
+            freeSlot = std::min(freeSlot, id);
+        } else if (existing->address.sin_addr.s_addr == from.sin_addr.s_addr &&
+                   existing->address.sin_port == from.sin_port &&
+                   std::memcmp(existing->connectID, command + 40, sizeof(existing->connectID)) == 0) {
+            return;
+        }
+    }
+    if (freeSlot == peers.size()) {
+        Logger::warning("UDP peer table full, ignoring connection from " + addressString(from));
+        return;
+    }
+
+    // Debug only: a flood would otherwise fill the log
+    auto counted = connectingPerAddress.find(from.sin_addr.s_addr);
+    if (counted != connectingPerAddress.end() && counted->second >= MAXIMUM_CONNECTING_PER_ADDRESS) {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug("Too many UDP handshakes from " + addressString(from) + ", ignoring connection");
+        }
+        return;
+    }
+    if (connectingPeers >= MAXIMUM_CONNECTING_PEERS) {
+        if (Logger::isEnabled(LogLevel::DEBUG)) {
+            Logger::debug("Too many UDP handshakes under way, ignoring connection from " + addressString(from));
+        }
+        return;
+    }
+
+    auto peer = std::make_shared<UdpClient>(*this, from, addressString(from), static_cast<uint16_t>(freeSlot));
+    {
+        std::lock_guard<std::mutex> lock(peer->peerMutex);
+        peer->acceptConnect(command, now());
+        peer->acknowledgements.push_back({CONTROL_CHANNEL, get16(command + 2), sentTime});
+        peer->flushLocked(now());
+    }
+    peers[freeSlot] = peer;
+
+    peer->handshaking = true;
+    ++connectingPeers;
+    ++connectingPerAddress[from.sin_addr.s_addr];
+}
+
+void UdpTransport::endHandshake(UdpClient& peer) {
+    if (!peer.handshaking) {
+        return;
+    }
+    peer.handshaking = false;
+    --connectingPeers;
+    auto counted = connectingPerAddress.find(peer.address.sin_addr.s_addr);
+    if (--counted->second == 0) {
+        connectingPerAddress.erase(counted);
+    }
+}
+
+void UdpTransport::finishEvents(const std::shared_ptr<UdpClient>& peer, UdpClient::Events& events) {
+    if (events.connected) {
+        endHandshake(*peer);
+        if (handlers.connected(peer)) {
+            peer->announced = true;
+        } else {
+            peer->disconnect();
+        }
+    }
+
+    for (auto& frame : events.frames) {
+        if (!peer->isConnected()) break;
+        TrafficCapture::recordFrame(peer->getConnectionID(), frame);
+        handlers.received(peer, frame);
+    }
+
+    if (events.closed) {
+        retire(peer);
+    }
+}
+
+void UdpTransport::retire(const std::shared_ptr<UdpClient>& peer) {
+    if (peers[peer->incomingPeerID] == peer) {
+        peers[peer->incomingPeerID].reset();
+    }
+    endHandshake(*peer);
+    peer->Client::disconnect();
+    if (peer->announced) {
+        peer->announced = false;
+        handlers.disconnected(peer);
+    }
+}
+
+void UdpTransport::sendDatagram(UdpClient& peer, std::vector<uint8_t>& datagram, uint32_t sentTime) {
+    uint16_t field = peer.outgoingPeerID | static_cast<uint16_t>(peer.outgoingSessionID << HEADER_SESSION_SHIFT) |
+                     HEADER_FLAG_SENT_TIME;
+    datagram[0] = static_cast<uint8_t>(field >> 8);
+    datagram[1] = static_cast<uint8_t>(field);
+    datagram[2] = static_cast<uint8_t>(sentTime >> 8);
+    datagram[3] = static_cast<uint8_t>(sentTime);
+
+    if (useChecksum) {
+        write32(datagram.data() + 4, datagramChecksum(datagram.data(), datagram.size(), 4, peer.connectID));
+    }
+
+    sendto(udpSocket, (const char*)datagram.data(), static_cast<int>(datagram.size()), 0,
+           (const sockaddr*)&peer.address, sizeof(peer.address));
+}
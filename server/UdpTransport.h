@@ -0,0 +1,251 @@
+#pragma once
+
+#include "Client.h"
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <bitset>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+#ifdef _WIN32
+    #include <ws2tcpip.h>
+#else
+    #include <netinet/in.h>
+#endif
+
+// Reliable UDP as the real game client speaks it: the ENet 1.3 wire
+// protocol. Every datagram carries a peer ID, a send timestamp and
+// (optionally) a CRC32, followed by up to 32 commands:
+//
+//   CONNECT / VERIFY_CONNECT      three-way handshake, negotiates MTU,
+//                                 window and channel count
+//   SEND_RELIABLE / SEND_FRAGMENT in order per channel, retransmitted until
+//                                 acknowledged; large frames are fragmented
+//   SEND_UNRELIABLE               sequenced per channel, stale ones dropped
+//   SEND_UNSEQUENCED              delivered as they come, duplicates dropped
+//   ACKNOWLEDGE                   batched per datagram, echo the send time
+//                                 for round-trip measurement
+//   PING / DISCONNECT / BANDWIDTH_LIMIT / THROTTLE_CONFIGURE
+//
+// Each ENet packet holds one frame, the same bytes a TCP client sends after
+// its length prefix, so both transports feed the same dispatch. Range-coder
+// compression is not supported: compressed datagrams are dropped and the
+// server never compresses its own.
+//
+// Congestion control follows ENet: a packet throttle (0-32) rises while
+// round trips stay at their recent low and falls when they jump or a
+// reliable command has to be resent. It limits the reliable bytes in flight
+// to throttle/32 of the negotiated window and drops that share of
+// unreliable sends.
+
+class UdpTransport;
+
+// One ENet peer. Protocol state is guarded by its own mutex: the transport
+// thread feeds it datagrams and timers, game logic sends to it from any
+// thread.
+class UdpClient : public Client {
+    friend class UdpTransport;
+
+public:
+    // Per-datagram outcome the transport acts on once the lock is released
+    struct Events {
+        bool connected = false;     // Handshake completed
+        bool closed = false;        // Peer disconnected or timed out
+        std::vector<std::vector<uint8_t>> frames;
+    };
+
+private:
+    enum class State {
+        CONNECTING,   // VERIFY_CONNECT sent, waiting for its acknowledgement
+        CONNECTED,
+        CLOSING,      // Ended by us: flushing reliable data before DISCONNECT
+        CLOSED
+    };
+
+    // Encoded command; reliable ones stay around until acknowledged
+    struct Command {
+        std::vector<uint8_t> bytes;
+        uint8_t channelID = 0;
+        uint16_t reliableSequence = 0;
+        uint32_t sentTime = 0;          // Transport clock (ms) of the last send
+        uint32_t firstSentTime = 0;
+        uint32_t timeout = 0;           // Current retransmission timeout
+        uint32_t timeoutLimit = 0;
+        uint32_t attempts = 0;
+    };
+
+    struct Acknowledgement {
+        uint8_t channelID;
+        uint16_t reliableSequence;
+        uint16_t sentTime;
+    };
+
+    struct Channel {
+        uint16_t outgoingReliable = 0;
+        uint16_t outgoingUnreliable = 0;
+        uint16_t incomingReliable = 0;    // Last delivered
+        uint16_t incomingUnreliable = 0;  // Last delivered since that reliable
+
+        // Reliable commands that arrived ahead of a missing one
+        std::map<uint16_t, std::vector<uint8_t>> held;
+
+        // Fragmented packet being reassembled
+        std::vector<uint8_t> fragments;
+        uint16_t fragmentStart = 0;
+        uint32_t fragmentsLeft = 0;
+    };
+
+    UdpTransport& transport;
+    sockaddr_in address;
+    mutable std::mutex peerMutex;
+    State state;
+
+    // Handshake parameters
+    uint16_t incomingPeerID;    // Our slot; the client puts it in its headers
+    uint16_t outgoingPeerID;    // The client's slot; we put it in ours
+    uint8_t incomingSessionID;
+    uint8_t outgoingSessionID;
+    uint8_t connectID[4];       // Kept in wire order; seeds the checksum
+    uint32_t mtu;
+    uint32_t windowSize;
+    std::pmr::vector<Channel> channels;   // From the session arena
+    uint16_t outgoingControlReliable;   // Channel 0xFF: handshake, ping, disconnect
+
+    // Outgoing commands
+    std::deque<Command> queued;         // Reliable, waiting for window space
+    std::deque<Command> inFlight;       // Reliable, sent and unacknowledged
+    std::deque<Command> unreliable;
+    std::vector<Acknowledgement> acknowledgements;
+    size_t reliableInTransit;
+    size_t queuedBytes;
+
+    // Round trip and throttle, all in milliseconds
+    uint32_t roundTripTime;
+    uint32_t roundTripTimeVariance;
+    uint32_t lastRoundTripTime;
+    uint32_t lastRoundTripTimeVariance;
+    uint32_t lowestRoundTripTime;
+    uint32_t highestRoundTripTimeVariance;
+    uint32_t throttleEpoch;
+    uint32_t packetThrottle;
+    uint32_t packetThrottleCounter;
+    uint32_t throttleInterval;
+    uint32_t throttleAcceleration;
+    uint32_t throttleDeceleration;
+
+    // Unsequenced duplicate filter
+    uint16_t incomingUnsequencedGroup;
+    std::bitset<1024> unsequencedWindow;
+
+    uint32_t connectTime;
+    uint32_t lastReceiveTime;
+    uint32_t closeTime;
+    size_t heldBytes;
+    bool announced;             // The server was told about this session
+    bool receivedFrame;         // Anything arrived since the handshake
+    bool flushPending;          // Touched by the current receive batch
+    bool handshaking;           // Counted against the CONNECTING limits (transport thread only)
+
+    // Everything below expects peerMutex to be held
+    void acceptConnect(const uint8_t* command, uint32_t now);
+    void receiveCommands(const uint8_t* data, size_t length, uint16_t sentTime, uint32_t now, Events& events);
+    void handleAcknowledgement(const uint8_t* command, uint32_t now, Events& events);
+    bool handleReliable(const uint8_t* command, size_t size, Events& events);
+    void handleUnreliable(const uint8_t* command, size_t size, Events& events);
+    void handleUnsequenced(const uint8_t* command, size_t size, Events& events);
+    void deliverReliable(Channel& channel, const uint8_t* command, size_t size, Events& events);
+    void updateRoundTrip(uint32_t sample, uint32_t now);
+    void slowDown();
+
+    void queueReliable(std::vector<uint8_t> command);
+    bool queueFrame(std::span<const uint8_t> packet, bool reliable);
+    void sendDisconnect(uint32_t now);
+    void flushLocked(uint32_t now);
+
+    // Transport thread: retransmits, pings, timeouts and closing
+    void serviceTimers(uint32_t now, Events& events);
+
+public:
+    UdpClient(UdpTransport& transport, const sockaddr_in& address, const std::string& ip, uint16_t incomingPeerID);
+
+    bool sendPacket(std::span<const uint8_t> packet) override;
+    bool sendUnreliable(std::span<const uint8_t> packet) override;
+
+    // Sends whatever is still queued, then DISCONNECT
+    void disconnect() override;
+
+    // Adds reliable data awaiting acknowledgement and partial reassemblies
+    size_t getMemoryUsage() const override;
+
+    uint32_t getRoundTripTime() const;
+};
+
+// The UDP socket and its peer table. One thread runs run(); peers are
+// created, fed and retired there, while sends may come from anywhere.
+class UdpTransport {
+public:
+    struct Handlers {
+        // Handshake done; return false to have the peer closed
+        std::function<bool(const std::shared_ptr<UdpClient>&)> connected;
+        std::function<void(const std::shared_ptr<UdpClient>&, const std::vector<uint8_t>&)> received;
+        // Only for peers `connected` was called for
+        std::function<void(const std::shared_ptr<UdpClient>&)> disconnected;
+    };
+
+private:
+    friend class UdpClient;
+
+    socket_t udpSocket;
+    std::atomic<bool> running;
+    bool useChecksum;
+    Handlers handlers;
+    std::chrono::steady_clock::time_point startTime;
+
+    // Indexed by the peer ID clients put in their headers (transport thread only)
+    std::vector<std::shared_ptr<UdpClient>> peers;
+    std::vector<std::shared_ptr<UdpClient>> touched;
+
+    // Peers still in the handshake, in total and per source address. A
+    // CONNECT costs a peer slot and VERIFY_CONNECT retransmits before the
+    // server gets any say, so these cap what unanswered (possibly spoofed)
+    // CONNECTs can hold
+    size_t connectingPeers;
+    std::unordered_map<uint32_t, uint32_t> connectingPerAddress;
+
+    uint32_t now() const;
+    void handleDatagram(const uint8_t* data, size_t length, const sockaddr_in& from);
+    void handleConnect(const uint8_t* command, uint16_t sentTime, const sockaddr_in& from);
+    void finishEvents(const std::shared_ptr<UdpClient>& peer, UdpClient::Events& events);
+    void retire(const std::shared_ptr<UdpClient>& peer);
+    void endHandshake(UdpClient& peer);
+
+    // Peer side: fills in the header and checksum, then sends
+    void sendDatagram(UdpClient& peer, std::vector<uint8_t>& datagram, uint32_t sentTime);
+
+public:
+    UdpTransport(bool useChecksum, Handlers handlers);
+    ~UdpTransport();
+
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport& operator=(const UdpTransport&) = delete;
+
+    // Binds the UDP port; false on failure
+    bool open(int port);
+
+    // The bound port, e.g. the one the system picked for open(0)
+    int getPort() const;
+
+    // Services the socket until stop(). Peers still open then get a
+    // DISCONNECT and the socket is closed, freeing the port.
+    void run();
+    void stop() { running = false; }
+
+    // Size of the checksum and timestamped header every datagram starts with
+    size_t headerSize() const { return useChecksum ? 8 : 4; }
+};
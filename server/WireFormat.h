@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Host-order, length-prefixed encoding for messages between our own
+// processes on the same machine (hot restart, world shards)
+
+class WireWriter {
+public:
+    std::vector<uint8_t> bytes;
+    
+    void u32(uint32_t value) {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(value));
+    }
+    void i32(int32_t value) { u32(static_cast<uint32_t>(value)); }
+    void blob(const uint8_t* data, size_t length) {
+        u32(static_cast<uint32_t>(length));
+        bytes.insert(bytes.end(), data, data + length);
+    }
+    void str(std::string_view value) { blob(reinterpret_cast<const uint8_t*>(value.data()), value.size()); }
+    void vec(const std::vector<uint8_t>& value) { blob(value.data(), value.size()); }
+};
+
+// Reads past the end clear `ok` and return empty values
+class WireReader {
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset = 0;
+    
+public:
+    bool ok = true;
+    
+    WireReader(const uint8_t* data, size_t size) : data(data), size(size) {}
+    explicit WireReader(const std::vector<uint8_t>& bytes) : WireReader(bytes.data(), bytes.size()) {}
+    
+    uint32_t u32() {
+        uint32_t value = 0;
+        if (offset + sizeof(value) > size) { ok = false; return 0; }
+        std::memcpy(&value, data + offset, sizeof(value));
+        offset += sizeof(value);
+        return value;
+    }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    bool atEnd() const { return offset >= size; }
+    std::vector<uint8_t> vec() {
+        uint32_t length = u32();
+        if (!ok || offset + length > size) { ok = false; return {}; }
+        std::vector<uint8_t> value(data + offset, data + offset + length);
+        offset += length;
+        return value;
+    }
+    std::string str() {
+        auto raw = vec();
+        return std::string(raw.begin(), raw.end());
+    }
+};
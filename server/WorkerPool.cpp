@@ -0,0 +1,320 @@
+#include "WorkerPool.h"
+#include "../utils/Logger.h"
+#include "../utils/CpuAffinity.h"
+#include <exception>
+#include <chrono>
+
+namespace {
+    // Pool and worker index owning the current thread (null outside any pool)
+    thread_local const WorkerPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+    
+    // Tasks a serial executor runs before yielding its worker to others
+    const size_t SERIAL_BATCH_SIZE = 64;
+}
+
+WorkerPool::WorkerPool(size_t threadCount, bool perCore)
+    : perCore(perCore), stopping(false), joined(false), pendingTasks(0), outstandingTasks(0), nextQueue(0) {
+    if (threadCount == 0) {
+        threadCount = std::max(2u, std::thread::hardware_concurrency());
+    }
+    
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+        if (perCore) {
+            inboxes.push_back(std::make_unique<Inbox>());
+        }
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        if (perCore) {
+            workers.emplace_back(&WorkerPool::perCoreLoop, this, i);
+        } else {
+            workers.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    shutdown();
+}
+
+void WorkerPool::post(Task task) {
+    postTo(ANY_WORKER, std::move(task));
+}
+
+void WorkerPool::postTo(size_t worker, Task task) {
+    if (joined) {
+        task();
+        return;
+    }
+    
+    // Workers keep their own follow-up work local; everyone else round-robins
+    bool onWorker = currentPool == this;
+    size_t index;
+    if (worker != ANY_WORKER) {
+        index = worker % queues.size();
+    } else {
+        index = onWorker ? currentWorker : nextQueue++ % queues.size();
+    }
+    
+    // Count it before it's visible to a worker, which may run it and
+    // decrement straight away
+    outstandingTasks++;
+    pendingTasks++;
+    
+    if (perCore) {
+        Inbox& inbox = *inboxes[index];
+        if (!onWorker || index != currentWorker) {
+            inbox.postedFromElsewhere.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto* node = new InboxNode();
+        node->task = std::move(task);
+        inbox.push(node);
+        inbox.signal.fetch_add(1, std::memory_order_release);
+        inbox.signal.notify_one();
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeup.notify_one();
+    }
+    
+    // Lost the race with shutdown(): nobody is left to run it
+    if (joined) {
+        runLeftovers();
+    }
+}
+
+void WorkerPool::runLeftovers() {
+    Task task;
+    for (size_t i = 0; i < queues.size(); ++i) {
+        while (popLocal(i, task)) {
+            pendingTasks--;
+            task();
+            outstandingTasks--;
+        }
+    }
+    
+    // Inboxes have a single consumer; late posters may race each other here
+    std::lock_guard<std::mutex> lock(leftoverMutex);
+    for (auto& inbox : inboxes) {
+        while (InboxNode* node = inbox->pop()) {
+            pendingTasks--;
+            node->task();
+            delete node;
+            outstandingTasks--;
+        }
+    }
+}
+
+void WorkerPool::runTask(Task& task, size_t index) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        Logger::error("Worker task failed: " + std::string(e.what()));
+    }
+    if (perCore) {
+        inboxes[index]->tasksRun.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void WorkerPool::Inbox::push(InboxNode* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    InboxNode* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+WorkerPool::InboxNode* WorkerPool::Inbox::pop() {
+    InboxNode* first = tail;
+    InboxNode* next = first->next.load(std::memory_order_acquire);
+    if (first == &stub) {
+        if (!next) return nullptr;
+        tail = next;
+        first = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        tail = next;
+        return first;
+    }
+    
+    // `first` is the newest node. A producer that has swapped the head but
+    // not linked it yet makes the queue look empty until it finishes.
+    if (first != head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    
+    // Put the stub behind it so the last real node can be handed out
+    push(&stub);
+    next = first->next.load(std::memory_order_acquire);
+    if (next) {
+        tail = next;
+        return first;
+    }
+    return nullptr;
+}
+
+bool WorkerPool::popLocal(size_t index, Task& task) {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    if (queues[index]->tasks.empty()) return false;
+    
+    task = std::move(queues[index]->tasks.back());
+    queues[index]->tasks.pop_back();
+    return true;
+}
+
+bool WorkerPool::steal(size_t thief, Task& task) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        size_t victim = (thief + offset) % queues.size();
+        std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+        if (!queues[victim]->tasks.empty()) {
+            task = std::move(queues[victim]->tasks.front());
+            queues[victim]->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            // Still outstanding until it returns, so anything it posts is
+            // counted before it stops being
+            pendingTasks--;
+            runTask(task, index);
+            outstandingTasks--;
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (stopping && pendingTasks == 0) {
+            break;
+        }
+        wakeup.wait(lock, [this] { return stopping || pendingTasks > 0; });
+    }
+}
+
+void WorkerPool::perCoreLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    Inbox& inbox = *inboxes[index];
+    
+    while (true) {
+        // Read before popping: a push that lands after the pop bumps it, so
+        // the wait below returns at once
+        uint32_t seen = inbox.signal.load(std::memory_order_acquire);
+        if (InboxNode* node = inbox.pop()) {
+            pendingTasks--;
+            runTask(node->task, index);
+            delete node;
+            outstandingTasks--;
+            continue;
+        }
+        
+        // Whatever other workers post after this runs in shutdown()
+        if (stopping) {
+            break;
+        }
+        inbox.signal.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void WorkerPool::pinWorkers(const std::vector<int>& cpus, size_t offset) {
+    if (cpus.empty()) return;
+    
+    for (size_t i = 0; i < workers.size(); ++i) {
+        CpuAffinity::pin(workers[i], cpus[(offset + i) % cpus.size()]);
+    }
+}
+
+WorkerPool::WorkerStats WorkerPool::getWorkerStats(size_t worker) const {
+    WorkerStats stats{0, 0};
+    if (worker < inboxes.size()) {
+        stats.tasksRun = inboxes[worker]->tasksRun.load(std::memory_order_relaxed);
+        stats.postedFromElsewhere = inboxes[worker]->postedFromElsewhere.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void WorkerPool::waitIdle() {
+    // One counter: a task's follow-ups are counted before the task itself
+    // finishes, so it never reads zero while work remains
+    while (outstandingTasks > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void WorkerPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (stopping) return;
+        stopping = true;
+        wakeup.notify_all();
+    }
+    for (auto& inbox : inboxes) {
+        inbox->signal.fetch_add(1, std::memory_order_release);
+        inbox->signal.notify_one();
+    }
+    
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    
+    joined = true;
+    runLeftovers();
+}
+
+SerialExecutor::SerialExecutor(WorkerPool& pool, size_t home) : pool(pool), home(home), scheduled(false) {
+}
+
+void SerialExecutor::post(WorkerPool::Task task) {
+    bool needsSchedule = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        tasks.push_back(std::move(task));
+        if (!scheduled) {
+            scheduled = true;
+            needsSchedule = true;
+        }
+    }
+    
+    if (needsSchedule) {
+        auto self = shared_from_this();
+        pool.postTo(home, [self] { self->drain(); });
+    }
+}
+
+void SerialExecutor::drain() {
+    for (size_t executed = 0; executed < SERIAL_BATCH_SIZE; ++executed) {
+        WorkerPool::Task task;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (tasks.empty()) {
+                scheduled = false;
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        
+        try {
+            task();
+        } catch (const std::exception& e) {
+            Logger::error("Serial task failed: " + std::string(e.what()));
+        }
+    }
+    
+    // Still busy: requeue behind other work so one hot world can't starve the rest
+    auto self = shared_from_this();
+    pool.postTo(home, [self] { self->drain(); });
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+// Work-stealing thread pool for game logic.
+// Each worker owns a deque: it pops its newest task first and, when empty,
+// steals the oldest task from another worker. Tasks posted from outside the
+// pool are spread round-robin across the worker deques.
+//
+// In per-core mode workers never steal. Each has a lock-free inbox that any
+// thread may push to, and tasks posted for a worker only ever run on it, so
+// state homed on one worker stays in that core's cache.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+    
+    // No home worker: any worker may run the task
+    static const size_t ANY_WORKER = SIZE_MAX;
+    
+    struct WorkerStats {
+        uint64_t tasksRun;
+        uint64_t postedFromElsewhere;   // Pushed by another worker or thread
+    };
+    
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    // Multi-producer, single-consumer linked queue (Vyukov): producers swap
+    // themselves in as the head, only the owning worker walks the tail
+    struct InboxNode {
+        std::atomic<InboxNode*> next{nullptr};
+        Task task;
+    };
+    
+    struct alignas(64) Inbox {
+        std::atomic<InboxNode*> head;
+        InboxNode* tail;
+        InboxNode stub;
+        std::atomic<uint32_t> signal{0};    // Bumped on every push; the worker sleeps on it
+        std::atomic<uint64_t> tasksRun{0};
+        std::atomic<uint64_t> postedFromElsewhere{0};
+        
+        Inbox() : head(&stub), tail(&stub) {}
+        void push(InboxNode* node);
+        InboxNode* pop();
+    };
+    
+    bool perCore;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::unique_ptr<Inbox>> inboxes;
+    std::mutex leftoverMutex;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+    std::atomic<bool> joined;
+    std::atomic<size_t> pendingTasks;       // Queued, not yet picked up; wakes idle workers
+    std::atomic<size_t> outstandingTasks;   // Posted and not yet finished; what waitIdle() waits on
+    std::atomic<size_t> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+    
+    void workerLoop(size_t index);
+    void perCoreLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    void runLeftovers();
+    void runTask(Task& task, size_t index);
+    
+public:
+    // Per-core mode needs an explicit thread count, one per core
+    explicit WorkerPool(size_t threadCount = 0, bool perCore = false);
+    ~WorkerPool();
+    
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    
+    void post(Task task);
+    
+    // Queues on the given worker (ANY_WORKER behaves like post()). A
+    // work-stealing pool may still hand the task to an idle worker.
+    void postTo(size_t worker, Task task);
+    
+    // Pins worker i to cpus[(offset + i) % cpus.size()]; empty leaves them be
+    void pinWorkers(const std::vector<int>& cpus, size_t offset);
+    
+    // Blocks until no task is queued or running (tasks may still be posted
+    // afterwards; callers stop the producers first)
+    void waitIdle();
+    
+    // Runs every queued task, then joins the workers. Tasks posted after
+    // shutdown run inline on the posting thread.
+    void shutdown();
+    
+    size_t getThreadCount() const { return workers.size(); }
+    bool isPerCore() const { return perCore; }
+    
+    // Per-core mode only
+    WorkerStats getWorkerStats(size_t worker) const;
+};
+
+// Runs posted tasks one at a time, in order, on the shared pool.
+// State owned by a serial executor (e.g. a world) needs no locks as long as
+// it is only touched from tasks posted to that executor.
+// An executor with a home worker schedules itself there.
+class SerialExecutor : public std::enable_shared_from_this<SerialExecutor> {
+private:
+    WorkerPool& pool;
+    std::atomic<size_t> home;
+    std::mutex queueMutex;
+    std::deque<WorkerPool::Task> tasks;
+    bool scheduled;
+    
+    void drain();
+    
+public:
+    explicit SerialExecutor(WorkerPool& pool, size_t home = WorkerPool::ANY_WORKER);
+    
+    void post(WorkerPool::Task task);
+    
+    // Takes effect from the next batch; tasks still run in order
+    void setHome(size_t worker) { home = worker; }
+    size_t getHome() const { return home; }
+};
@@ -0,0 +1,58 @@
+#include "World.h"
+#include "Client.h"
+#include "../utils/Trace.h"
+#include <algorithm>
+
+World::World(const std::string& name, WorkerPool& pool, float proximityRadius, size_t home)
+    : name(name), executor(std::make_shared<SerialExecutor>(pool, home)),
+      proximityRadius(proximityRadius), grid(proximityRadius) {
+}
+
+void World::addPlayer(std::shared_ptr<Client> client, float x, float y) {
+    if (std::find(players.begin(), players.end(), client) == players.end()) {
+        players.push_back(client);
+    }
+    movePlayer(client, x, y);
+}
+
+void World::removePlayer(std::shared_ptr<Client> client) {
+    grid.remove(client.get());
+    players.erase(std::remove(players.begin(), players.end(), client), players.end());
+}
+
+void World::movePlayer(const std::shared_ptr<Client>& client, float x, float y) {
+    grid.update(client.get(), x, y);
+    client->setPosition(static_cast<int>(x), static_cast<int>(y));
+}
+
+void World::broadcast(const std::vector<uint8_t>& packet, std::shared_ptr<Client> excludeClient) {
+    TRACE_SCOPE("World::broadcast");
+    for (auto& player : players) {
+        if (player != excludeClient && player->isConnected()) {
+            player->sendPacket(packet);
+        }
+    }
+}
+
+void World::broadcastNearby(const std::vector<uint8_t>& packet, float x, float y,
+                            std::shared_ptr<Client> excludeClient, bool unreliable) {
+    auto deliver = [&](Client* player) {
+        if (player == excludeClient.get() || !player->isConnected()) return;
+        if (unreliable) {
+            player->sendUnreliable(packet);
+        } else {
+            player->sendPacket(packet);
+        }
+    };
+    
+    if (proximityRadius <= 0.0f) {
+        TRACE_SCOPE("World::broadcast");
+        for (auto& player : players) {
+            deliver(player.get());
+        }
+        return;
+    }
+    
+    TRACE_SCOPE("World::broadcastNearby");
+    grid.forEachWithin(x, y, proximityRadius, deliver);
+}
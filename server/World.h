@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include "WorkerPool.h"
+#include "SpatialGrid.h"
+
+class Client;
+
+// A world and the players in it. Every world is pinned to its own serial
+// executor: player lists and other world state are only touched from tasks
+// posted through post(), so they need no locking.
+class World {
+private:
+    std::string name;
+    std::shared_ptr<SerialExecutor> executor;
+    std::vector<std::shared_ptr<Client>> players;
+    
+    // Player positions for proximity-limited delivery; 0 radius disables it
+    float proximityRadius;
+    SpatialGrid grid;
+    
+public:
+    // Standard world size in tiles; positions are in pixels, 32 per tile
+    static const int WIDTH_TILES = 100;
+    static const int HEIGHT_TILES = 60;
+    static constexpr float TILE_PIXELS = 32.0f;
+    
+    // False for positions off the map, including NaN and infinities
+    static bool containsPosition(float x, float y) {
+        return std::isfinite(x) && std::isfinite(y) &&
+               x >= 0.0f && x <= WIDTH_TILES * TILE_PIXELS && y >= 0.0f && y <= HEIGHT_TILES * TILE_PIXELS;
+    }
+    
+    World(const std::string& name, WorkerPool& pool, float proximityRadius, size_t home = WorkerPool::ANY_WORKER);
+    
+    const std::string& getName() const { return name; }
+    size_t getHome() const { return executor->getHome(); }
+    void post(WorkerPool::Task task) { executor->post(std::move(task)); }
+    
+    // Executor-only
+    void addPlayer(std::shared_ptr<Client> client, float x, float y);
+    void removePlayer(std::shared_ptr<Client> client);
+    void movePlayer(const std::shared_ptr<Client>& client, float x, float y);
+    void broadcast(const std::vector<uint8_t>& packet, std::shared_ptr<Client> excludeClient = nullptr);
+    
+    // Delivers only to players within the proximity radius of (x, y);
+    // superseded frames such as movement may go out unreliably
+    void broadcastNearby(const std::vector<uint8_t>& packet, float x, float y,
+                         std::shared_ptr<Client> excludeClient = nullptr, bool unreliable = false);
+    size_t getPlayerCount() const { return players.size(); }
+};
@@ -50,17 +50,57 @@ if [ ! -f "config.ini" ]; then
     cat > config.ini << EOF
 [Server]
 port=17091
+public_address=127.0.0.1
+; Players; further logins wait in the login queue. 0 = unlimited
 max_clients=100
+; Open connections per client address, 0 = unlimited
+max_connections_per_ip=10
+; Logins that may wait for a player slot; beyond that the server is full
+login_queue_size=200
 log_file=server.log
 enable_file_logging=true
+; debug, info, warning or error
+log_level=info
+; Housekeeping passes per second (config reload, trace dumps)
+tick_rate=1
+
+[Network]
+; Game-logic threads, 0 = one per core
+worker_threads=0
+; Shard-per-core: this many cores, each with its own event loop, connections
+; and worlds (Linux; replaces worker_threads; no hot restart). 0 = off
+core_shards=0
+; Pin threads to CPUs: none, auto (every CPU available) or a list like 0-3,8
+thread_placement=none
+tcp_nodelay=true
+; Socket buffer sizes in bytes, 0 = OS default
+send_buffer_size=0
+receive_buffer_size=0
+max_packet_size=1048576
+max_outbound_bytes=4194304
+receive_chunk_size=16384
+; Bytes one session may hold (buffers, queues, its arena) before it is
+; disconnected, 0 = no cap. SIGUSR2 logs what each session holds.
+max_session_memory=0
+; io_uring receive buffer pool (count must be a power of two)
+ring_buffer_count=256
+ring_buffer_size=16384
+; ENet-compatible UDP on the same port (the real game client's transport)
+enable_udp=true
+udp_checksum=true
 
 [Game]
 server_name=Growtopia Private Server
 motd=Welcome to our private server!
+; Worlds open at once; a world closes when its last player leaves. 0 = no cap
 max_worlds=1000
+; Tiles within which movement and effects are delivered, 0 = whole world
+proximity_radius=32
+items_file=items.dat
 
 [Security]
 enable_authentication=false
+accounts_file=accounts.db
 admin_password=admin123
 EOF
 fi
@@ -5,8 +5,11 @@ This script tests if your server is responding to basic connections
 """
 
 import socket
+import struct
+import random
 import time
 import sys
+import zlib
 
 def test_connection(host, port):
     print(f"🔍 Testing connection to {host}:{port}")
@@ -54,6 +57,33 @@ def test_connection(host, port):
     except Exception as e:
         print(f"   ❌ Connection test failed: {e}")
     
+    # Test the ENet handshake the real game client performs over UDP
+    print("4. Testing UDP (ENet) handshake...")
+    try:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.settimeout(5)
+        
+        # CONNECT: peer ID 0xFFF, send time, CRC32 seeded with zero, then the
+        # command asking for 2 channels with a random connect ID
+        connect_id = struct.pack(">I", random.getrandbits(32))
+        header = struct.pack(">HH", 0x8FFF, 0)
+        command = struct.pack(">BBHHBBIIIIIIII", 0x82, 0xFF, 1, 0, 0xFF, 0xFF,
+                              1400, 32768, 2, 0, 0, 5000, 2, 2) + connect_id + bytes(4)
+        checksum = zlib.crc32(header + bytes(4) + command) & 0xFFFFFFFF
+        sock.sendto(header + struct.pack(">I", checksum) + command, (host, port))
+        
+        response, _ = sock.recvfrom(2048)
+        # VERIFY_CONNECT follows the 8-byte header (possibly after an ACK)
+        if any(response[i] & 0x0F == 3 for i in (8, 16) if i < len(response)):
+            print("   ✅ Server completed the ENet handshake!")
+        else:
+            print(f"   ⚠️  Unexpected UDP response: {response[:32]}")
+        sock.close()
+    except socket.timeout:
+        print("   ⚠️  No UDP response (is enable_udp on and the UDP port open?)")
+    except Exception as e:
+        print(f"   ❌ UDP test failed: {e}")
+    
     print("\n" + "=" * 50)
 
 def main():
@@ -0,0 +1,155 @@
+// Builds the binary item database the server maps at startup from a text
+// item list, or prints a summary of an existing database.
+//
+// Input lines: id|name|action|collision|rarity|breakHits|growSeconds
+// with action one of fist, wrench, foreground, background, seed, clothing,
+// consumable. Blank lines and lines starting with '#' are ignored.
+
+#include "../server/ItemDatabase.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <cstring>
+#include <cstdint>
+
+static bool parseAction(const std::string& name, ItemAction& action) {
+    static const struct { const char* name; ItemAction action; } actions[] = {
+        {"fist", ItemAction::FIST},
+        {"wrench", ItemAction::WRENCH},
+        {"foreground", ItemAction::FOREGROUND},
+        {"background", ItemAction::BACKGROUND},
+        {"seed", ItemAction::SEED},
+        {"clothing", ItemAction::CLOTHING},
+        {"consumable", ItemAction::CONSUMABLE},
+    };
+    for (const auto& entry : actions) {
+        if (name == entry.name) {
+            action = entry.action;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Digits only: stoul alone would take "-1" and wrap it to the maximum
+static bool parseNumber(const std::string& text, unsigned long max, unsigned long& value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        value = std::stoul(text);
+    } catch (...) {
+        return false;
+    }
+    return value <= max;
+}
+
+static bool parseLine(const std::string& line, ItemInfo& item) {
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, '|')) {
+        fields.push_back(field);
+    }
+    if (fields.size() != 7) {
+        return false;
+    }
+
+    std::memset(static_cast<void*>(&item), 0, sizeof(item));
+    unsigned long id, collision, rarity, breakHits, growSeconds;
+    if (!parseNumber(fields[0], UINT32_MAX, id) || !parseNumber(fields[3], UINT8_MAX, collision) ||
+        !parseNumber(fields[4], UINT16_MAX, rarity) || !parseNumber(fields[5], UINT16_MAX, breakHits) ||
+        !parseNumber(fields[6], UINT32_MAX, growSeconds)) {
+        return false;
+    }
+    item.id = static_cast<uint32_t>(id);
+    item.collision = static_cast<uint8_t>(collision);
+    item.rarity = static_cast<uint16_t>(rarity);
+    item.breakHits = static_cast<uint16_t>(breakHits);
+    item.growSeconds = static_cast<uint32_t>(growSeconds);
+    if (!parseAction(fields[2], item.action)) {
+        return false;
+    }
+    item.maxStack = 200;
+    std::strncpy(item.name, fields[1].c_str(), sizeof(item.name) - 1);
+    return true;
+}
+
+static int build(const std::string& inputPath, const std::string& outputPath) {
+    std::ifstream input(inputPath);
+    if (!input.is_open()) {
+        std::cerr << "Cannot open " << inputPath << std::endl;
+        return 1;
+    }
+
+    std::vector<ItemInfo> items;
+    std::unordered_set<uint32_t> seen;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        ItemInfo item;
+        if (!parseLine(line, item)) {
+            std::cerr << inputPath << ":" << lineNumber << ": malformed item line" << std::endl;
+            return 1;
+        }
+        if (item.id > ItemDatabase::MAX_ITEM_ID) {
+            std::cerr << inputPath << ":" << lineNumber << ": item ID " << item.id
+                      << " is above the maximum of " << ItemDatabase::MAX_ITEM_ID << std::endl;
+            return 1;
+        }
+        if (!seen.insert(item.id).second) {
+            std::cerr << inputPath << ":" << lineNumber << ": duplicate item ID " << item.id << std::endl;
+            return 1;
+        }
+        items.push_back(item);
+    }
+
+    if (!ItemDatabase::write(outputPath, items)) {
+        return 1;
+    }
+
+    ItemDatabase database;
+    if (!database.load(outputPath)) {
+        return 1;
+    }
+    std::cout << "Wrote " << items.size() << " items (IDs 0-" << database.size() - 1 << ") to " << outputPath
+              << ", hash " << database.getHash() << std::endl;
+    return 0;
+}
+
+static int info(const std::string& path) {
+    ItemDatabase database;
+    if (!database.load(path)) {
+        return 1;
+    }
+
+    uint32_t used = 0;
+    for (uint32_t id = 0; id < database.size(); ++id) {
+        if (database.isValid(id)) ++used;
+    }
+    std::cout << path << ": " << used << " items in " << database.size() << " IDs, hash " << database.getHash() << std::endl;
+    return 0;
+}
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " <items.txt> <items.dat>\n"
+              << "       " << program << " --info <items.dat>" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--info") {
+        return info(argv[2]);
+    }
+    if (argc == 3 && argv[1][0] != '-') {
+        return build(argv[1], argv[2]);
+    }
+    printUsage(argv[0]);
+    return (argc == 2 && std::string(argv[1]) == "--help") ? 0 : 1;
+}
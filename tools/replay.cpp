@@ -0,0 +1,279 @@
+// Replays a capture recorded with `growtopia_server --capture <file>` against a
+// running server, one TCP connection per captured connection ID.
+
+#include "../server/TrafficCapture.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <csignal>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    typedef SOCKET socket_t;
+    #define CLOSE_SOCKET closesocket
+    #define POLL_SOCKETS WSAPoll
+#else
+    #include <sys/socket.h>
+    #include <poll.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    typedef int socket_t;
+    #define INVALID_SOCKET -1
+    #define CLOSE_SOCKET close
+    #define POLL_SOCKETS poll
+#endif
+
+struct ReplayOptions {
+    std::string host = "127.0.0.1";
+    int port = 17091;
+    double speed = 1.0; // 0 = as fast as possible
+    std::string captureFile;
+};
+
+class ReplaySession {
+private:
+    ReplayOptions options;
+    std::unordered_map<uint32_t, socket_t> connections;
+    std::mutex connectionsMutex;
+    std::atomic<bool> draining;
+    std::atomic<uint64_t> bytesReceived;
+    std::atomic<uint64_t> closedByServer;
+    
+    uint64_t framesSent = 0;
+    uint64_t bytesSent = 0;
+    uint64_t failedConnects = 0;
+    double maxLagMs = 0.0;
+    
+    socket_t openConnection() {
+        socket_t sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (sock == INVALID_SOCKET) return INVALID_SOCKET;
+        
+        sockaddr_in serverAddr{};
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_port = htons(options.port);
+        inet_pton(AF_INET, options.host.c_str(), &serverAddr.sin_addr);
+        
+        if (::connect(sock, (sockaddr*)&serverAddr, sizeof(serverAddr)) != 0) {
+            CLOSE_SOCKET(sock);
+            return INVALID_SOCKET;
+        }
+        
+        int noDelay = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&noDelay, sizeof(noDelay));
+        return sock;
+    }
+    
+    bool sendAll(socket_t sock, const uint8_t* data, size_t length) {
+        size_t total = 0;
+        while (total < length) {
+            int sent = send(sock, (const char*)data + total, static_cast<int>(length - total), 0);
+            if (sent <= 0) return false;
+            total += sent;
+        }
+        return true;
+    }
+    
+    // Reads and discards server responses so the server never blocks on us.
+    // poll, not select: captures can hold more connections than FD_SETSIZE.
+    void drainResponses() {
+        std::vector<char> buffer(64 * 1024);
+        std::vector<pollfd> waiters;
+        std::vector<uint32_t> waiterIDs;
+        while (draining) {
+            waiters.clear();
+            waiterIDs.clear();
+            {
+                std::lock_guard<std::mutex> lock(connectionsMutex);
+                for (auto& entry : connections) {
+                    waiters.push_back(pollfd{entry.second, POLLIN, 0});
+                    waiterIDs.push_back(entry.first);
+                }
+            }
+            if (waiters.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                continue;
+            }
+            
+            if (POLL_SOCKETS(waiters.data(), static_cast<unsigned long>(waiters.size()), 20) <= 0) {
+                continue;
+            }
+            
+            // Sockets closed meanwhile are no longer in the map; skip them
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (size_t i = 0; i < waiters.size(); ++i) {
+                if (!(waiters[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL))) continue;
+                auto it = connections.find(waiterIDs[i]);
+                if (it == connections.end() || it->second != waiters[i].fd) continue;
+                
+                int received = recv(waiters[i].fd, buffer.data(), static_cast<int>(buffer.size()), 0);
+                if (received > 0) {
+                    bytesReceived += received;
+                    continue;
+                }
+                
+                // Closed by the server: drop it now, or poll() keeps
+                // reporting it until its DISCONNECT record comes up
+                CLOSE_SOCKET(it->second);
+                connections.erase(it);
+                ++closedByServer;
+            }
+        }
+    }
+    
+    void closeConnection(uint32_t connectionID) {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        auto it = connections.find(connectionID);
+        if (it != connections.end()) {
+            CLOSE_SOCKET(it->second);
+            connections.erase(it);
+        }
+    }
+    
+public:
+    explicit ReplaySession(const ReplayOptions& options) : options(options), draining(true), bytesReceived(0), closedByServer(0) {}
+    
+    int run() {
+        CaptureReader reader(options.captureFile);
+        if (!reader.isValid()) {
+            std::cerr << "Not a valid capture file: " << options.captureFile << std::endl;
+            return 1;
+        }
+        
+        std::thread drainThread(&ReplaySession::drainResponses, this);
+        auto replayStart = std::chrono::steady_clock::now();
+        
+        CaptureRecord record;
+        while (reader.next(record)) {
+            if (options.speed > 0) {
+                auto target = replayStart + std::chrono::microseconds(
+                    static_cast<int64_t>(record.timestampUs / options.speed));
+                auto now = std::chrono::steady_clock::now();
+                if (target > now) {
+                    std::this_thread::sleep_until(target);
+                } else {
+                    double lagMs = std::chrono::duration<double, std::milli>(now - target).count();
+                    maxLagMs = std::max(maxLagMs, lagMs);
+                }
+            }
+            
+            switch (record.kind) {
+                case CaptureRecordKind::CONNECT: {
+                    socket_t sock = openConnection();
+                    if (sock == INVALID_SOCKET) {
+                        ++failedConnects;
+                        break;
+                    }
+                    std::lock_guard<std::mutex> lock(connectionsMutex);
+                    connections[record.connectionID] = sock;
+                    break;
+                }
+                case CaptureRecordKind::FRAME: {
+                    socket_t sock = INVALID_SOCKET;
+                    {
+                        std::lock_guard<std::mutex> lock(connectionsMutex);
+                        auto it = connections.find(record.connectionID);
+                        if (it != connections.end()) sock = it->second;
+                    }
+                    if (sock == INVALID_SOCKET) break;
+                    
+                    uint32_t length = static_cast<uint32_t>(record.payload.size());
+                    if (!sendAll(sock, reinterpret_cast<const uint8_t*>(&length), sizeof(length)) ||
+                        !sendAll(sock, record.payload.data(), record.payload.size())) {
+                        closeConnection(record.connectionID);
+                        break;
+                    }
+                    ++framesSent;
+                    bytesSent += sizeof(length) + record.payload.size();
+                    break;
+                }
+                case CaptureRecordKind::DISCONNECT:
+                    closeConnection(record.connectionID);
+                    break;
+            }
+        }
+        
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+        
+        // Give the server a moment to answer the last frames
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        draining = false;
+        drainThread.join();
+        
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (auto& entry : connections) {
+                CLOSE_SOCKET(entry.second);
+            }
+            connections.clear();
+        }
+        
+        std::cout << "frames_sent=" << framesSent
+                  << " bytes_sent=" << bytesSent
+                  << " bytes_received=" << bytesReceived
+                  << " failed_connects=" << failedConnects
+                  << " closed_by_server=" << closedByServer
+                  << " elapsed_s=" << elapsed
+                  << " frames_per_s=" << (elapsed > 0 ? framesSent / elapsed : 0.0)
+                  << " max_schedule_lag_ms=" << maxLagMs << std::endl;
+        return 0;
+    }
+};
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--host <addr>] [--port <port>] [--speed <N|max>] <capture file>\n"
+              << "  --speed 1    replay at recorded pace (default)\n"
+              << "  --speed 4    replay four times faster\n"
+              << "  --speed max  send every frame as fast as possible" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--host" && i + 1 < argc) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            options.port = std::stoi(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc) {
+            std::string speed = argv[++i];
+            options.speed = (speed == "max") ? 0.0 : std::stod(speed);
+        } else if (arg[0] != '-' && options.captureFile.empty()) {
+            options.captureFile = arg;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    
+    if (options.captureFile.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#else
+    // The server may close a replayed connection while we're still sending
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    
+    ReplaySession session(options);
+    int result = session.run();
+    
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return result;
+}
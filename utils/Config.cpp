@@ -0,0 +1,80 @@
+#include "Config.h"
+#include "Logger.h"
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+
+static std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+bool Config::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    values.clear();
+    std::string section;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') {
+            continue;
+        }
+
+        if (line.front() == '[' && line.back() == ']') {
+            section = trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            Logger::warning(path + ":" + std::to_string(lineNumber) + ": ignoring line without '='");
+            continue;
+        }
+        values[section + "." + trim(line.substr(0, equals))] = trim(line.substr(equals + 1));
+    }
+    return true;
+}
+
+bool Config::has(const std::string& section, const std::string& key) const {
+    return values.count(section + "." + key) != 0;
+}
+
+std::string Config::getString(const std::string& section, const std::string& key, const std::string& fallback) const {
+    auto it = values.find(section + "." + key);
+    return it != values.end() ? it->second : fallback;
+}
+
+int Config::getInt(const std::string& section, const std::string& key, int fallback) const {
+    auto it = values.find(section + "." + key);
+    if (it == values.end()) return fallback;
+
+    try {
+        size_t used = 0;
+        int value = std::stoi(it->second, &used);
+        if (used == it->second.size()) return value;
+    } catch (...) {
+    }
+    Logger::warning("Config " + section + "." + key + " is not a number: " + it->second);
+    return fallback;
+}
+
+bool Config::getBool(const std::string& section, const std::string& key, bool fallback) const {
+    auto it = values.find(section + "." + key);
+    if (it == values.end()) return fallback;
+
+    std::string value = it->second;
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (value == "true" || value == "1" || value == "yes" || value == "on") return true;
+    if (value == "false" || value == "0" || value == "no" || value == "off") return false;
+
+    Logger::warning("Config " + section + "." + key + " is not a boolean: " + it->second);
+    return fallback;
+}
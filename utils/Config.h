@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <map>
+
+// Reader for config.ini: `[Section]` headers, `key=value` lines and `;`/`#`
+// comments. Lookups are by section and key; missing entries return the
+// caller's default.
+class Config {
+private:
+    std::map<std::string, std::string> values; // "Section.key" -> value
+
+public:
+    // False if the file can't be opened (the config stays empty)
+    bool load(const std::string& path);
+
+    bool has(const std::string& section, const std::string& key) const;
+    std::string getString(const std::string& section, const std::string& key, const std::string& fallback = "") const;
+    int getInt(const std::string& section, const std::string& key, int fallback) const;
+    bool getBool(const std::string& section, const std::string& key, bool fallback) const;
+};
@@ -0,0 +1,144 @@
+#include "CpuAffinity.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _WIN32
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    // Affinity masks are one machine word; processor groups are not handled
+    const int MAX_CPUS = static_cast<int>(sizeof(DWORD_PTR) * 8);
+#elif defined(__linux__)
+    const int MAX_CPUS = CPU_SETSIZE;
+#else
+    const int MAX_CPUS = 1024;
+#endif
+
+    bool parseNumber(const std::string& text, int& value) {
+        if (text.empty() || text.size() > 4 || text.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        value = std::atoi(text.c_str());
+        return value < MAX_CPUS;
+    }
+
+#ifdef _WIN32
+    bool applyMask(HANDLE thread, const std::vector<int>& cpus) {
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+        return SetThreadAffinityMask(thread, mask) != 0;
+    }
+#elif defined(__linux__)
+    bool applyMask(pthread_t thread, const std::vector<int>& cpus) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+    }
+#endif
+}
+
+std::vector<int> CpuAffinity::availableCpus() {
+    std::vector<int> cpus;
+#ifdef _WIN32
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+        for (int cpu = 0; cpu < MAX_CPUS; ++cpu) {
+            if (processMask & (DWORD_PTR(1) << cpu)) cpus.push_back(cpu);
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < MAX_CPUS; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+bool CpuAffinity::parse(const std::string& spec, std::vector<int>& cpus) {
+    cpus.clear();
+    if (spec.empty() || spec == "none") {
+        return true;
+    }
+    if (spec == "auto") {
+        cpus = availableCpus();
+        return true;
+    }
+
+    // Comma-separated CPUs and inclusive ranges, e.g. "0-3,8"
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(start, end - start);
+
+        size_t dash = item.find('-');
+        int first = 0;
+        int last = 0;
+        if (dash == std::string::npos) {
+            if (!parseNumber(item, first)) return false;
+            last = first;
+        } else if (!parseNumber(item.substr(0, dash), first) || !parseNumber(item.substr(dash + 1), last) || last < first) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (std::find(cpus.begin(), cpus.end(), cpu) == cpus.end()) {
+                cpus.push_back(cpu);
+            }
+        }
+        start = end + 1;
+    }
+    return !cpus.empty();
+}
+
+bool CpuAffinity::pin(std::thread& thread, int cpu) {
+    return pin(thread, std::vector<int>{cpu});
+}
+
+bool CpuAffinity::pin(std::thread& thread, const std::vector<int>& cpus) {
+    if (cpus.empty() || !thread.joinable()) return true;
+
+#ifdef _WIN32
+    bool pinned = applyMask(static_cast<HANDLE>(thread.native_handle()), cpus);
+#elif defined(__linux__)
+    bool pinned = applyMask(thread.native_handle(), cpus);
+#else
+    bool pinned = false;
+#endif
+    if (!pinned) {
+        Logger::warning("Failed to pin thread to CPU " + describe(cpus));
+    }
+    return pinned;
+}
+
+std::string CpuAffinity::describe(const std::vector<int>& cpus) {
+    if (cpus.empty()) return "none";
+
+    std::string text;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        if (i > 0) text += ",";
+        text += std::to_string(cpus[i]);
+    }
+    return text;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+
+// Thread placement. A placement is the list of CPUs threads are spread over:
+// "none" leaves scheduling to the OS, "auto" uses every CPU the process may
+// run on, and a list such as "0-3,8" names them explicitly.
+class CpuAffinity {
+public:
+    // CPUs this process may currently run on, in ascending order
+    static std::vector<int> availableCpus();
+
+    // Empty `cpus` means no pinning; false if the spec is malformed
+    static bool parse(const std::string& spec, std::vector<int>& cpus);
+
+    // Restricts a thread to one CPU, or to any CPU of a set. Threads started
+    // from a restricted thread inherit its set on Linux. False (and a warning)
+    // if the OS refuses, e.g. the CPU is offline or outside the cgroup.
+    static bool pin(std::thread& thread, int cpu);
+    static bool pin(std::thread& thread, const std::vector<int>& cpus);
+
+    static std::string describe(const std::vector<int>& cpus);
+};
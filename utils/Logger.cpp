@@ -3,6 +3,34 @@
 std::mutex Logger::logMutex;
 std::ofstream Logger::logFile;
 bool Logger::fileLoggingEnabled = false;
+std::atomic<int> Logger::minimumSeverity(0);
+
+int Logger::severity(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG:   return 0;
+        case LogLevel::INFO:    return 1;
+        case LogLevel::WARNING: return 2;
+        case LogLevel::ERROR:   return 3;
+    }
+    return 3;
+}
+
+void Logger::setLevel(LogLevel level) {
+    minimumSeverity.store(severity(level), std::memory_order_relaxed);
+}
+
+bool Logger::isEnabled(LogLevel level) {
+    return severity(level) >= minimumSeverity.load(std::memory_order_relaxed);
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    if (name == "debug") level = LogLevel::DEBUG;
+    else if (name == "info") level = LogLevel::INFO;
+    else if (name == "warning" || name == "warn") level = LogLevel::WARNING;
+    else if (name == "error") level = LogLevel::ERROR;
+    else return false;
+    return true;
+}
 
 void Logger::enableFileLogging(const std::string& filename) {
     std::lock_guard<std::mutex> lock(logMutex);
@@ -51,6 +79,10 @@ std::string Logger::levelToString(LogLevel level) {
 }
 
 void Logger::writeLog(LogLevel level, const std::string& message) {
+    if (!isEnabled(level)) {
+        return;
+    }
+    
     std::lock_guard<std::mutex> lock(logMutex);
     
     std::string timestamp = getCurrentTime();
@@ -94,4 +126,17 @@ void Logger::error(const std::string& message) {
 
 void Logger::debug(const std::string& message) {
     writeLog(LogLevel::DEBUG, message);
-}
\ No newline at end of file
+}
+
+std::string Logger::concat(std::initializer_list<std::string_view> parts) {
+    size_t length = 0;
+    for (std::string_view part : parts) {
+        length += part.size();
+    }
+    std::string message;
+    message.reserve(length);
+    for (std::string_view part : parts) {
+        message += part;
+    }
+    return message;
+}
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <initializer_list>
 #include <iostream>
 #include <fstream>
 #include <mutex>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
 
 enum class LogLevel {
     INFO,
@@ -20,7 +23,9 @@ private:
     static std::mutex logMutex;
     static std::ofstream logFile;
     static bool fileLoggingEnabled;
+    static std::atomic<int> minimumSeverity;
     
+    static int severity(LogLevel level);
     static std::string getCurrentTime();
     static std::string levelToString(LogLevel level);
     static void writeLog(LogLevel level, const std::string& message);
@@ -29,8 +34,19 @@ public:
     static void enableFileLogging(const std::string& filename);
     static void disableFileLogging();
     
+    // Messages below this level are dropped without being written. Callers
+    // build the message first, so hot paths test isEnabled() before
+    // formatting one.
+    static void setLevel(LogLevel level);
+    static bool isEnabled(LogLevel level);
+    static bool parseLevel(const std::string& name, LogLevel& level);
+    
     static void info(const std::string& message);
     static void warning(const std::string& message);
     static void error(const std::string& message);
     static void debug(const std::string& message);
+    
+    // Joins message parts in one allocation, so session strings held as
+    // views (Client::getIP, getPlayerName) go into the line without a copy
+    static std::string concat(std::initializer_list<std::string_view> parts);
 };
\ No newline at end of file
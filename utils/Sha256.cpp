@@ -0,0 +1,223 @@
+#include "Sha256.h"
+#include <cstring>
+
+namespace {
+    const uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    uint32_t rotr(uint32_t value, int bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
+}
+
+Sha256::Sha256() : bufferLength(0), totalLength(0) {
+    static const uint32_t INITIAL_STATE[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::memcpy(state, INITIAL_STATE, sizeof(state));
+}
+
+void Sha256::compress(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        uint32_t choice = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + choice + ROUND_CONSTANTS[i] + w[i];
+        uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + majority;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t length) {
+    totalLength += length;
+
+    if (bufferLength > 0) {
+        size_t take = BLOCK_SIZE - bufferLength < length ? BLOCK_SIZE - bufferLength : length;
+        std::memcpy(buffer + bufferLength, data, take);
+        bufferLength += take;
+        data += take;
+        length -= take;
+        if (bufferLength < BLOCK_SIZE) return;
+        compress(buffer);
+        bufferLength = 0;
+    }
+
+    while (length >= BLOCK_SIZE) {
+        compress(data);
+        data += BLOCK_SIZE;
+        length -= BLOCK_SIZE;
+    }
+
+    std::memcpy(buffer, data, length);
+    bufferLength = length;
+}
+
+Sha256::Digest Sha256::finish() {
+    uint64_t bitLength = totalLength * 8;
+
+    // 0x80, zero padding to 56 mod 64, then the big-endian bit length
+    uint8_t padding[BLOCK_SIZE + 8] = {0x80};
+    size_t paddingLength = bufferLength < 56 ? 56 - bufferLength : 120 - bufferLength;
+    update(padding, paddingLength);
+
+    uint8_t lengthBytes[8];
+    for (int i = 0; i < 8; ++i) {
+        lengthBytes[i] = static_cast<uint8_t>(bitLength >> (56 - i * 8));
+    }
+    update(lengthBytes, sizeof(lengthBytes));
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+Sha256::Digest Sha256::hash(const uint8_t* data, size_t length) {
+    Sha256 hasher;
+    hasher.update(data, length);
+    return hasher.finish();
+}
+
+Sha256::Digest Sha256::hmac(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length) {
+    uint8_t block[BLOCK_SIZE] = {0};
+    if (keyLength > BLOCK_SIZE) {
+        Digest hashedKey = hash(key, keyLength);
+        std::memcpy(block, hashedKey.data(), hashedKey.size());
+    } else {
+        std::memcpy(block, key, keyLength);
+    }
+
+    uint8_t innerPad[BLOCK_SIZE];
+    uint8_t outerPad[BLOCK_SIZE];
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        innerPad[i] = block[i] ^ 0x36;
+        outerPad[i] = block[i] ^ 0x5c;
+    }
+
+    Sha256 inner;
+    inner.update(innerPad, BLOCK_SIZE);
+    inner.update(data, length);
+    Digest innerDigest = inner.finish();
+
+    Sha256 outer;
+    outer.update(outerPad, BLOCK_SIZE);
+    outer.update(innerDigest.data(), innerDigest.size());
+    return outer.finish();
+}
+
+Sha256::Digest Sha256::pbkdf2(const std::string& password, const std::vector<uint8_t>& salt, uint32_t iterations) {
+    const uint8_t* key = reinterpret_cast<const uint8_t*>(password.data());
+    uint8_t block[BLOCK_SIZE] = {0};
+    if (password.size() > BLOCK_SIZE) {
+        Digest hashedKey = hash(key, password.size());
+        std::memcpy(block, hashedKey.data(), hashedKey.size());
+    } else {
+        std::memcpy(block, key, password.size());
+    }
+
+    // The padded key is the same every round: absorb it once and copy the
+    // hasher state, halving the compressions per iteration
+    uint8_t innerPad[BLOCK_SIZE];
+    uint8_t outerPad[BLOCK_SIZE];
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        innerPad[i] = block[i] ^ 0x36;
+        outerPad[i] = block[i] ^ 0x5c;
+    }
+    Sha256 innerBase;
+    innerBase.update(innerPad, BLOCK_SIZE);
+    Sha256 outerBase;
+    outerBase.update(outerPad, BLOCK_SIZE);
+
+    auto mac = [&](const uint8_t* data, size_t length) {
+        Sha256 inner = innerBase;
+        inner.update(data, length);
+        Digest innerDigest = inner.finish();
+        Sha256 outer = outerBase;
+        outer.update(innerDigest.data(), innerDigest.size());
+        return outer.finish();
+    };
+
+    // U1 = HMAC(password, salt || INT(1))
+    std::vector<uint8_t> first(salt);
+    first.insert(first.end(), {0, 0, 0, 1});
+    Digest u = mac(first.data(), first.size());
+    Digest result = u;
+
+    for (uint32_t i = 1; i < iterations; ++i) {
+        u = mac(u.data(), u.size());
+        for (size_t j = 0; j < result.size(); ++j) {
+            result[j] ^= u[j];
+        }
+    }
+    return result;
+}
+
+bool constantTimeEquals(const uint8_t* a, const uint8_t* b, size_t length) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < length; ++i) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+std::string toHex(const uint8_t* data, size_t length) {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; ++i) {
+        hex.push_back(DIGITS[data[i] >> 4]);
+        hex.push_back(DIGITS[data[i] & 0x0f]);
+    }
+    return hex;
+}
+
+bool fromHex(const std::string& hex, std::vector<uint8_t>& out) {
+    if (hex.size() % 2 != 0) return false;
+
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    out.clear();
+    out.reserve(hex.size() / 2);
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int high = nibble(hex[i]);
+        int low = nibble(hex[i + 1]);
+        if (high < 0 || low < 0) return false;
+        out.push_back(static_cast<uint8_t>((high << 4) | low));
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// SHA-256 (FIPS 180-4) plus the HMAC and PBKDF2 constructions built on it,
+// for password storage without an external crypto dependency.
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+    static const size_t BLOCK_SIZE = 64;
+
+private:
+    uint32_t state[8];
+    uint8_t buffer[BLOCK_SIZE];
+    size_t bufferLength;
+    uint64_t totalLength;
+
+    void compress(const uint8_t* block);
+
+public:
+    Sha256();
+
+    void update(const uint8_t* data, size_t length);
+    void update(const std::string& data) { update(reinterpret_cast<const uint8_t*>(data.data()), data.size()); }
+    Digest finish();
+
+    static Digest hash(const uint8_t* data, size_t length);
+    static Digest hash(const std::string& data) { return hash(reinterpret_cast<const uint8_t*>(data.data()), data.size()); }
+
+    static Digest hmac(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length);
+
+    // PBKDF2-HMAC-SHA256 (RFC 8018) with a single 32-byte output block
+    static Digest pbkdf2(const std::string& password, const std::vector<uint8_t>& salt, uint32_t iterations);
+};
+
+// Comparison whose running time doesn't depend on where the inputs differ
+bool constantTimeEquals(const uint8_t* a, const uint8_t* b, size_t length);
+
+std::string toHex(const uint8_t* data, size_t length);
+bool fromHex(const std::string& hex, std::vector<uint8_t>& out);
@@ -0,0 +1,175 @@
+#include "Trace.h"
+#include "Logger.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <chrono>
+#include <ctime>
+
+namespace {
+
+// Events recorded by one thread. Only the owning thread writes; the dumper
+// reads behind the published `written` counter.
+struct ThreadBuffer {
+    std::unique_ptr<TraceEvent[]> events;
+    size_t capacity;
+    std::atomic<uint64_t> written;
+    std::atomic<bool> retired;
+    uint32_t threadID;
+    
+    ThreadBuffer(size_t capacity, uint32_t threadID)
+        : events(new TraceEvent[capacity]), capacity(capacity), written(0), retired(false), threadID(threadID) {}
+};
+
+// Buffers of exited threads are kept for the next dump, up to this many
+const size_t MAX_RETIRED_BUFFERS = 64;
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+uint32_t nextThreadID = 1;
+
+struct ThreadBufferHandle {
+    std::shared_ptr<ThreadBuffer> buffer;
+    
+    ~ThreadBufferHandle() {
+        if (buffer) {
+            buffer->retired = true;
+        }
+    }
+};
+
+thread_local ThreadBufferHandle localBuffer;
+
+std::shared_ptr<ThreadBuffer> acquireBuffer(size_t capacity) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    
+    // Recycle the oldest retired buffer once too many have piled up
+    size_t retiredCount = 0;
+    for (auto& buffer : registry) {
+        if (buffer->retired) ++retiredCount;
+    }
+    if (retiredCount > MAX_RETIRED_BUFFERS) {
+        for (auto it = registry.begin(); it != registry.end(); ++it) {
+            if ((*it)->retired) {
+                registry.erase(it);
+                break;
+            }
+        }
+    }
+    
+    auto buffer = std::make_shared<ThreadBuffer>(capacity, nextThreadID++);
+    registry.push_back(buffer);
+    return buffer;
+}
+
+} // namespace
+
+std::atomic<bool> Trace::enabled(false);
+std::atomic<bool> Trace::dumpRequested(false);
+size_t Trace::bufferCapacity = 16384;
+
+void Trace::enable(size_t eventsPerThread) {
+    bufferCapacity = eventsPerThread > 0 ? eventsPerThread : 1;
+    enabled = true;
+    Logger::info("Tracing enabled (" + std::to_string(bufferCapacity) + " events per thread)");
+}
+
+void Trace::disable() {
+    enabled = false;
+}
+
+uint64_t Trace::nowUs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Trace::record(const char* name, uint64_t startUs, uint64_t durationUs, uint64_t id, char phase) {
+    ThreadBuffer* buffer = localBuffer.buffer.get();
+    if (!buffer) {
+        localBuffer.buffer = acquireBuffer(bufferCapacity);
+        buffer = localBuffer.buffer.get();
+    }
+    
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[index % buffer->capacity];
+    event.name = name;
+    event.startUs = startUs;
+    event.durationUs = durationUs;
+    event.id = id;
+    event.phase = phase;
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::dumpChromeJson(const std::string& filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        Logger::error("Failed to open trace file: " + filename);
+        return false;
+    }
+    
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry;
+    }
+    
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    size_t eventCount = 0;
+    std::vector<TraceEvent> snapshot;
+    
+    for (auto& buffer : buffers) {
+        uint64_t end = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = end > buffer->capacity ? end - buffer->capacity : 0;
+        
+        snapshot.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            snapshot.push_back(buffer->events[i % buffer->capacity]);
+        }
+        
+        // Discard slots the owner may have overwritten while we were copying,
+        // including slot `endAfter`, which it may be writing right now
+        uint64_t endAfter = buffer->written.load(std::memory_order_acquire);
+        uint64_t firstValid = endAfter + 1 > buffer->capacity ? endAfter + 1 - buffer->capacity : 0;
+        size_t skip = firstValid > begin ? static_cast<size_t>(firstValid - begin) : 0;
+        
+        out << (first ? "" : ",\n")
+            << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->threadID
+            << ",\"args\":{\"name\":\"thread-" << buffer->threadID << "\"}}";
+        first = false;
+        
+        for (size_t i = skip; i < snapshot.size(); ++i) {
+            const TraceEvent& event = snapshot[i];
+            out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.startUs << ",\"pid\":1,\"tid\":" << buffer->threadID;
+            if (event.phase == 'X') {
+                out << ",\"dur\":" << event.durationUs;
+                if (event.id != 0) {
+                    out << ",\"args\":{\"id\":" << event.id << "}";
+                }
+            } else {
+                out << ",\"cat\":\"flow\",\"id\":" << event.id;
+                if (event.phase == 'f') {
+                    out << ",\"bp\":\"e\"";
+                }
+            }
+            out << "}";
+            ++eventCount;
+        }
+    }
+    
+    out << "\n]}\n";
+    Logger::info("Wrote " + std::to_string(eventCount) + " trace events to " + filename);
+    return true;
+}
+
+void Trace::servicePendingDump() {
+    if (!dumpRequested.exchange(false)) return;
+    
+    if (!isEnabled()) {
+        Logger::warning("Trace dump requested but tracing is not enabled (start with --trace)");
+        return;
+    }
+    dumpChromeJson("trace_" + std::to_string(std::time(nullptr)) + ".json");
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Scoped span tracing for request lifecycles.
+//
+// Spans are appended to a fixed-size buffer owned by the recording thread, so
+// the hot path takes no locks. Buffers are dumped on demand as Chrome trace
+// JSON, which chrome://tracing and ui.perfetto.dev both open directly.
+//
+// Building with -DENABLE_TRACING=OFF compiles the macros out entirely; when
+// compiled in but not enabled at runtime a span costs one relaxed atomic load.
+
+struct TraceEvent {
+    const char* name;    // Must be a string literal
+    uint64_t startUs;
+    uint64_t durationUs;
+    uint64_t id;         // Connection ID or flow ID, 0 if unused
+    char phase;          // 'X' complete span, 's'/'f' flow start/finish
+};
+
+class Trace {
+private:
+    static std::atomic<bool> enabled;
+    static std::atomic<bool> dumpRequested;
+    static size_t bufferCapacity;
+    
+public:
+    static void enable(size_t eventsPerThread = 16384);
+    static void disable();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    
+    static uint64_t nowUs();
+    static void record(const char* name, uint64_t startUs, uint64_t durationUs, uint64_t id, char phase);
+    
+    // Links spans on different threads (e.g. socket read -> game logic)
+    static void flowStart(const char* name, uint64_t id) { record(name, nowUs(), 0, id, 's'); }
+    static void flowEnd(const char* name, uint64_t id) { record(name, nowUs(), 0, id, 'f'); }
+    
+    // Writes every thread's buffered events; safe to call while recording
+    static bool dumpChromeJson(const std::string& filename);
+    
+    // Dump requests from signal handlers are serviced from a normal thread
+    static void requestDump() { dumpRequested = true; }
+    static void servicePendingDump();
+};
+
+class TraceSpan {
+private:
+    const char* name;
+    uint64_t id;
+    uint64_t startUs;
+    
+public:
+    explicit TraceSpan(const char* name, uint64_t id = 0)
+        : name(name), id(id), startUs(Trace::isEnabled() ? Trace::nowUs() : 0) {}
+    
+    ~TraceSpan() {
+        if (startUs != 0 && Trace::isEnabled()) {
+            Trace::record(name, startUs, Trace::nowUs() - startUs, id, 'X');
+        }
+    }
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef GT_ENABLE_TRACING
+    #define TRACE_SCOPE(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+    #define TRACE_SCOPE_ID(name, id) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name, id)
+    #define TRACE_FLOW_START(name, id) do { if (Trace::isEnabled()) Trace::flowStart(name, id); } while (0)
+    #define TRACE_FLOW_END(name, id) do { if (Trace::isEnabled()) Trace::flowEnd(name, id); } while (0)
+#else
+    #define TRACE_SCOPE(name) ((void)0)
+    #define TRACE_SCOPE_ID(name, id) ((void)(id))
+    #define TRACE_FLOW_START(name, id) ((void)(id))
+    #define TRACE_FLOW_END(name, id) ((void)(id))
+#endif